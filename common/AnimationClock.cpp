@@ -0,0 +1,60 @@
+#include "AnimationClock.h"
+
+ClockAnimation::ClockAnimation(AnimationClock *clock)
+    : QAbstractAnimation(clock)
+    , m_clock(clock)
+{
+}
+
+void ClockAnimation::updateCurrentTime(int currentTime)
+{
+    m_clock->tick(currentTime);
+}
+
+AnimationClock *AnimationClock::instance()
+{
+    static AnimationClock *clock = new AnimationClock();
+    return clock;
+}
+
+AnimationClock::AnimationClock(QObject *parent)
+    : QObject(parent)
+    , m_animation(new ClockAnimation(this))
+    , m_tickCount(0)
+{
+}
+
+void AnimationClock::subscribe(AnimationSubscriber *subscriber)
+{
+    if (m_subscribers.contains(subscriber)) return;
+
+    m_subscribers.append(subscriber);
+    if (m_subscribers.size() == 1) {
+        m_animation->start();
+    }
+    emit activeSubscribersChanged();
+}
+
+void AnimationClock::unsubscribe(AnimationSubscriber *subscriber)
+{
+    if (!m_subscribers.removeOne(subscriber)) return;
+
+    if (m_subscribers.isEmpty()) {
+        m_animation->stop();
+    }
+    emit activeSubscribersChanged();
+}
+
+void AnimationClock::tick(int elapsed)
+{
+    ++m_tickCount;
+
+    // Подписчик может отписаться прямо во время тика (например, из
+    // обработчика смены кадра), поэтому идём по копии
+    const QList<AnimationSubscriber *> subscribers = m_subscribers;
+    for (AnimationSubscriber *subscriber : subscribers) {
+        if (m_subscribers.contains(subscriber)) {
+            subscriber->animationTick(elapsed);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef ANIMATIONCLOCK_H
+#define ANIMATIONCLOCK_H
+
+#include <QObject>
+#include <QAbstractAnimation>
+#include <QList>
+
+class AnimationClock;
+
+// Получатель тиков общих часов анимации
+class AnimationSubscriber
+{
+public:
+    virtual ~AnimationSubscriber() = default;
+    virtual void animationTick(int elapsed) = 0;
+};
+
+// Анимация без длительности, которую крутит драйвер анимаций окна
+// (в потоковом цикле рендера он синхронизирован с vsync)
+class ClockAnimation : public QAbstractAnimation
+{
+public:
+    explicit ClockAnimation(AnimationClock *clock);
+
+    int duration() const override { return -1; }
+
+protected:
+    void updateCurrentTime(int currentTime) override;
+
+private:
+    AnimationClock *m_clock;
+};
+
+// Единые часы для всех спрайтов. Работают, только пока есть хотя бы один
+// подписчик, поэтому без видимых анимаций приложение не просыпается
+class AnimationClock : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int activeSubscribers READ activeSubscribers NOTIFY activeSubscribersChanged)
+    Q_PROPERTY(bool running READ isRunning NOTIFY activeSubscribersChanged)
+
+public:
+    static AnimationClock *instance();
+
+    void subscribe(AnimationSubscriber *subscriber);
+    void unsubscribe(AnimationSubscriber *subscriber);
+
+    int elapsed() const { return m_animation->currentTime(); }
+    int activeSubscribers() const { return m_subscribers.size(); }
+    bool isRunning() const { return m_animation->state() == QAbstractAnimation::Running; }
+    // Разовое чтение, например из отладочного скрипта QML: значение меняется
+    // каждый кадр, поэтому это не свойство с уведомлением
+    Q_INVOKABLE qint64 tickCount() const { return m_tickCount; }
+
+signals:
+    void activeSubscribersChanged();
+
+private:
+    friend class ClockAnimation;
+
+    explicit AnimationClock(QObject *parent = nullptr);
+    void tick(int elapsed);
+
+    QList<AnimationSubscriber *> m_subscribers;
+    ClockAnimation *m_animation;
+    qint64 m_tickCount;
+};
+
+#endif // ANIMATIONCLOCK_H
@@ -0,0 +1,38 @@
+#include "AssetImageProvider.h"
+#include "ImageCache.h"
+
+AssetImageResponse::AssetImageResponse(const QString &asset, const QSize &requestedSize)
+    : m_asset(asset)
+    , m_requestedSize(requestedSize)
+{
+    setAutoDelete(false);
+}
+
+// Движок забирает фабрику себе, поэтому она создаётся на каждый ответ;
+// изображение уже в формате загрузки, текстура создаётся без конвертации
+QQuickTextureFactory *AssetImageResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+void AssetImageResponse::run()
+{
+    m_image = ImageCache::instance()->image(m_asset);
+    if (!m_image.isNull() && m_requestedSize.isValid()) {
+        m_image = m_image.scaled(m_requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                      .convertToFormat(ImageCache::UPLOAD_FORMAT);
+    }
+    emit finished();
+}
+
+AssetImageProvider::AssetImageProvider()
+{
+    m_pool.setMaxThreadCount(2);
+}
+
+QQuickImageResponse *AssetImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    auto *response = new AssetImageResponse(id, requestedSize);
+    m_pool.start(response);
+    return response;
+}
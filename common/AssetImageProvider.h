@@ -0,0 +1,39 @@
+#ifndef ASSETIMAGEPROVIDER_H
+#define ASSETIMAGEPROVIDER_H
+
+#include <QQuickAsyncImageProvider>
+#include <QQuickImageResponse>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QImage>
+
+class AssetImageResponse : public QQuickImageResponse, public QRunnable
+{
+public:
+    AssetImageResponse(const QString &asset, const QSize &requestedSize);
+
+    QQuickTextureFactory *textureFactory() const override;
+    void run() override;
+
+private:
+    QString m_asset;
+    QSize m_requestedSize;
+    QImage m_image;
+};
+
+// image://assets/<имя> — ресурсы из :/images, декодируются в пуле потоков
+// через общий ImageCache, поэтому переход между страницами не ждёт PNG.
+// Одна текстура на URL — забота QQuickPixmapCache; провайдер отдаёт
+// изображения, уже готовые к загрузке
+class AssetImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    AssetImageProvider();
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+private:
+    QThreadPool m_pool;
+};
+
+#endif // ASSETIMAGEPROVIDER_H
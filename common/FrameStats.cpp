@@ -0,0 +1,209 @@
+#include "FrameStats.h"
+#include <QScreen>
+#include <QVariantMap>
+#include <algorithm>
+
+FrameStats *FrameStats::instance()
+{
+    static FrameStats *stats = new FrameStats();
+    return stats;
+}
+
+FrameStats::FrameStats(QObject *parent)
+    : QObject(parent)
+    , m_enabled(false)
+    , m_publishTimer(new QTimer(this))
+    , m_renderStart(-1)
+    , m_renderEnd(-1)
+    , m_lastSwap(-1)
+    , m_vsyncNs(16666667)
+    , m_framesSincePublish(0)
+    , m_dropped(0)
+    , m_fps(0)
+    , m_p50(0)
+    , m_p95(0)
+    , m_p99(0)
+    , m_renderP95(0)
+    , m_swapP95(0)
+    , m_droppedFrames(0)
+{
+    m_clock.start();
+    m_publishTimer->setInterval(1000);
+    connect(m_publishTimer, &QTimer::timeout, this, &FrameStats::publish);
+}
+
+void FrameStats::attach(QQuickWindow *window)
+{
+    disconnectWindow();
+    m_window = window;
+    if (m_enabled) {
+        connectWindow();
+    }
+}
+
+void FrameStats::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) return;
+
+    m_enabled = enabled;
+    if (m_enabled) {
+        reset();
+        connectWindow();
+        m_publishTimer->start();
+    } else {
+        disconnectWindow();
+        m_publishTimer->stop();
+    }
+    emit enabledChanged();
+}
+
+void FrameStats::reset()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_intervals.clear();
+        m_renderTimes.clear();
+        m_swapTimes.clear();
+        m_renderStart = -1;
+        m_renderEnd = -1;
+        m_lastSwap = -1;
+        m_framesSincePublish = 0;
+        m_dropped = 0;
+    }
+    for (SignalCounter &counter : m_signalCounters) {
+        counter.lastTotal = counter.total;
+    }
+    publish();
+}
+
+int FrameStats::counterIndex(const QString &name)
+{
+    for (int i = 0; i < m_signalCounters.size(); ++i) {
+        if (m_signalCounters[i].name == name) return i;
+    }
+    SignalCounter counter;
+    counter.name = name;
+    m_signalCounters.append(counter);
+    return m_signalCounters.size() - 1;
+}
+
+void FrameStats::connectWindow()
+{
+    if (!m_window) return;
+
+    if (m_window->screen() && m_window->screen()->refreshRate() > 1) {
+        m_vsyncNs = qint64(1e9 / m_window->screen()->refreshRate());
+    }
+
+    // Все три сигнала приходят из потока рендера
+    m_windowConnections.append(connect(m_window, &QQuickWindow::beforeRendering,
+                                       this, &FrameStats::onBeforeRendering, Qt::DirectConnection));
+    m_windowConnections.append(connect(m_window, &QQuickWindow::afterRendering,
+                                       this, &FrameStats::onAfterRendering, Qt::DirectConnection));
+    m_windowConnections.append(connect(m_window, &QQuickWindow::frameSwapped,
+                                       this, &FrameStats::onFrameSwapped, Qt::DirectConnection));
+}
+
+void FrameStats::disconnectWindow()
+{
+    for (const QMetaObject::Connection &connection : std::as_const(m_windowConnections)) {
+        disconnect(connection);
+    }
+    m_windowConnections.clear();
+}
+
+void FrameStats::onBeforeRendering()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    QMutexLocker locker(&m_mutex);
+    m_renderStart = now;
+}
+
+void FrameStats::onAfterRendering()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    QMutexLocker locker(&m_mutex);
+    if (m_renderStart >= 0) {
+        m_renderTimes.append(now - m_renderStart);
+        m_renderStart = -1;
+        m_renderEnd = now;
+    }
+}
+
+void FrameStats::onFrameSwapped()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    QMutexLocker locker(&m_mutex);
+
+    if (m_renderEnd >= 0) {
+        m_swapTimes.append(now - m_renderEnd);
+        m_renderEnd = -1;
+    }
+
+    if (m_lastSwap >= 0) {
+        const qint64 interval = now - m_lastSwap;
+        if (interval < IDLE_GAP_NS) {
+            m_intervals.append(interval);
+            // Интервал в полтора периода vsync и больше — пропущенные кадры
+            if (interval * 2 > m_vsyncNs * 3) {
+                m_dropped += int((interval + m_vsyncNs / 2) / m_vsyncNs) - 1;
+            }
+        }
+    }
+    m_lastSwap = now;
+    ++m_framesSincePublish;
+}
+
+static double percentileMs(QList<qint64> &values, double fraction)
+{
+    if (values.isEmpty()) return 0;
+
+    const qsizetype index = qMin(values.size() - 1, qsizetype(values.size() * fraction));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values.at(index) / 1e6;
+}
+
+void FrameStats::publish()
+{
+    QList<qint64> intervals;
+    QList<qint64> renderTimes;
+    QList<qint64> swapTimes;
+    int frames = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_intervals.size() > HISTORY_SIZE) {
+            m_intervals.remove(0, m_intervals.size() - HISTORY_SIZE);
+        }
+        if (m_renderTimes.size() > HISTORY_SIZE) {
+            m_renderTimes.remove(0, m_renderTimes.size() - HISTORY_SIZE);
+        }
+        if (m_swapTimes.size() > HISTORY_SIZE) {
+            m_swapTimes.remove(0, m_swapTimes.size() - HISTORY_SIZE);
+        }
+        intervals = m_intervals;
+        renderTimes = m_renderTimes;
+        swapTimes = m_swapTimes;
+        frames = m_framesSincePublish;
+        m_framesSincePublish = 0;
+        m_droppedFrames = m_dropped;
+    }
+
+    m_fps = frames * 1000.0 / m_publishTimer->interval();
+    m_p50 = percentileMs(intervals, 0.50);
+    m_p95 = percentileMs(intervals, 0.95);
+    m_p99 = percentileMs(intervals, 0.99);
+    m_renderP95 = percentileMs(renderTimes, 0.95);
+    m_swapP95 = percentileMs(swapTimes, 0.95);
+
+    m_signalRates.clear();
+    for (SignalCounter &counter : m_signalCounters) {
+        QVariantMap entry;
+        entry["name"] = counter.name;
+        entry["rate"] = counter.total - counter.lastTotal;
+        entry["total"] = counter.total;
+        counter.lastTotal = counter.total;
+        m_signalRates.append(entry);
+    }
+
+    emit updated();
+}
@@ -0,0 +1,113 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <QObject>
+#include <QPointer>
+#include <QQuickWindow>
+#include <QElapsedTimer>
+#include <QVariantList>
+#include <QMutex>
+#include <QTimer>
+#include <QList>
+
+// Статистика кадров окна и частоты сигналов менеджеров. Пока выключена,
+// к окну ничего не подключено и таймер не работает; счётчики сигналов
+// только увеличивают целое число.
+// renderP95 — от beforeRendering до afterRendering: запись кадра scene
+// graph без ожидания vsync. swapP95 — от afterRendering до frameSwapped:
+// ожидание vsync и досчёт кадра на GPU
+class FrameStats : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(double fps READ fps NOTIFY updated)
+    Q_PROPERTY(double p50 READ p50 NOTIFY updated)
+    Q_PROPERTY(double p95 READ p95 NOTIFY updated)
+    Q_PROPERTY(double p99 READ p99 NOTIFY updated)
+    Q_PROPERTY(double renderP95 READ renderP95 NOTIFY updated)
+    Q_PROPERTY(double swapP95 READ swapP95 NOTIFY updated)
+    Q_PROPERTY(int droppedFrames READ droppedFrames NOTIFY updated)
+    Q_PROPERTY(QVariantList signalRates READ signalRates NOTIFY updated)
+
+public:
+    static FrameStats *instance();
+
+    void attach(QQuickWindow *window);
+
+    // Считает испускания сигнала менеджера; частота в секунду видна в оверлее
+    template <typename Sender, typename Signal>
+    void trackSignal(Sender *sender, Signal signal, const QString &name)
+    {
+        const int index = counterIndex(name);
+        connect(sender, signal, this, [this, index]() { ++m_signalCounters[index].total; });
+    }
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+
+    double fps() const { return m_fps; }
+    double p50() const { return m_p50; }
+    double p95() const { return m_p95; }
+    double p99() const { return m_p99; }
+    double renderP95() const { return m_renderP95; }
+    double swapP95() const { return m_swapP95; }
+    int droppedFrames() const { return m_droppedFrames; }
+    QVariantList signalRates() const { return m_signalRates; }
+
+    Q_INVOKABLE void reset();
+
+signals:
+    void enabledChanged();
+    void updated();
+
+private:
+    struct SignalCounter {
+        QString name;
+        qint64 total = 0;
+        qint64 lastTotal = 0;
+    };
+
+    explicit FrameStats(QObject *parent = nullptr);
+
+    int counterIndex(const QString &name);
+    void connectWindow();
+    void disconnectWindow();
+    void onBeforeRendering();
+    void onAfterRendering();
+    void onFrameSwapped();
+    void publish();
+
+    static constexpr int HISTORY_SIZE = 600;
+    // Паузы длиннее этой считаются простоем сцены, а не пропуском кадров
+    static constexpr qint64 IDLE_GAP_NS = 250 * 1000 * 1000;
+
+    QPointer<QQuickWindow> m_window;
+    QList<QMetaObject::Connection> m_windowConnections;
+    bool m_enabled;
+    QTimer *m_publishTimer;
+
+    // Пишется из потока рендера, читается раз в секунду из GUI
+    QMutex m_mutex;
+    QElapsedTimer m_clock;
+    qint64 m_renderStart;
+    qint64 m_renderEnd;
+    qint64 m_lastSwap;
+    qint64 m_vsyncNs;
+    QList<qint64> m_intervals;
+    QList<qint64> m_renderTimes;
+    QList<qint64> m_swapTimes;
+    int m_framesSincePublish;
+    int m_dropped;
+
+    double m_fps;
+    double m_p50;
+    double m_p95;
+    double m_p99;
+    double m_renderP95;
+    double m_swapP95;
+    int m_droppedFrames;
+    QList<SignalCounter> m_signalCounters;
+    QVariantList m_signalRates;
+};
+
+#endif // FRAMESTATS_H
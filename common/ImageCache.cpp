@@ -0,0 +1,90 @@
+#include "ImageCache.h"
+#include <QDebug>
+
+ImageCache *ImageCache::instance()
+{
+    static ImageCache *cache = new ImageCache();
+    return cache;
+}
+
+ImageCache::ImageCache(QObject *parent)
+    : QObject(parent)
+    , m_hits(0)
+    , m_misses(0)
+    , m_statsPending(false)
+{
+    bool ok = false;
+    const int budgetMb = qEnvironmentVariableIntValue("LCD_LABS_IMAGE_CACHE_MB", &ok);
+    m_images.setMaxCost(ok ? budgetMb * 1024 : 32 * 1024);
+}
+
+QString ImageCache::assetPath(const QString &asset)
+{
+    // image://assets/MM_bg -> :/images/MM_bg.png
+    QString path = asset.startsWith(':') ? asset : ":/images/" + asset;
+    if (!path.contains('.')) {
+        path += ".png";
+    }
+    return path;
+}
+
+QImage ImageCache::image(const QString &asset)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (const QImage *cached = m_images.object(asset)) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            QImage result = *cached;
+            locker.unlock();
+            notifyStatsChanged();
+            return result;
+        }
+    }
+
+    // Декодирование идёт без блокировки, чтобы не задерживать другие потоки;
+    // при гонке двух промахов по одному ресурсу в кэше останется последний
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    QImage decoded = QImage(assetPath(asset)).convertToFormat(UPLOAD_FORMAT);
+    if (decoded.isNull()) {
+        qWarning() << "ImageCache: cannot decode" << asset;
+    } else {
+        const int cost = qMax<qsizetype>(1, decoded.sizeInBytes() / 1024);
+        QMutexLocker locker(&m_mutex);
+        m_images.insert(asset, new QImage(decoded), cost);
+    }
+    notifyStatsChanged();
+    return decoded;
+}
+
+// image() вызывается из потоков провайдера, а на statsChanged подписаны
+// привязки QML: сигнал отправляется в поток объекта, и пока он не
+// доставлен, новые запросы не ставятся в очередь
+void ImageCache::notifyStatsChanged()
+{
+    if (m_statsPending.exchange(true)) return;
+    QMetaObject::invokeMethod(this, [this]() {
+        m_statsPending.store(false);
+        emit statsChanged();
+    }, Qt::QueuedConnection);
+}
+
+int ImageCache::cachedKilobytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_images.totalCost());
+}
+
+int ImageCache::budgetKilobytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_images.maxCost());
+}
+
+void ImageCache::setBudgetKilobytes(int budget)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_images.setMaxCost(qMax(0, budget));
+    }
+    emit statsChanged();
+}
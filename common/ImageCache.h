@@ -0,0 +1,56 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+
+// LRU декодированных изображений ресурсов. Доступна из рабочих потоков
+// провайдера изображений, счётчики попаданий и промахов видны в QML.
+// Кэшируются изображения, а не текстуры: фабрику текстуры движок забирает
+// себе и удаляет, а готовую текстуру по URL делит QQuickPixmapCache.
+// Поэтому изображение хранится сразу в формате загрузки scene graph
+// (UPLOAD_FORMAT), и при создании текстуры его не нужно конвертировать
+class ImageCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 hits READ hits NOTIFY statsChanged)
+    Q_PROPERTY(qint64 misses READ misses NOTIFY statsChanged)
+    Q_PROPERTY(int cachedKilobytes READ cachedKilobytes NOTIFY statsChanged)
+    Q_PROPERTY(int budgetKilobytes READ budgetKilobytes WRITE setBudgetKilobytes NOTIFY statsChanged)
+
+public:
+    static ImageCache *instance();
+
+    static constexpr QImage::Format UPLOAD_FORMAT = QImage::Format_RGBA8888_Premultiplied;
+
+    // Возвращает декодированное изображение ресурса в UPLOAD_FORMAT, при
+    // промахе декодирует и конвертирует его в вызывающем потоке
+    QImage image(const QString &asset);
+
+    qint64 hits() const { return m_hits.load(std::memory_order_relaxed); }
+    qint64 misses() const { return m_misses.load(std::memory_order_relaxed); }
+    int cachedKilobytes() const;
+    int budgetKilobytes() const;
+    void setBudgetKilobytes(int budget);
+
+    static QString assetPath(const QString &asset);
+
+signals:
+    void statsChanged();
+
+private:
+    explicit ImageCache(QObject *parent = nullptr);
+    void notifyStatsChanged();
+
+    mutable QMutex m_mutex;
+    QCache<QString, QImage> m_images;
+    std::atomic<qint64> m_hits;
+    std::atomic<qint64> m_misses;
+    std::atomic_bool m_statsPending;
+};
+
+#endif // IMAGECACHE_H
@@ -0,0 +1,132 @@
+#ifndef INGESTPROTOCOL_H
+#define INGESTPROTOCOL_H
+
+// Общий протокол приёма инвентаризаций (IngestService). Заголовок без Qt:
+// его собирают и клиенты под Windows XP.
+//
+// Клиент открывает одно постоянное соединение и шлёт приветствие
+// "LCDI" <версия:1>; сервер отвечает тем же. Дальше идут сообщения
+// <длина:4 LE> <тип:2 LE> <флаги:2 LE> <данные:длина>. Типы:
+//   KIND_PCI_JSON    JSON-массив устройств, как у сканера лабораторной 2;
+//                    одно сообщение — законченная инвентаризация
+//   KIND_PCI_BINARY  кадры PciWireFormat без приветствия. Сообщения одного
+//                    соединения — продолжение одного потока: сканер шлёт
+//                    инвентаризацию частями по ходу обхода, агент — полную
+//                    инвентаризацию, затем изменения к ней (как с FLAG_DELTAS)
+//   KIND_HDD_JSON    JSON-массив дисков, как у клиента лабораторной 3
+// Сообщения неизвестных типов сервер пропускает.
+
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace Ingest {
+
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+
+const char MAGIC[4] = {'L', 'C', 'D', 'I'};
+const u8 VERSION = 1;
+const u16 DEFAULT_PORT = 12340;
+
+const u16 KIND_PCI_JSON = 1;
+const u16 KIND_PCI_BINARY = 2;
+const u16 KIND_HDD_JSON = 3;
+
+const size_t HELLO_SIZE = 5;
+const size_t MESSAGE_HEADER_SIZE = 8;
+const u32 MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+
+inline void appendHello(std::string &out)
+{
+    out.append(MAGIC, 4);
+    out.push_back(char(VERSION));
+}
+
+inline bool isHello(const char *data, size_t size)
+{
+    return size >= HELLO_SIZE && memcmp(data, MAGIC, 4) == 0 && u8(data[4]) >= 1 && u8(data[4]) <= VERSION;
+}
+
+inline void appendMessage(std::string &out, u16 kind, const char *data, size_t size)
+{
+    const u32 length = u32(size);
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(char((length >> shift) & 0xFF));
+    out.push_back(char(kind & 0xFF));
+    out.push_back(char(kind >> 8));
+    out.push_back(0);
+    out.push_back(0);
+    out.append(data, size);
+}
+
+// Инкрементальный разбор на сервере; сообщение отдаётся, когда пришло целиком
+class Decoder
+{
+public:
+    std::function<void(u8 version)> helloReceived;
+    std::function<void(u16 kind, u16 flags, const u8 *data, u32 length)> messageDecoded;
+
+    Decoder() : m_offset(0), m_helloReceived(false), m_error(0) {}
+
+    const char *error() const { return m_error; }
+
+    // false — поток повреждён, причина в error()
+    bool feed(const char *data, size_t size)
+    {
+        if (m_error) return false;
+
+        m_buffer.insert(m_buffer.end(), data, data + size);
+        while (!m_error) {
+            const size_t available = m_buffer.size() - m_offset;
+            if (available == 0) break;
+            const u8 *p = &m_buffer[m_offset];
+
+            if (!m_helloReceived) {
+                if (available < HELLO_SIZE) break;
+                if (!isHello(reinterpret_cast<const char *>(p), available)) return fail("bad hello");
+                m_helloReceived = true;
+                m_offset += HELLO_SIZE;
+                if (helloReceived) helloReceived(p[4]);
+                continue;
+            }
+
+            if (available < MESSAGE_HEADER_SIZE) break;
+            const u32 length = u32(p[0]) | (u32(p[1]) << 8) | (u32(p[2]) << 16) | (u32(p[3]) << 24);
+            if (length > MAX_MESSAGE_SIZE) return fail("message too large");
+            if (available < MESSAGE_HEADER_SIZE + length) break;
+
+            const u16 kind = u16(p[4] | (p[5] << 8));
+            const u16 flags = u16(p[6] | (p[7] << 8));
+            m_offset += MESSAGE_HEADER_SIZE + length;
+            if (messageDecoded) messageDecoded(kind, flags, p + MESSAGE_HEADER_SIZE, length);
+        }
+
+        // Сдвигаем разобранное, когда оно занимает больше половины буфера
+        if (m_offset > 0 && m_offset * 2 >= m_buffer.size()) {
+            m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_offset);
+            m_offset = 0;
+        }
+        return m_error == 0;
+    }
+
+private:
+    bool fail(const char *error)
+    {
+        m_error = error;
+        m_buffer.clear();
+        m_offset = 0;
+        return false;
+    }
+
+    std::vector<u8> m_buffer;
+    size_t m_offset;
+    bool m_helloReceived;
+    const char *m_error;
+};
+
+} // namespace Ingest
+
+#endif // INGESTPROTOCOL_H
@@ -0,0 +1,179 @@
+#include "IngestService.h"
+#include "IoThread.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QNetworkInterface>
+
+IngestService *IngestService::instance()
+{
+    static IngestService *service = []() {
+        auto ingestService = new IngestService();
+        IoThread::adopt(ingestService);
+        return ingestService;
+    }();
+    return service;
+}
+
+IngestService::IngestService(QObject *parent)
+    : QObject(parent)
+    , m_port(DEFAULT_PORT)
+    , m_tcpServer(nullptr)
+{
+    const quint16 port = qEnvironmentVariable("LCD_LABS_INGEST_PORT").toUShort();
+    if (port != 0) {
+        m_port = port;
+    }
+}
+
+IngestService::~IngestService()
+{
+    m_sinks.clear();
+    updateListening();
+}
+
+QString IngestService::localAddress()
+{
+    const QList<QHostAddress> addresses = QNetworkInterface::allAddresses();
+    for (const QHostAddress &address : addresses) {
+        if (address.protocol() == QAbstractSocket::IPv4Protocol
+            && !address.isLoopback()
+            && !address.toString().startsWith("169.254")) { // APIPA
+            return address.toString();
+        }
+    }
+    return "127.0.0.1";
+}
+
+bool IngestService::registerSink(quint16 kind, IngestSink *sink)
+{
+    m_sinks.insert(kind, sink);
+    updateListening();
+    return m_tcpServer != nullptr;
+}
+
+void IngestService::unregisterSink(quint16 kind, IngestSink *sink)
+{
+    if (m_sinks.value(kind) != sink) return;
+
+    m_sinks.remove(kind);
+    updateListening();
+}
+
+void IngestService::updateListening()
+{
+    if (!m_sinks.isEmpty() && !m_tcpServer) {
+        m_tcpServer = new QTcpServer(this);
+        m_tcpServer->setListenBacklogSize(LISTEN_BACKLOG);
+        m_tcpServer->setMaxPendingConnections(LISTEN_BACKLOG);
+        connect(m_tcpServer, &QTcpServer::newConnection, this, &IngestService::onNewConnection);
+        if (!m_tcpServer->listen(QHostAddress::Any, m_port)) {
+            qWarning() << "Ingest service cannot listen on" << m_port << m_tcpServer->errorString();
+            delete m_tcpServer;
+            m_tcpServer = nullptr;
+        }
+        return;
+    }
+
+    if (m_sinks.isEmpty() && m_tcpServer) {
+        const QList<Connection *> connections = m_connections.values();
+        m_connections.clear();
+        for (Connection *connection : connections) {
+            connection->socket->disconnect(this);
+            connection->socket->abort();
+            connection->socket->deleteLater();
+            delete connection;
+        }
+        delete m_tcpServer;
+        m_tcpServer = nullptr;
+        emit connectionCountChanged(0);
+    }
+}
+
+void IngestService::onNewConnection()
+{
+    while (m_tcpServer && m_tcpServer->hasPendingConnections()) {
+        QTcpSocket *socket = m_tcpServer->nextPendingConnection();
+        if (m_connections.size() >= MAX_CONNECTIONS) {
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+
+        // Чтение ограничено буфером: медленный получатель притормаживает
+        // отправителя через окно TCP, а не раздувает память
+        socket->setReadBufferSize(READ_BUFFER_SIZE);
+
+        auto connection = new Connection;
+        connection->socket = socket;
+        bool isIPv4 = false;
+        const quint32 ipv4 = socket->peerAddress().toIPv4Address(&isIPv4);
+        connection->host = isIPv4 ? QHostAddress(ipv4).toString() : socket->peerAddress().toString();
+
+        connection->decoder.helloReceived = [connection](Ingest::u8 version) {
+            Q_UNUSED(version)
+            std::string ack;
+            Ingest::appendHello(ack);
+            connection->socket->write(ack.data(), qint64(ack.size()));
+        };
+        connection->decoder.messageDecoded = [this, connection](Ingest::u16 kind, Ingest::u16 flags,
+                                                                const Ingest::u8 *data, Ingest::u32 length) {
+            Q_UNUSED(flags)
+            route(connection, kind, QByteArray(reinterpret_cast<const char *>(data), qsizetype(length)));
+        };
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, connection]() { readConnection(connection); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, connection]() { closeConnection(connection); });
+        m_connections.insert(socket, connection);
+    }
+
+    emit connectionCountChanged(m_connections.size());
+}
+
+void IngestService::readConnection(Connection *connection)
+{
+    TRACE_SCOPE("ingest", "IngestService::readConnection");
+    const QByteArray chunk = connection->socket->readAll();
+    if (connection->failed) return;
+    if (!connection->decoder.feed(chunk.constData(), size_t(chunk.size()))) {
+        qWarning() << "Ingest service:" << connection->host << connection->decoder.error();
+        connection->failed = true;
+    }
+    if (connection->failed) {
+        // closeConnection может удалить connection прямо здесь
+        connection->socket->disconnectFromHost();
+    }
+}
+
+void IngestService::closeConnection(Connection *connection)
+{
+    const QList<IngestSink *> sinks = QSet<IngestSink *>(m_sinks.cbegin(), m_sinks.cend()).values();
+    for (IngestSink *sink : sinks) {
+        sink->connectionClosed(quintptr(connection));
+    }
+
+    m_connections.remove(connection->socket);
+    connection->socket->disconnect(this);
+    connection->socket->deleteLater();
+    delete connection;
+
+    emit connectionCountChanged(m_connections.size());
+}
+
+void IngestService::route(Connection *connection, quint16 kind, const QByteArray &payload)
+{
+    TRACE_SCOPE("ingest", "IngestService::route");
+    // Остаток куска после отвергнутого сообщения не разбираем
+    if (connection->failed) return;
+    IngestSink *sink = m_sinks.value(kind);
+    if (!sink) {
+        // Тип будущей версии или лабораторная сейчас не открыта
+        if (!m_reportedKinds.contains(kind)) {
+            m_reportedKinds.insert(kind);
+            qDebug() << "Ingest service: no receiver for message kind" << kind;
+        }
+        return;
+    }
+    if (!sink->ingest(quintptr(connection), connection->host, kind, payload)) {
+        connection->failed = true;
+    }
+}
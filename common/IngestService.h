@@ -0,0 +1,79 @@
+#ifndef INGESTSERVICE_H
+#define INGESTSERVICE_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QSet>
+#include "IngestProtocol.h"
+
+// Получатель сообщений одного типа; вызывается в потоке I/O. connection
+// различает соединения одного хоста и действителен до connectionClosed:
+// по нему получатель ведёт состояние, которое тянется между сообщениями
+class IngestSink
+{
+public:
+    virtual ~IngestSink() = default;
+    // false — поток соединения испорчен, сервис закрывает соединение
+    virtual bool ingest(quintptr connection, const QString &host, quint16 kind, const QByteArray &payload) = 0;
+    virtual void connectionClosed(quintptr connection) { Q_UNUSED(connection) }
+};
+
+// Единая точка приёма инвентаризаций (IngestProtocol.h): один порт, одно
+// постоянное соединение на хост, сообщения разных типов в нём. Каждое
+// сообщение передаётся получателю своего типа. Живёт в IoThread; порт
+// слушается, пока зарегистрирован хотя бы один получатель. Здесь же все
+// настройки приёма: буферы, очередь подключений и их предел.
+class IngestService : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Создаётся в потоке GUI при первом обращении и переносится в IoThread
+    static IngestService *instance();
+
+    // Только из потока I/O
+    bool registerSink(quint16 kind, IngestSink *sink);
+    void unregisterSink(quint16 kind, IngestSink *sink);
+
+    quint16 port() const { return m_port; }
+    int connectionCount() const { return m_connections.size(); }
+    // Адрес этой машины для подсказки в интерфейсе лабораторных
+    static QString localAddress();
+
+    // Порт — LCD_LABS_INGEST_PORT или DEFAULT_PORT
+    static constexpr quint16 DEFAULT_PORT = Ingest::DEFAULT_PORT;
+    static constexpr int LISTEN_BACKLOG = 1024;
+    static constexpr int MAX_CONNECTIONS = 4096;
+    static constexpr qint64 READ_BUFFER_SIZE = 256 * 1024;
+
+signals:
+    void connectionCountChanged(int connectionCount);
+
+private:
+    explicit IngestService(QObject *parent = nullptr);
+    ~IngestService() override;
+
+    struct Connection {
+        QTcpSocket *socket = nullptr;
+        QString host;
+        Ingest::Decoder decoder;
+        // Получатель отверг сообщение; закрывается в readConnection после feed
+        bool failed = false;
+    };
+
+    void updateListening();
+    void onNewConnection();
+    void readConnection(Connection *connection);
+    void closeConnection(Connection *connection);
+    void route(Connection *connection, quint16 kind, const QByteArray &payload);
+
+    quint16 m_port;
+    QTcpServer *m_tcpServer;
+    QHash<QTcpSocket *, Connection *> m_connections;
+    QHash<quint16, IngestSink *> m_sinks;
+    QSet<quint16> m_reportedKinds;
+};
+
+#endif // INGESTSERVICE_H
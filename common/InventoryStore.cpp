@@ -0,0 +1,129 @@
+#include "InventoryStore.h"
+#include <QSet>
+
+StringPool::StringPool()
+{
+    clear();
+}
+
+void StringPool::clear()
+{
+    m_data = QByteArray(1, '\0');
+    m_index.clear();
+}
+
+quint32 StringPool::intern(QByteArrayView utf8)
+{
+    if (utf8.isEmpty()) return 0;
+
+    const size_t hash = qHash(utf8);
+    for (auto it = m_index.constFind(hash); it != m_index.cend() && it.key() == hash; ++it) {
+        if (view(it.value()) == utf8) return it.value();
+    }
+
+    const quint32 id = quint32(m_data.size());
+    m_data.append(utf8.data(), utf8.size());
+    m_data.append('\0');
+    m_index.insert(hash, id);
+    return id;
+}
+
+quint32 StringPool::intern(const QString &text)
+{
+    return intern(QByteArrayView(text.toUtf8()));
+}
+
+QByteArrayView StringPool::view(quint32 id) const
+{
+    if (id == 0 || id >= quint32(m_data.size())) return QByteArrayView();
+    return QByteArrayView(m_data.constData() + id);
+}
+
+qint64 StringPool::memoryUsage() const
+{
+    // Буфер плюс примерно два указателя на узел индекса
+    return m_data.capacity() + qint64(m_index.size()) * qint64(sizeof(size_t) + sizeof(quint32) + 2 * sizeof(void *));
+}
+
+QVariantMap InventoryStore::MemoryReport::toVariantMap() const
+{
+    QVariantMap map;
+    map["hosts"] = hosts;
+    map["pciRecords"] = pciRecords;
+    map["driveRecords"] = driveRecords;
+    map["recordBytes"] = recordBytes;
+    map["stringBytes"] = stringBytes;
+    map["totalBytes"] = totalBytes;
+    return map;
+}
+
+InventoryStore::Host &InventoryStore::host(const QString &address)
+{
+    auto it = m_hosts.find(address);
+    if (it == m_hosts.end()) {
+        it = m_hosts.insert(address, Host());
+        it->address = m_strings.intern(address);
+    }
+    return *it;
+}
+
+const InventoryStore::Host *InventoryStore::find(const QString &address) const
+{
+    auto it = m_hosts.constFind(address);
+    return it == m_hosts.cend() ? nullptr : &*it;
+}
+
+QStringList InventoryStore::hosts() const
+{
+    QStringList result = m_hosts.keys();
+    result.sort();
+    return result;
+}
+
+void InventoryStore::clear()
+{
+    m_hosts.clear();
+    m_strings.clear();
+}
+
+qint64 InventoryStore::hostBytes(const Host &host, MemoryReport &report) const
+{
+    report.pciRecords += int(host.pci.size());
+    report.driveRecords += int(host.drives.size());
+    const qint64 records = qint64(sizeof(Host)) + host.pci.capacity() * qint64(sizeof(PciRecord))
+                           + host.drives.capacity() * qint64(sizeof(DriveRecord));
+    report.recordBytes += records;
+
+    QSet<quint32> strings{host.address, host.hostName};
+    for (const DriveRecord &drive : host.drives) {
+        strings.unite({drive.model, drive.serial, drive.firmware, drive.interface, drive.manufacturer, drive.modes});
+    }
+    qint64 stringBytes = 0;
+    for (quint32 id : std::as_const(strings)) {
+        if (id != 0) stringBytes += m_strings.view(id).size() + 1;
+    }
+    report.stringBytes += stringBytes;
+    return records + stringBytes;
+}
+
+InventoryStore::MemoryReport InventoryStore::memoryReport(const QString &address) const
+{
+    MemoryReport report;
+    if (!address.isEmpty()) {
+        if (const Host *entry = find(address)) {
+            report.hosts = 1;
+            report.totalBytes = hostBytes(*entry, report);
+        }
+        return report;
+    }
+
+    report.hosts = int(m_hosts.size());
+    for (const Host &entry : m_hosts) {
+        hostBytes(entry, report);
+    }
+    // Для всего хранилища строки считаются по пулу, без повторов
+    report.stringBytes = m_strings.memoryUsage();
+    report.totalBytes = report.recordBytes + report.stringBytes
+                        + qint64(m_hosts.size()) * qint64(sizeof(QString) + 2 * sizeof(void *));
+    return report;
+}
@@ -0,0 +1,122 @@
+#ifndef INVENTORYSTORE_H
+#define INVENTORYSTORE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QList>
+#include <QMultiHash>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <string.h>
+
+// Пул строк: каждая различная строка хранится один раз в общем буфере
+// UTF-8 с нулём в конце, записи ссылаются на неё 32-битным смещением.
+// Смещение 0 — пустая строка. Строки не удаляются до clear()
+class StringPool
+{
+public:
+    StringPool();
+
+    quint32 intern(QByteArrayView utf8);
+    quint32 intern(const QString &text);
+    QByteArrayView view(quint32 id) const;
+    QString string(quint32 id) const { return QString::fromUtf8(view(id)); }
+
+    void clear();
+    int count() const { return int(m_index.size()); }
+    qint64 memoryUsage() const;
+
+private:
+    QByteArray m_data;
+    QMultiHash<size_t, quint32> m_index;
+};
+
+// Функция PCI: поля, которые нужны интерфейсу, уже извлечены из
+// заголовка конфигурации; сам заголовок хранится только в истории
+struct PciRecord {
+    enum Flags : quint8 { HasConfigHeader = 0x01 };
+
+    quint8 bus;
+    quint8 device;
+    quint8 function;
+    quint8 flags;
+    quint16 vendorId;
+    quint16 deviceId;
+    quint16 subsystemVendorId;
+    quint16 subsystemId;
+    quint8 classCode;
+    quint8 subclass;
+    quint8 progIf;
+    quint8 headerType;
+
+    int key() const { return (bus << 8) | (device << 3) | function; }
+    bool operator==(const PciRecord &other) const { return memcmp(this, &other, sizeof(PciRecord)) == 0; }
+};
+static_assert(sizeof(PciRecord) == 16, "PciRecord must stay compact");
+
+// Диск; строки — смещения в StringPool
+struct DriveRecord {
+    qint64 totalBytes;
+    qint64 freeBytes;
+    qint64 usedBytes;
+    quint32 index;
+    quint32 model;
+    quint32 serial;
+    quint32 firmware;
+    quint32 interface;
+    quint32 manufacturer;
+    quint32 modes;
+};
+
+// Инвентаризации хостов в компактном виде: числа и смещения строк в
+// непрерывных массивах, по одной копии данных. Используется в потоке GUI
+class InventoryStore
+{
+public:
+    struct Host {
+        quint32 address = 0;
+        quint32 hostName = 0;
+        qint64 lastSeen = 0;        // мс с эпохи, 0 — ещё не было
+        bool receiving = false;
+        QList<PciRecord> pci;       // по возрастанию key()
+        QList<DriveRecord> drives;
+    };
+
+    struct MemoryReport {
+        int hosts = 0;
+        int pciRecords = 0;
+        int driveRecords = 0;
+        qint64 recordBytes = 0;
+        // Строки хоста; общие строки учитываются у каждого хоста полностью
+        qint64 stringBytes = 0;
+        qint64 totalBytes = 0;
+
+        QVariantMap toVariantMap() const;
+    };
+
+    StringPool &strings() { return m_strings; }
+    const StringPool &strings() const { return m_strings; }
+
+    // Создаёт запись хоста при первом обращении
+    Host &host(const QString &address);
+    const Host *find(const QString &address) const;
+    bool contains(const QString &address) const { return m_hosts.contains(address); }
+    // Отсортированные адреса
+    QStringList hosts() const;
+    const QHash<QString, Host> &entries() const { return m_hosts; }
+    int hostCount() const { return int(m_hosts.size()); }
+    void clear();
+
+    // Пустой адрес — всё хранилище вместе с пулом строк
+    MemoryReport memoryReport(const QString &address = QString()) const;
+
+private:
+    qint64 hostBytes(const Host &host, MemoryReport &report) const;
+
+    StringPool m_strings;
+    QHash<QString, Host> m_hosts;
+};
+
+#endif // INVENTORYSTORE_H
@@ -0,0 +1,56 @@
+#include "IoThread.h"
+#include <QCoreApplication>
+
+IoThread *IoThread::instance()
+{
+    static IoThread *thread = []() {
+        auto ioThread = new IoThread();
+        ioThread->setObjectName("I/O");
+        ioThread->start();
+        QObject::connect(qApp, &QCoreApplication::aboutToQuit, ioThread, &IoThread::shutdown);
+        return ioThread;
+    }();
+    return thread;
+}
+
+IoThread::IoThread(QObject *parent)
+    : QThread(parent)
+{
+}
+
+void IoThread::adopt(QObject *object)
+{
+    IoThread *thread = instance();
+    object->moveToThread(thread);
+    thread->m_objects.append(object);
+}
+
+void IoThread::shutdown()
+{
+    // Серверы и сокеты удаляются в своём потоке до его остановки
+    const QList<QPointer<QObject>> objects = m_objects;
+    for (const QPointer<QObject> &object : objects) {
+        dispose(object);
+    }
+    m_objects.clear();
+
+    quit();
+    wait();
+}
+
+void IoThread::dispose(QObject *object)
+{
+    if (!object) return;
+
+    if (object->thread() == instance()) {
+        instance()->m_objects.removeAll(object);
+    }
+
+    QThread *thread = object->thread();
+    if (thread == QThread::currentThread() || !thread->isRunning()) {
+        // Поток уже остановлен при выходе: событий у объекта больше не будет
+        delete object;
+    } else {
+        QMetaObject::invokeMethod(object, [object]() { delete object; }, Qt::BlockingQueuedConnection);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef IOTHREAD_H
+#define IOTHREAD_H
+
+#include <QThread>
+#include <QPointer>
+#include <QList>
+
+// Общий поток сетевого приёма: серверы лабораторных принимают соединения,
+// читают и разбирают данные здесь, а в GUI уходят только готовые снимки
+class IoThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    // Запускается при первом обращении и останавливается при выходе
+    static IoThread *instance();
+
+    // Переносит объект в поток; удалять его нужно через dispose()
+    static void adopt(QObject *object);
+    // Удаляет объект в его потоке и дожидается этого
+    static void dispose(QObject *object);
+
+private:
+    explicit IoThread(QObject *parent = nullptr);
+    void shutdown();
+
+    // Объекты, перенесённые через adopt(); трогаются только из GUI
+    QList<QPointer<QObject>> m_objects;
+};
+
+#endif // IOTHREAD_H
@@ -0,0 +1,233 @@
+#include "PageCache.h"
+#include "Trace.h"
+#include <QQmlEngine>
+#include <QTimer>
+#include <QDebug>
+#include <limits>
+
+PageIncubator::PageIncubator(PageCache *cache, const QUrl &url, IncubationMode mode)
+    : QQmlIncubator(mode)
+    , m_cache(cache)
+    , m_url(url)
+{
+}
+
+void PageIncubator::statusChanged(Status status)
+{
+    if (status == Ready) {
+        m_cache->onIncubated(m_url, object());
+    } else if (status == Error) {
+        m_cache->onIncubationFailed(m_url, errors());
+    }
+}
+
+PageCache::PageCache(QQmlEngine *engine, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_budget(5)
+    , m_useCounter(0)
+{
+    bool ok = false;
+    const int budget = qEnvironmentVariableIntValue("LCD_LABS_PAGE_BUDGET", &ok);
+    if (ok) {
+        m_budget = qMax(0, budget);
+    }
+}
+
+PageCache::~PageCache()
+{
+    for (CachedPage &page : m_pages) {
+        // Страницу, оставшуюся в StackView при выходе, не удаляем: StackView
+        // ещё ссылается на неё, а процесс всё равно завершается
+        if (page.item && !page.item->parentItem()) {
+            delete page.item;
+        }
+        delete page.incubator;
+        delete page.component;
+    }
+}
+
+void PageCache::setBudget(int budget)
+{
+    budget = qMax(0, budget);
+    if (m_budget == budget) return;
+
+    m_budget = budget;
+    trim();
+    emit budgetChanged();
+}
+
+int PageCache::cachedPages() const
+{
+    int count = 0;
+    for (const CachedPage &page : m_pages) {
+        if (page.item) ++count;
+    }
+    return count;
+}
+
+void PageCache::preload(const QList<QUrl> &urls)
+{
+    for (const QUrl &url : urls) {
+        if (!m_pages.contains(url) && !m_pending.contains(url)) {
+            m_pending.append(url);
+        }
+    }
+
+    // Первая страница начинает грузиться после возврата в цикл событий,
+    // чтобы не задерживать показ меню
+    if (m_preloading.isEmpty() && !m_pending.isEmpty()) {
+        QTimer::singleShot(0, this, &PageCache::preloadNext);
+    }
+}
+
+void PageCache::preloadNext()
+{
+    m_preloading = QUrl();
+
+    while (!m_pending.isEmpty()) {
+        const QUrl url = m_pending.takeFirst();
+        if (m_pages.contains(url)) continue;
+        if (m_pages.size() >= m_budget) {
+            m_pending.clear();
+            return;
+        }
+
+        m_preloading = url;
+        CachedPage &page = m_pages[url];
+        page.component = new QQmlComponent(m_engine, url, QQmlComponent::Asynchronous, this);
+        if (page.component->isLoading()) {
+            connect(page.component, &QQmlComponent::statusChanged,
+                    this, [this, url](QQmlComponent::Status status) {
+                        if (status != QQmlComponent::Loading) {
+                            incubate(url, QQmlIncubator::Asynchronous);
+                        }
+                    });
+        } else {
+            incubate(url, QQmlIncubator::Asynchronous);
+        }
+        return;
+    }
+}
+
+void PageCache::incubate(const QUrl &url, QQmlIncubator::IncubationMode mode)
+{
+    auto it = m_pages.find(url);
+    if (it == m_pages.end() || it->incubator) return;
+
+    if (!it->component->isReady()) {
+        onIncubationFailed(url, it->component->errors());
+        return;
+    }
+
+    TRACE_SCOPE("page", "PageCache::incubate");
+    // Асинхронный инкубатор создаёт объекты порциями между кадрами окна
+    it->incubator = new PageIncubator(this, url, mode);
+    it->component->create(*it->incubator);
+}
+
+void PageCache::onIncubated(const QUrl &url, QObject *object)
+{
+    auto it = m_pages.find(url);
+    if (it == m_pages.end()) return;
+
+    it->item = qobject_cast<QQuickItem *>(object);
+    if (it->item) {
+        // Страницей владеет кэш, StackView и JS её не удаляют
+        QQmlEngine::setObjectOwnership(it->item, QQmlEngine::CppOwnership);
+        emit cachedPagesChanged();
+    } else {
+        qWarning() << "PageCache:" << url << "is not an Item";
+        it->failed = true;
+    }
+
+    if (url == m_preloading) {
+        QTimer::singleShot(0, this, &PageCache::preloadNext);
+    }
+}
+
+void PageCache::onIncubationFailed(const QUrl &url, const QList<QQmlError> &errors)
+{
+    qWarning() << "PageCache: cannot create" << url << errors;
+
+    auto it = m_pages.find(url);
+    if (it != m_pages.end()) {
+        it->failed = true;
+    }
+
+    if (url == m_preloading) {
+        QTimer::singleShot(0, this, &PageCache::preloadNext);
+    }
+}
+
+QQuickItem *PageCache::acquire(const QUrl &url)
+{
+    TRACE_SCOPE("page", "PageCache::acquire");
+    auto it = m_pages.find(url);
+    if (it == m_pages.end()) {
+        it = m_pages.insert(url, CachedPage());
+    }
+
+    if (!it->item && !it->failed) {
+        if (it->incubator) {
+            // Страница ещё инкубируется: досоздаём её сразу
+            it->incubator->forceCompletion();
+        } else {
+            if (!it->component || it->component->isLoading()) {
+                delete it->component;
+                it->component = new QQmlComponent(m_engine, url, QQmlComponent::PreferSynchronous, this);
+            }
+            incubate(url, QQmlIncubator::Synchronous);
+        }
+        it = m_pages.find(url);
+    }
+
+    if (it == m_pages.end() || !it->item) {
+        dropPage(url);
+        return nullptr;
+    }
+
+    it->lastUsed = ++m_useCounter;
+    QQuickItem *item = it->item;
+    trim(url);
+    return item;
+}
+
+void PageCache::trim(const QUrl &keep)
+{
+    while (m_pages.size() > m_budget) {
+        QUrl victim;
+        qint64 oldest = std::numeric_limits<qint64>::max();
+        for (auto it = m_pages.cbegin(); it != m_pages.cend(); ++it) {
+            // Страницы, которые сейчас в StackView, не трогаем
+            if (it.key() == keep || (it->item && it->item->parentItem())) continue;
+            if (it->lastUsed < oldest) {
+                oldest = it->lastUsed;
+                victim = it.key();
+            }
+        }
+        if (victim.isEmpty()) break;
+        dropPage(victim);
+    }
+}
+
+void PageCache::dropPage(const QUrl &url)
+{
+    auto it = m_pages.find(url);
+    if (it == m_pages.end()) return;
+
+    CachedPage page = *it;
+    m_pages.erase(it);
+
+    const bool hadItem = !page.item.isNull();
+    delete page.item;
+    delete page.incubator;
+    delete page.component;
+
+    if (url == m_preloading) {
+        QTimer::singleShot(0, this, &PageCache::preloadNext);
+    }
+    if (hadItem) {
+        emit cachedPagesChanged();
+    }
+}
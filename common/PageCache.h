@@ -0,0 +1,79 @@
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include <QObject>
+#include <QQmlIncubator>
+#include <QQmlComponent>
+#include <QQuickItem>
+#include <QPointer>
+#include <QHash>
+#include <QList>
+#include <QUrl>
+
+class PageCache;
+
+class PageIncubator : public QQmlIncubator
+{
+public:
+    PageIncubator(PageCache *cache, const QUrl &url, IncubationMode mode);
+
+protected:
+    void statusChanged(Status status) override;
+
+private:
+    PageCache *m_cache;
+    QUrl m_url;
+};
+
+// Кэш страниц лабораторных. Страницы заранее инкубируются асинхронно в
+// промежутках между кадрами, пока открыто меню, и переиспользуются при
+// повторном входе. Бюджет задаёт, сколько готовых страниц держать в памяти;
+// лишние, давно не открывавшиеся страницы вне StackView удаляются
+class PageCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int budget READ budget WRITE setBudget NOTIFY budgetChanged)
+    Q_PROPERTY(int cachedPages READ cachedPages NOTIFY cachedPagesChanged)
+
+public:
+    explicit PageCache(QQmlEngine *engine, QObject *parent = nullptr);
+    ~PageCache();
+
+    int budget() const { return m_budget; }
+    void setBudget(int budget);
+    int cachedPages() const;
+
+    Q_INVOKABLE void preload(const QList<QUrl> &urls);
+    Q_INVOKABLE QQuickItem *acquire(const QUrl &url);
+
+signals:
+    void budgetChanged();
+    void cachedPagesChanged();
+
+private:
+    friend class PageIncubator;
+
+    struct CachedPage {
+        QQmlComponent *component = nullptr;
+        PageIncubator *incubator = nullptr;
+        QPointer<QQuickItem> item;
+        qint64 lastUsed = 0;
+        bool failed = false;
+    };
+
+    void preloadNext();
+    void incubate(const QUrl &url, QQmlIncubator::IncubationMode mode);
+    void onIncubated(const QUrl &url, QObject *object);
+    void onIncubationFailed(const QUrl &url, const QList<QQmlError> &errors);
+    void trim(const QUrl &keep = QUrl());
+    void dropPage(const QUrl &url);
+
+    QQmlEngine *m_engine;
+    QHash<QUrl, CachedPage> m_pages;
+    QList<QUrl> m_pending;
+    QUrl m_preloading;
+    int m_budget;
+    qint64 m_useCounter;
+};
+
+#endif // PAGECACHE_H
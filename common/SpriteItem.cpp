@@ -0,0 +1,218 @@
+#include "SpriteItem.h"
+#include "SpriteAtlasData.h"
+#include <QQuickWindow>
+#include <QSGImageNode>
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <QDebug>
+
+namespace {
+
+// Атлас декодируется один раз на процесс
+const QImage &atlasImage()
+{
+    static const QImage image(QString::fromLatin1(SpriteAtlas::atlasPath));
+    return image;
+}
+
+// Текстура атласа одна на окно и живёт, пока жив граф сцены окна.
+// Вызывается из потока рендера
+QSGTexture *atlasTexture(QQuickWindow *window)
+{
+    static QMutex mutex;
+    static QHash<QQuickWindow *, QSGTexture *> textures;
+
+    QMutexLocker locker(&mutex);
+    QSGTexture *texture = textures.value(window);
+    if (!texture) {
+        texture = window->createTextureFromImage(atlasImage());
+        textures.insert(window, texture);
+        QObject::connect(window, &QQuickWindow::sceneGraphInvalidated, window, [window]() {
+            QMutexLocker locker(&mutex);
+            delete textures.take(window);
+        }, Qt::ConnectionType(Qt::DirectConnection | Qt::SingleShotConnection));
+    }
+    return texture;
+}
+
+} // namespace
+
+SpriteItem::SpriteItem(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_interval(100)
+    , m_playing(false)
+    , m_mirrored(false)
+    , m_frameIndex(0)
+    , m_lastTick(0)
+    , m_subscribed(false)
+{
+    setFlag(ItemHasContents, true);
+}
+
+SpriteItem::~SpriteItem()
+{
+    if (m_subscribed) {
+        AnimationClock::instance()->unsubscribe(this);
+    }
+}
+
+void SpriteItem::setSheet(const QString &sheet)
+{
+    if (m_sheet == sheet) return;
+
+    m_sheet = sheet;
+    m_frameRects.clear();
+
+    const QByteArray name = sheet.toLatin1();
+    const SpriteAtlas::Sheet *found = nullptr;
+    for (const SpriteAtlas::Sheet &entry : SpriteAtlas::sheets) {
+        if (name == entry.name) {
+            found = &entry;
+            break;
+        }
+    }
+
+    int maxWidth = 0;
+    int maxHeight = 0;
+    if (found) {
+        for (int i = 0; i < found->frameCount; ++i) {
+            const SpriteAtlas::Frame &frame = SpriteAtlas::frames[found->firstFrame + i];
+            m_frameRects.append(QRectF(frame.x, frame.y, frame.width, frame.height));
+            maxWidth = qMax(maxWidth, frame.width);
+            maxHeight = qMax(maxHeight, frame.height);
+        }
+    } else if (!sheet.isEmpty()) {
+        qWarning() << "SpriteItem: unknown sheet" << sheet;
+    }
+
+    setImplicitSize(maxWidth, maxHeight);
+    setFrameIndex(0);
+    update();
+    updateClock();
+    emit sheetChanged();
+}
+
+void SpriteItem::setInterval(int interval)
+{
+    if (m_interval == interval || interval <= 0) return;
+
+    m_interval = interval;
+    emit intervalChanged();
+}
+
+void SpriteItem::setPlaying(bool playing)
+{
+    if (m_playing == playing) return;
+
+    m_playing = playing;
+    setFrameIndex(0);
+    m_lastTick = AnimationClock::instance()->elapsed();
+    updateClock();
+    emit playingChanged();
+}
+
+void SpriteItem::setMirrored(bool mirrored)
+{
+    if (m_mirrored == mirrored) return;
+
+    m_mirrored = mirrored;
+    update();
+    emit mirroredChanged();
+}
+
+void SpriteItem::setFrameIndex(int index)
+{
+    if (m_frameRects.isEmpty()) {
+        index = 0;
+    } else {
+        index %= m_frameRects.size();
+    }
+    if (m_frameIndex == index) return;
+
+    m_frameIndex = index;
+    update();
+    emit frameIndexChanged();
+}
+
+void SpriteItem::animationTick(int elapsed)
+{
+    if (m_frameRects.isEmpty()) return;
+
+    const int steps = (elapsed - m_lastTick) / m_interval;
+    if (steps <= 0) return;
+
+    m_lastTick += steps * m_interval;
+    setFrameIndex(m_frameIndex + steps);
+}
+
+bool SpriteItem::shouldAnimate() const
+{
+    if (!m_playing || m_frameRects.isEmpty() || !isVisible() || !window()) {
+        return false;
+    }
+    const QWindow::Visibility visibility = window()->visibility();
+    return visibility != QWindow::Hidden && visibility != QWindow::Minimized;
+}
+
+void SpriteItem::updateClock()
+{
+    const bool animate = shouldAnimate();
+    if (animate == m_subscribed) return;
+
+    AnimationClock *clock = AnimationClock::instance();
+    if (animate) {
+        clock->subscribe(this);
+        m_lastTick = clock->elapsed();
+    } else {
+        clock->unsubscribe(this);
+    }
+    m_subscribed = animate;
+}
+
+void SpriteItem::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    if (change == ItemSceneChange) {
+        disconnect(m_windowConnection);
+        if (value.window) {
+            m_windowConnection = connect(value.window, &QWindow::visibilityChanged,
+                                         this, &SpriteItem::updateClock);
+        }
+    }
+
+    QQuickItem::itemChange(change, value);
+
+    if (change == ItemSceneChange && !value.window && m_subscribed) {
+        // Элемент убирают из окна: window() здесь может ещё указывать на старое
+        AnimationClock::instance()->unsubscribe(this);
+        m_subscribed = false;
+    } else if (change == ItemSceneChange || change == ItemVisibleHasChanged) {
+        updateClock();
+    }
+}
+
+QSGNode *SpriteItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    auto *node = static_cast<QSGImageNode *>(oldNode);
+    if (m_frameRects.isEmpty() || atlasImage().isNull()) {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node) {
+        node = window()->createImageNode();
+        node->setOwnsTexture(false);
+        node->setFiltering(QSGTexture::Linear);
+        node->setTexture(atlasTexture(window()));
+    }
+
+    const QRectF &frame = m_frameRects.at(m_frameIndex);
+    node->setSourceRect(frame);
+    node->setRect(QRectF((width() - frame.width()) / 2, (height() - frame.height()) / 2,
+                         frame.width(), frame.height()));
+    node->setTextureCoordinatesTransform(m_mirrored ? QSGImageNode::MirrorHorizontally
+                                                    : QSGImageNode::NoTransform);
+    return node;
+}
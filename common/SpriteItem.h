@@ -0,0 +1,67 @@
+#ifndef SPRITEITEM_H
+#define SPRITEITEM_H
+
+#include <QQuickItem>
+#include <QList>
+#include <QRectF>
+#include "AnimationClock.h"
+
+// Спрайт из атласа, собранного spritepack при сборке. Кадры листа берутся из
+// сгенерированной таблицы, атлас загружается в одну текстуру на окно, а
+// отрисовка идёт через QSGImageNode без Canvas. Кадры переключаются от общих
+// часов AnimationClock, на которые спрайт подписан, только пока он играет и
+// виден в неминимизированном окне
+class SpriteItem : public QQuickItem, public AnimationSubscriber
+{
+    Q_OBJECT
+    Q_PROPERTY(QString sheet READ sheet WRITE setSheet NOTIFY sheetChanged)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+    Q_PROPERTY(bool playing READ playing WRITE setPlaying NOTIFY playingChanged)
+    Q_PROPERTY(bool mirrored READ mirrored WRITE setMirrored NOTIFY mirroredChanged)
+    Q_PROPERTY(int frameIndex READ frameIndex WRITE setFrameIndex NOTIFY frameIndexChanged)
+    Q_PROPERTY(int frameCount READ frameCount NOTIFY sheetChanged)
+
+public:
+    explicit SpriteItem(QQuickItem *parent = nullptr);
+    ~SpriteItem();
+
+    QString sheet() const { return m_sheet; }
+    void setSheet(const QString &sheet);
+    int interval() const { return m_interval; }
+    void setInterval(int interval);
+    bool playing() const { return m_playing; }
+    void setPlaying(bool playing);
+    bool mirrored() const { return m_mirrored; }
+    void setMirrored(bool mirrored);
+    int frameIndex() const { return m_frameIndex; }
+    void setFrameIndex(int index);
+    int frameCount() const { return m_frameRects.size(); }
+
+signals:
+    void sheetChanged();
+    void intervalChanged();
+    void playingChanged();
+    void mirroredChanged();
+    void frameIndexChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+    void animationTick(int elapsed) override;
+
+private:
+    void updateClock();
+    bool shouldAnimate() const;
+
+    QString m_sheet;
+    QList<QRectF> m_frameRects;
+    int m_interval;
+    bool m_playing;
+    bool m_mirrored;
+    int m_frameIndex;
+    int m_lastTick;
+    bool m_subscribed;
+    QMetaObject::Connection m_windowConnection;
+};
+
+#endif // SPRITEITEM_H
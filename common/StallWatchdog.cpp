@@ -0,0 +1,213 @@
+#include "StallWatchdog.h"
+#include "Trace.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QVariantMap>
+#include <algorithm>
+
+StallWatchdog *StallWatchdog::instance()
+{
+    static StallWatchdog *watchdog = new StallWatchdog();
+    return watchdog;
+}
+
+StallWatchdog::StallWatchdog(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_running(false)
+    , m_sequence(0)
+    , m_acked(0)
+    , m_ackedAt(0)
+    , m_budgets({16, 50, 250, 1000})
+    , m_stallCount(0)
+    , m_worstStall(0)
+    , m_logPath(QDir::current().filePath("lcd_labs_stalls.log"))
+{
+    m_bucketCounts.fill(0, m_budgets.size());
+    // Trace::now() — общие часы для сторожа и трассировки
+    Trace::instance();
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    setEnabled(false);
+}
+
+void StallWatchdog::setEnabled(bool enabled)
+{
+    if (isEnabled() == enabled) return;
+
+    if (enabled) {
+        m_running = true;
+        const QList<int> currentBudgets = budgets();
+        m_thread = QThread::create([this, currentBudgets]() { run(currentBudgets); });
+        m_thread->setObjectName("StallWatchdog");
+        m_thread->start(QThread::HighPriority);
+        qDebug() << "Stall watchdog started, budgets (ms):" << currentBudgets;
+    } else {
+        m_running = false;
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+        QMutexLocker locker(&m_mutex);
+        m_log.close();
+    }
+    emit enabledChanged();
+}
+
+QList<int> StallWatchdog::budgets() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budgets;
+}
+
+void StallWatchdog::setBudgets(const QList<int> &budgets)
+{
+    QList<int> sorted;
+    for (int budget : budgets) {
+        if (budget > 0 && !sorted.contains(budget)) sorted.append(budget);
+    }
+    if (sorted.isEmpty()) return;
+    std::sort(sorted.begin(), sorted.end());
+
+    const bool wasEnabled = isEnabled();
+    setEnabled(false);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_budgets = sorted;
+        m_bucketCounts.fill(0, m_budgets.size());
+    }
+    setEnabled(wasEnabled);
+    emit statsChanged();
+}
+
+void StallWatchdog::setLogPath(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_log.close();
+    m_logPath = path;
+}
+
+int StallWatchdog::stallCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stallCount;
+}
+
+double StallWatchdog::worstStall() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_worstStall / 1e6;
+}
+
+QString StallWatchdog::lastCulprit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastCulprit;
+}
+
+QVariantList StallWatchdog::histogram() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantList result;
+    for (int i = 0; i < m_budgets.size(); ++i) {
+        QVariantMap bucket;
+        bucket["budget"] = m_budgets[i];
+        bucket["count"] = m_bucketCounts[i];
+        result.append(bucket);
+    }
+    return result;
+}
+
+void StallWatchdog::reset()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_bucketCounts.fill(0, m_budgets.size());
+        m_stallCount = 0;
+        m_worstStall = 0;
+        m_lastCulprit.clear();
+    }
+    emit statsChanged();
+}
+
+void StallWatchdog::run(QList<int> budgets)
+{
+    const qint64 minBudget = qint64(budgets.first()) * 1000 * 1000;
+
+    while (m_running) {
+        const quint64 sequence = ++m_sequence;
+        const qint64 postedAt = Trace::now();
+        QMetaObject::invokeMethod(this, [this, sequence]() {
+            m_ackedAt.store(Trace::now(), std::memory_order_relaxed);
+            m_acked.store(sequence, std::memory_order_release);
+        }, Qt::QueuedConnection);
+
+        // Пока ждём ответа дольше бюджета, смотрим, что выполняется в GUI
+        QHash<const char *, int> samples;
+        while (m_running && m_acked.load(std::memory_order_acquire) < sequence) {
+            QThread::msleep(SAMPLE_INTERVAL_MS);
+            if (Trace::now() - postedAt >= minBudget) {
+                ++samples[Trace::currentGuiOperation()];
+            }
+        }
+        if (!m_running) break;
+
+        const qint64 duration = m_ackedAt.load(std::memory_order_relaxed) - postedAt;
+        if (duration >= minBudget) {
+            const char *culprit = nullptr;
+            int best = 0;
+            for (auto it = samples.cbegin(); it != samples.cend(); ++it) {
+                if (it.key() && it.value() > best) {
+                    best = it.value();
+                    culprit = it.key();
+                }
+            }
+            recordStall(postedAt, duration, culprit);
+        }
+
+        QThread::msleep(PING_INTERVAL_MS);
+    }
+}
+
+void StallWatchdog::recordStall(qint64 postedAt, qint64 duration, const char *culprit)
+{
+    if (Trace::isEnabled()) {
+        Trace::complete("watchdog", culprit ? culprit : "GUI stall", postedAt, duration);
+    }
+
+    const QString culpritName = culprit ? QString::fromUtf8(culprit) : QString("неизвестно");
+    {
+        QMutexLocker locker(&m_mutex);
+        int bucket = -1;
+        for (int i = 0; i < m_budgets.size(); ++i) {
+            if (duration >= qint64(m_budgets[i]) * 1000 * 1000) bucket = i;
+        }
+        if (bucket < 0) return;
+
+        ++m_bucketCounts[bucket];
+        ++m_stallCount;
+        m_worstStall = qMax(m_worstStall, duration);
+        m_lastCulprit = culpritName;
+
+        if (!m_log.isOpen()) {
+            m_log.setFileName(m_logPath);
+            if (!m_log.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+                qWarning() << "Failed to open stall log:" << m_logPath;
+            }
+        }
+        if (m_log.isOpen()) {
+            m_log.write(QString("%1 stall %2 ms (>= %3 ms) in %4\n")
+                            .arg(QDateTime::currentDateTime().toString(Qt::ISODateWithMs))
+                            .arg(duration / 1e6, 0, 'f', 1)
+                            .arg(m_budgets[bucket])
+                            .arg(culpritName)
+                            .toUtf8());
+            m_log.flush();
+        }
+    }
+
+    QMetaObject::invokeMethod(this, &StallWatchdog::statsChanged, Qt::QueuedConnection);
+}
@@ -0,0 +1,77 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QFile>
+#include <QList>
+#include <QVariantList>
+#include <atomic>
+
+// Сторож зависаний потока GUI. Отдельный поток ставит в очередь GUI пинг и
+// ждёт ответа; если цикл событий не провернулся за наименьший бюджет,
+// зависание попадает в гистограмму и журнал вместе с операцией (TRACE_SCOPE),
+// которая чаще всего выполнялась на потоке GUI во время ожидания
+class StallWatchdog : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(int stallCount READ stallCount NOTIFY statsChanged)
+    Q_PROPERTY(double worstStall READ worstStall NOTIFY statsChanged)
+    Q_PROPERTY(QString lastCulprit READ lastCulprit NOTIFY statsChanged)
+    Q_PROPERTY(QVariantList histogram READ histogram NOTIFY statsChanged)
+
+public:
+    static StallWatchdog *instance();
+    ~StallWatchdog() override;
+
+    bool isEnabled() const { return m_thread != nullptr; }
+    void setEnabled(bool enabled);
+
+    // Пороги в миллисекундах по возрастанию, например 16, 50, 250
+    QList<int> budgets() const;
+    void setBudgets(const QList<int> &budgets);
+    void setLogPath(const QString &path);
+
+    int stallCount() const;
+    double worstStall() const;
+    QString lastCulprit() const;
+    QVariantList histogram() const;
+
+    Q_INVOKABLE void reset();
+
+signals:
+    void enabledChanged();
+    void statsChanged();
+
+private:
+    explicit StallWatchdog(QObject *parent = nullptr);
+
+    void run(QList<int> budgets);
+    void recordStall(qint64 postedAt, qint64 duration, const char *culprit);
+
+    static constexpr int PING_INTERVAL_MS = 10;
+    static constexpr int SAMPLE_INTERVAL_MS = 2;
+
+    QThread *m_thread;
+    std::atomic_bool m_running;
+    // Нумерация пингов продолжается между запусками: ответы на пинги
+    // прошлого запуска ещё могут стоять в очереди GUI и не должны
+    // засчитаться новому. m_sequence трогает только поток сторожа
+    quint64 m_sequence;
+    std::atomic<quint64> m_acked;
+    std::atomic<qint64> m_ackedAt;
+
+    // Всё ниже защищено m_mutex: пишет поток сторожа, читает GUI
+    mutable QMutex m_mutex;
+    QList<int> m_budgets;
+    QList<int> m_bucketCounts;
+    int m_stallCount;
+    qint64 m_worstStall;
+    QString m_lastCulprit;
+    QString m_logPath;
+    QFile m_log;
+};
+
+#endif // STALLWATCHDOG_H
@@ -0,0 +1,262 @@
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char *category;
+    const char *name;
+    QByteArray dynamicName;
+    char phase;
+    int tid;
+    qint64 timestamp;
+    qint64 duration;
+    double value;
+};
+
+// Около 64 МБ событий; дальше новые события отбрасываются и учитываются
+constexpr size_t MAX_EVENTS = 1000000;
+
+QElapsedTimer &traceClock()
+{
+    static QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock;
+}
+
+QMutex &traceMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+std::vector<TraceEvent> &traceEvents()
+{
+    static std::vector<TraceEvent> events;
+    return events;
+}
+
+QHash<int, QByteArray> &threadNames()
+{
+    static QHash<int, QByteArray> names;
+    return names;
+}
+
+size_t s_droppedEvents = 0;
+std::atomic_int s_nextThreadId(1);
+thread_local int t_threadId = 0;
+
+// Вызывается под traceMutex()
+int currentThreadId()
+{
+    if (t_threadId == 0) {
+        t_threadId = s_nextThreadId.fetch_add(1);
+        QByteArray name;
+        QThread *thread = QThread::currentThread();
+        if (thread && thread == QCoreApplication::instance()->thread()) {
+            name = "GUI";
+        } else if (thread && !thread->objectName().isEmpty()) {
+            name = thread->objectName().toUtf8();
+        } else {
+            name = "Поток " + QByteArray::number(t_threadId);
+        }
+        threadNames().insert(t_threadId, name);
+    }
+    return t_threadId;
+}
+
+void appendEvent(TraceEvent &&event)
+{
+    QMutexLocker locker(&traceMutex());
+    std::vector<TraceEvent> &events = traceEvents();
+    if (events.size() >= MAX_EVENTS) {
+        ++s_droppedEvents;
+        return;
+    }
+    event.tid = currentThreadId();
+    events.push_back(std::move(event));
+}
+
+void appendEscaped(QByteArray &out, const char *text)
+{
+    for (const char *c = text; *c; ++c) {
+        switch (*c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20) {
+                out += ' ';
+            } else {
+                out += *c;
+            }
+        }
+    }
+}
+
+void appendMicros(QByteArray &out, qint64 nanoseconds)
+{
+    out += QByteArray::number(nanoseconds / 1000);
+    out += '.';
+    out += QByteArray::number(nanoseconds % 1000).rightJustified(3, '0');
+}
+
+} // namespace
+
+std::atomic_bool Trace::s_enabled(false);
+std::atomic<const char *> Trace::s_guiOperation(nullptr);
+
+Trace *Trace::instance()
+{
+    static Trace *trace = new Trace();
+    return trace;
+}
+
+Trace::Trace(QObject *parent)
+    : QObject(parent)
+{
+    traceClock();
+    markGuiThread();
+}
+
+qint64 Trace::now()
+{
+    return traceClock().nsecsElapsed();
+}
+
+void Trace::complete(const char *category, const char *name, qint64 start, qint64 duration)
+{
+    appendEvent({category, name, QByteArray(), 'X', 0, start, duration, 0});
+}
+
+void Trace::counter(const char *name, double value)
+{
+    appendEvent({"counter", name, QByteArray(), 'C', 0, now(), 0, value});
+}
+
+void Trace::instant(const char *name)
+{
+    appendEvent({"mark", name, QByteArray(), 'i', 0, now(), 0, 0});
+}
+
+void Trace::beginSpan(const QString &name)
+{
+    if (!isEnabled()) return;
+    appendEvent({"qml", nullptr, name.toUtf8(), 'B', 0, now(), 0, 0});
+}
+
+void Trace::endSpan()
+{
+    if (!isEnabled()) return;
+    appendEvent({"qml", nullptr, QByteArray(), 'E', 0, now(), 0, 0});
+}
+
+void Trace::mark(const QString &name)
+{
+    if (!isEnabled()) return;
+    appendEvent({"qml", nullptr, name.toUtf8(), 'i', 0, now(), 0, 0});
+}
+
+void Trace::start()
+{
+    if (isEnabled()) return;
+
+    {
+        QMutexLocker locker(&traceMutex());
+        traceEvents().clear();
+        traceEvents().reserve(64 * 1024);
+        s_droppedEvents = 0;
+    }
+    s_enabled.store(true, std::memory_order_relaxed);
+    qDebug() << "Trace recording started";
+    emit recordingChanged();
+}
+
+QString Trace::stop(const QString &path)
+{
+    if (!isEnabled()) return QString();
+
+    s_enabled.store(false, std::memory_order_relaxed);
+    emit recordingChanged();
+
+    std::vector<TraceEvent> events;
+    QHash<int, QByteArray> names;
+    size_t dropped = 0;
+    {
+        QMutexLocker locker(&traceMutex());
+        events.swap(traceEvents());
+        names = threadNames();
+        dropped = s_droppedEvents;
+    }
+
+    QString fileName = path;
+    if (fileName.isEmpty()) {
+        fileName = QDir::current().filePath(
+            QString("lcd_labs_trace_%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+    }
+
+    QByteArray out;
+    out.reserve(qsizetype(events.size()) * 96 + 256);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for (auto it = names.cbegin(); it != names.cend(); ++it) {
+        if (!first) out += ",\n";
+        first = false;
+        out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":";
+        out += QByteArray::number(it.key());
+        out += ",\"args\":{\"name\":\"";
+        appendEscaped(out, it.value().constData());
+        out += "\"}}";
+    }
+
+    for (const TraceEvent &event : events) {
+        if (!first) out += ",\n";
+        first = false;
+        out += "{\"ph\":\"";
+        out += event.phase;
+        out += "\",\"cat\":\"";
+        appendEscaped(out, event.category);
+        out += "\",\"name\":\"";
+        appendEscaped(out, event.name ? event.name : event.dynamicName.constData());
+        out += "\",\"pid\":1,\"tid\":";
+        out += QByteArray::number(event.tid);
+        out += ",\"ts\":";
+        appendMicros(out, event.timestamp);
+        if (event.phase == 'X') {
+            out += ",\"dur\":";
+            appendMicros(out, event.duration);
+        } else if (event.phase == 'C') {
+            out += ",\"args\":{\"value\":";
+            out += QByteArray::number(event.value, 'g', 12);
+            out += '}';
+        } else if (event.phase == 'i') {
+            out += ",\"s\":\"t\"";
+        }
+        out += '}';
+    }
+    out += "\n]}\n";
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() || !file.commit()) {
+        qWarning() << "Failed to write trace:" << fileName << file.errorString();
+        return QString();
+    }
+
+    qDebug() << "Trace saved:" << fileName << events.size() << "events"
+             << (dropped ? QString("(%1 dropped)").arg(dropped) : QString());
+    return fileName;
+}
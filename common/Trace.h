@@ -0,0 +1,103 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+
+// Трассировка в формате Chrome trace-event (chrome://tracing, ui.perfetto.dev).
+// Пока запись выключена, TRACE_SCOPE и TRACE_COUNTER стоят одну атомарную
+// проверку (плюс запись имени операции на потоке GUI для сторожа зависаний);
+// имена событий — строковые литералы, они не копируются
+class Trace : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool recording READ isRecording NOTIFY recordingChanged)
+
+public:
+    static Trace *instance();
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static qint64 now();
+
+    static void complete(const char *category, const char *name, qint64 start, qint64 duration);
+    static void counter(const char *name, double value);
+    static void instant(const char *name);
+
+    // Самая вложенная TRACE_SCOPE, выполняющаяся сейчас на потоке GUI.
+    // Читается сторожем зависаний из своего потока
+    static const char *currentGuiOperation() { return s_guiOperation.load(std::memory_order_relaxed); }
+    static bool isGuiThread() { return t_guiThread; }
+    static void markGuiThread() { t_guiThread = true; }
+
+    bool isRecording() const { return isEnabled(); }
+
+    Q_INVOKABLE void start();
+    // Останавливает запись и сохраняет файл; пустой путь — файл с отметкой
+    // времени в текущей папке. Возвращает путь или пустую строку при ошибке
+    Q_INVOKABLE QString stop(const QString &path = QString());
+
+    // Для QML: вложенные интервалы на потоке GUI
+    Q_INVOKABLE void beginSpan(const QString &name);
+    Q_INVOKABLE void endSpan();
+    Q_INVOKABLE void mark(const QString &name);
+
+signals:
+    void recordingChanged();
+
+private:
+    explicit Trace(QObject *parent = nullptr);
+
+    static std::atomic_bool s_enabled;
+    static std::atomic<const char *> s_guiOperation;
+    static inline thread_local bool t_guiThread = false;
+
+    friend class TraceScope;
+};
+
+class TraceScope
+{
+public:
+    TraceScope(const char *category, const char *name)
+        : m_category(category)
+        , m_name(name)
+        , m_start(Trace::isEnabled() ? Trace::now() : -1)
+        , m_previous(nullptr)
+    {
+        if (Trace::t_guiThread) {
+            m_previous = Trace::s_guiOperation.load(std::memory_order_relaxed);
+            Trace::s_guiOperation.store(name, std::memory_order_relaxed);
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (Trace::t_guiThread) {
+            Trace::s_guiOperation.store(m_previous, std::memory_order_relaxed);
+        }
+        if (m_start >= 0) {
+            Trace::complete(m_category, m_name, m_start, Trace::now() - m_start);
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *m_category;
+    const char *m_name;
+    qint64 m_start;
+    const char *m_previous;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(category, name)
+#define TRACE_FUNCTION(category) TRACE_SCOPE(category, Q_FUNC_INFO)
+#define TRACE_COUNTER(name, value) \
+    do { if (Trace::isEnabled()) Trace::counter(name, double(value)); } while (0)
+#define TRACE_INSTANT(name) \
+    do { if (Trace::isEnabled()) Trace::instant(name); } while (0)
+
+#endif // TRACE_H
@@ -14,17 +14,39 @@
 
 static const GUID GUID_DEVCLASS_BATTERY = { 0x72631e54, 0x78a4, 0x11d0, { 0xbc, 0xf7, 0x00, 0xaa, 0x00, 0xb7, 0xb3, 0x2a } };
 
-PowerManager::PowerManager(QObject *parent) : QObject(parent)
+PowerManager::PowerManager(QObject *parent) : QObject(parent), m_active(false)
 {
     m_powerStatus = new SYSTEM_POWER_STATUS();
 
-    queryBatteryType();
-
     m_timer = new QTimer(this);
+    m_timer->setInterval(1000);
     connect(m_timer, &QTimer::timeout, this, &PowerManager::updatePowerInfo);
-    m_timer->start(1000);
+}
+
+void PowerManager::activate()
+{
+    if (m_active) return;
+
+    // Тип батареи не меняется за время работы, опрашиваем SetupAPI один раз
+    if (m_batteryType.isEmpty()) {
+        queryBatteryType();
+    }
 
     updatePowerInfo();
+    m_timer->start();
+
+    m_active = true;
+    emit activeChanged();
+}
+
+void PowerManager::suspend()
+{
+    if (!m_active) return;
+
+    m_timer->stop();
+
+    m_active = false;
+    emit activeChanged();
 }
 
 void PowerManager::updatePowerInfo()
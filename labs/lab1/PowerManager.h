@@ -15,10 +15,15 @@ class PowerManager : public QObject
     Q_PROPERTY(QString powerSavingMode READ powerSavingMode NOTIFY powerInfoChanged)
     Q_PROPERTY(QString batteryFullLifeTime READ batteryFullLifeTime NOTIFY powerInfoChanged)
     Q_PROPERTY(QString batteryLifeTime READ batteryLifeTime NOTIFY powerInfoChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
 
 public:
     explicit PowerManager(QObject *parent = nullptr);
 
+    // Опрос питания идёт только пока страница лабораторной на экране
+    Q_INVOKABLE void activate();
+    Q_INVOKABLE void suspend();
+
     Q_INVOKABLE void sleep();
     Q_INVOKABLE void hibernate();
 
@@ -28,9 +33,11 @@ public:
     QString powerSavingMode() const;
     QString batteryFullLifeTime() const;
     QString batteryLifeTime() const;
+    bool isActive() const { return m_active; }
 
 signals:
     void powerInfoChanged();
+    void activeChanged();
 
 private slots:
     void updatePowerInfo();
@@ -41,6 +48,7 @@ private:
     QTimer *m_timer;
     SYSTEM_POWER_STATUS *m_powerStatus;
     QString m_batteryType;
+    bool m_active;
 };
 
 #endif // POWERMANAGER_H
@@ -0,0 +1,140 @@
+#include "PciAgent.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace PciAgent {
+
+bool sameFunction(const Function &a, const Function &b, bool withHeaders)
+{
+    return a.record.vendorId == b.record.vendorId && a.record.deviceId == b.record.deviceId
+        && (!withHeaders || memcmp(a.header, b.header, sizeof(a.header)) == 0);
+}
+
+bool sameInventory(const Inventory &a, const Inventory &b, bool withHeaders)
+{
+    if (a.size() != b.size())
+        return false;
+    for (Inventory::const_iterator i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j) {
+        if (i->first != j->first || !sameFunction(i->second, j->second, withHeaders))
+            return false;
+    }
+    return true;
+}
+
+Inventory scanInventory(PciEnumerator &enumerator, PciEnumerator::Mode mode, bool withHeaders)
+{
+    Inventory inventory;
+    enumerator.setCaptureSize(withHeaders ? PciWire::CONFIG_HEADER_SIZE : 0);
+    enumerator.scan(mode, [&](const PciEnumerator::Function &function) {
+        Function &entry = inventory[functionKey(function.bus, function.device, function.function)];
+        entry.record.bus = function.bus;
+        entry.record.device = function.device;
+        entry.record.function = function.function;
+        entry.record.vendorId = function.vendorId;
+        entry.record.deviceId = function.deviceId;
+        memset(entry.header, 0xFF, sizeof(entry.header));
+        if (withHeaders)
+            memcpy(entry.header, function.config, std::min(function.configSize, sizeof(entry.header)));
+    });
+    return inventory;
+}
+
+bool verifyInventory(PciConfigAccess &config, const Inventory &inventory, bool withHeaders)
+{
+    PciWire::u8 header[PciWire::CONFIG_HEADER_SIZE];
+    for (Inventory::const_iterator it = inventory.begin(); it != inventory.end(); ++it) {
+        const PciWire::DeviceRecord &record = it->second.record;
+        if (withHeaders) {
+            memset(header, 0xFF, sizeof(header));
+            config.read(record.bus, record.device, record.function, header, sizeof(header));
+            if (memcmp(header, it->second.header, sizeof(header)) != 0)
+                return false;
+        } else {
+            const PciConfigAccess::u32 id = config.read32(record.bus, record.device, record.function, 0);
+            if (id != (PciConfigAccess::u32(record.deviceId) << 16 | record.vendorId))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Один проход по обоим упорядоченным снимкам
+static void diff(const Inventory &before, const Inventory &after, bool withHeaders,
+                 std::vector<const Function *> &changed, std::vector<PciWire::DeviceRecord> &removed)
+{
+    Inventory::const_iterator i = before.begin();
+    Inventory::const_iterator j = after.begin();
+    while (i != before.end() || j != after.end()) {
+        if (j == after.end() || (i != before.end() && i->first < j->first)) {
+            removed.push_back(i->second.record);
+            ++i;
+        } else if (i == before.end() || j->first < i->first) {
+            changed.push_back(&j->second);
+            ++j;
+        } else {
+            if (!sameFunction(i->second, j->second, withHeaders))
+                changed.push_back(&j->second);
+            ++i;
+            ++j;
+        }
+    }
+}
+
+void countChanges(const Inventory &before, const Inventory &after, bool withHeaders,
+                  size_t &changedCount, size_t &removedCount)
+{
+    std::vector<const Function *> changed;
+    std::vector<PciWire::DeviceRecord> removed;
+    diff(before, after, withHeaders, changed, removed);
+    changedCount = changed.size();
+    removedCount = removed.size();
+}
+
+static void appendFunctions(std::string &out, const std::vector<const Function *> &functions, bool withHeaders)
+{
+    if (functions.empty())
+        return;
+
+    std::vector<PciWire::DeviceRecord> records(functions.size());
+    std::vector<PciWire::u8> headers;
+    for (size_t i = 0; i < functions.size(); ++i) {
+        records[i] = functions[i]->record;
+        if (withHeaders)
+            headers.insert(headers.end(), functions[i]->header, functions[i]->header + PciWire::CONFIG_HEADER_SIZE);
+    }
+    PciWire::appendDevicesFrame(out, &records[0], records.size());
+    if (withHeaders)
+        PciWire::appendConfigHeadersFrame(out, &records[0], &headers[0], records.size());
+}
+
+std::string createFullInventory(const Inventory &inventory, bool withHeaders)
+{
+    std::vector<const Function *> functions;
+    for (Inventory::const_iterator it = inventory.begin(); it != inventory.end(); ++it)
+        functions.push_back(&it->second);
+
+    std::string out;
+    appendFunctions(out, functions, withHeaders);
+    PciWire::appendEndFrame(out);
+    return out;
+}
+
+std::string createDelta(const Inventory &before, const Inventory &after, bool withHeaders,
+                        size_t &changedCount, size_t &removedCount)
+{
+    std::vector<const Function *> changed;
+    std::vector<PciWire::DeviceRecord> removed;
+    diff(before, after, withHeaders, changed, removed);
+
+    changedCount = changed.size();
+    removedCount = removed.size();
+    std::string out;
+    appendFunctions(out, changed, withHeaders);
+    if (!removed.empty())
+        PciWire::appendRemovedFrame(out, &removed[0], removed.size());
+    PciWire::appendDeltaEndFrame(out);
+    return out;
+}
+
+} // namespace PciAgent
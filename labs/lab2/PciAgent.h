@@ -0,0 +1,51 @@
+#ifndef PCIAGENT_H
+#define PCIAGENT_H
+
+// Инвентаризация резидентного агента сканера (--agent): снимок функций,
+// быстрая перепроверка известных функций и изменения между снимками в
+// кадрах PciWire. Без Qt, сокетов и таймеров — их ведёт main.cpp.
+
+#include "PciConfigAccess.h"
+#include "PciEnumerator.h"
+#include "PciWireFormat.h"
+#include <map>
+#include <string>
+
+namespace PciAgent {
+
+struct Function {
+    PciWire::DeviceRecord record;
+    // Первые 64 байта пространства; без заголовков — 0xFF
+    PciWire::u8 header[PciWire::CONFIG_HEADER_SIZE];
+};
+
+// Ключ bus << 8 | device << 3 | function
+typedef std::map<int, Function> Inventory;
+
+inline int functionKey(int bus, int device, int function)
+{
+    return (bus << 8) | (device << 3) | function;
+}
+
+bool sameFunction(const Function &a, const Function &b, bool withHeaders);
+bool sameInventory(const Inventory &a, const Inventory &b, bool withHeaders);
+
+Inventory scanInventory(PciEnumerator &enumerator, PciEnumerator::Mode mode, bool withHeaders);
+
+// Быстрая проверка: перечитываются только известные функции, по одному
+// чтению на функцию. false — что-то исчезло или изменилось
+bool verifyInventory(PciConfigAccess &config, const Inventory &inventory, bool withHeaders);
+
+// Добавленные и изменившиеся функции, удалённые функции от before к after
+void countChanges(const Inventory &before, const Inventory &after, bool withHeaders,
+                  size_t &changedCount, size_t &removedCount);
+
+// Полная инвентаризация до FRAME_END
+std::string createFullInventory(const Inventory &inventory, bool withHeaders);
+// Изменения от before к after до FRAME_DELTA_END
+std::string createDelta(const Inventory &before, const Inventory &after, bool withHeaders,
+                        size_t &changedCount, size_t &removedCount);
+
+} // namespace PciAgent
+
+#endif // PCIAGENT_H
@@ -0,0 +1,440 @@
+#include "PciConfigAccess.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+typedef PciConfigAccess::u8 u8;
+typedef PciConfigAccess::u16 u16;
+typedef PciConfigAccess::u32 u32;
+
+static u32 functionKey(u8 bus, u8 device, u8 function)
+{
+    return (u32(bus) << 8) | (u32(device & 0x1F) << 3) | (function & 0x07);
+}
+
+static u32 readLe32(const u8 *data)
+{
+    return u32(data[0]) | (u32(data[1]) << 8) | (u32(data[2]) << 16) | (u32(data[3]) << 24);
+}
+
+size_t PciConfigAccess::read(u8 bus, u8 device, u8 function, u8 *buffer, size_t size)
+{
+    size &= ~size_t(3);
+    for (size_t offset = 0; offset < size; offset += 4) {
+        const u32 value = read32(bus, device, function, u16(offset));
+        if (offset == 0 && (value & 0xFFFF) == 0xFFFF) return 0;
+        buffer[offset] = u8(value);
+        buffer[offset + 1] = u8(value >> 8);
+        buffer[offset + 2] = u8(value >> 16);
+        buffer[offset + 3] = u8(value >> 24);
+    }
+    return size;
+}
+
+#ifdef _WIN32
+
+// Механизм конфигурации №1: адрес в 0xCF8, данные из 0xCFC
+class WinIoConfigAccess : public PciConfigAccess
+{
+public:
+    WinIoConfigAccess() : m_dll(0), m_shutdown(0), m_outPort(0), m_inPort(0) {}
+    ~WinIoConfigAccess() { close(); }
+
+    const char *name() const { return "winio"; }
+
+    bool open(std::string &error)
+    {
+        const char *dllPath = "C:\\WinIo\\Binaries\\WinIo32.dll";
+        const char *sysPath = "C:\\WinIo\\Binaries\\WinIo32.sys";
+
+        if (GetFileAttributesA(dllPath) == INVALID_FILE_ATTRIBUTES) {
+            error = std::string(dllPath) + " not found!\n"
+                    "Please create folder C:\\WinIo\\Binaries\\ and copy WinIo32.dll there";
+            return false;
+        }
+        if (GetFileAttributesA(sysPath) == INVALID_FILE_ATTRIBUTES) {
+            error = std::string(sysPath) + " not found!\n"
+                    "Please copy WinIo32.sys to C:\\WinIo\\Binaries\\";
+            return false;
+        }
+
+        m_dll = LoadLibraryA(dllPath);
+        if (!m_dll) {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "%lu", (unsigned long)GetLastError());
+            error = std::string("Failed to load WinIo32.dll. Error: ") + buf;
+            return false;
+        }
+
+        FnInit initLib = (FnInit)GetProcAddress(m_dll, "InitializeWinIo");
+        m_shutdown = (FnShutdown)GetProcAddress(m_dll, "ShutdownWinIo");
+        m_inPort = (FnInPort)GetProcAddress(m_dll, "GetPortVal");
+        m_outPort = (FnOutPort)GetProcAddress(m_dll, "SetPortVal");
+        if (!initLib || !m_shutdown || !m_inPort || !m_outPort) {
+            error = "Failed to get WinIo functions";
+            FreeLibrary(m_dll);
+            m_dll = 0;
+            return false;
+        }
+
+        if (!initLib()) {
+            error = "WinIo initialization failed!\n"
+                    "Make sure:\n"
+                    "1. You run as Administrator\n"
+                    "2. WinIo32.sys is in C:\\WinIo\\Binaries\\\n"
+                    "3. VMware IO settings are correct";
+            FreeLibrary(m_dll);
+            m_dll = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (!m_dll) return;
+        m_shutdown();
+        FreeLibrary(m_dll);
+        m_dll = 0;
+    }
+
+    u32 read32(u8 bus, u8 device, u8 function, u16 offset)
+    {
+        // Через порты доступны только первые 256 байт
+        if (!m_dll || offset >= 256) return 0xFFFFFFFF;
+
+        DWORD cfgAddr = (1UL << 31) | ((DWORD)bus << 16)
+                      | ((DWORD)(device & 0x1F) << 11) | ((DWORD)(function & 0x07) << 8)
+                      | (offset & 0xFC);
+        if (!m_outPort(0xCF8, cfgAddr, 4))
+            return 0xFFFFFFFF;
+
+        DWORD cfgData = 0xFFFFFFFF;
+        if (!m_inPort(0xCFC, &cfgData, 4))
+            return 0xFFFFFFFF;
+        return cfgData;
+    }
+
+    // Пара обращений к портам на двойное слово, быстрее не бывает
+    size_t read(u8 bus, u8 device, u8 function, u8 *buffer, size_t size)
+    {
+        return PciConfigAccess::read(bus, device, function, buffer, size < CONFIG_SPACE_SIZE ? size : CONFIG_SPACE_SIZE);
+    }
+
+private:
+    typedef BOOL (__stdcall *FnInit)();
+    typedef void (__stdcall *FnShutdown)();
+    typedef BOOL (__stdcall *FnOutPort)(WORD, DWORD, BYTE);
+    typedef BOOL (__stdcall *FnInPort)(WORD, PDWORD, BYTE);
+
+    HMODULE m_dll;
+    FnShutdown m_shutdown;
+    FnOutPort m_outPort;
+    FnInPort m_inPort;
+};
+
+#endif // _WIN32
+
+#ifdef __linux__
+
+// Файл config каждой функции открывается один раз и читается pread.
+// Без root ядро отдаёт только первые 64 байта, дальше чтение короткое
+class SysfsConfigAccess : public PciConfigAccess
+{
+public:
+    explicit SysfsConfigAccess(const std::string &root)
+        : m_root(root.empty() ? "/sys/bus/pci/devices" : root), m_procfs(false) {}
+    ~SysfsConfigAccess() { close(); }
+
+    const char *name() const { return "sysfs"; }
+
+    bool open(std::string &error)
+    {
+        if (access(m_root.c_str(), R_OK | X_OK) == 0) {
+            m_procfs = false;
+            return true;
+        }
+        if (access("/proc/bus/pci", R_OK | X_OK) == 0) {
+            m_procfs = true;
+            return true;
+        }
+        error = "Neither " + m_root + " nor /proc/bus/pci is readable";
+        return false;
+    }
+
+    void close()
+    {
+        for (std::map<u32, int>::iterator it = m_files.begin(); it != m_files.end(); ++it) {
+            if (it->second >= 0) ::close(it->second);
+        }
+        m_files.clear();
+    }
+
+    // Открытые файлы читают живые данные; файл удалённой функции
+    // закрывает первое неудачное чтение. Здесь забываем отсутствующие
+    void refresh()
+    {
+        for (std::map<u32, int>::iterator it = m_files.begin(); it != m_files.end();) {
+            if (it->second < 0) m_files.erase(it++);
+            else ++it;
+        }
+    }
+
+    u32 read32(u8 bus, u8 device, u8 function, u16 offset)
+    {
+        const int fd = file(bus, device, function);
+        if (fd < 0) return 0xFFFFFFFF;
+
+        u8 data[4];
+        if (pread(fd, data, sizeof(data), offset & ~3) != (ssize_t)sizeof(data)) {
+            forget(bus, device, function);
+            return 0xFFFFFFFF;
+        }
+        return readLe32(data);
+    }
+
+    size_t read(u8 bus, u8 device, u8 function, u8 *buffer, size_t size)
+    {
+        const int fd = file(bus, device, function);
+        if (fd < 0) return 0;
+
+        const ssize_t n = pread(fd, buffer, size, 0);
+        if (n <= 0) {
+            forget(bus, device, function);
+            return 0;
+        }
+        return size_t(n);
+    }
+
+private:
+    // Файл удалённой функции больше не читается, даже если на её место
+    // встала новая: закрываем, следующее обращение откроет путь заново
+    void forget(u8 bus, u8 device, u8 function)
+    {
+        std::map<u32, int>::iterator it = m_files.find(functionKey(bus, device, function));
+        if (it == m_files.end()) return;
+        if (it->second >= 0) ::close(it->second);
+        m_files.erase(it);
+    }
+
+    int file(u8 bus, u8 device, u8 function)
+    {
+        const u32 key = functionKey(bus, device, function);
+        std::map<u32, int>::iterator it = m_files.find(key);
+        if (it != m_files.end()) return it->second;
+
+        char path[64];
+        if (m_procfs) {
+            snprintf(path, sizeof(path), "/proc/bus/pci/%02x/%02x.%x", bus, device & 0x1F, function & 0x07);
+        } else {
+            snprintf(path, sizeof(path), "/0000:%02x:%02x.%x/config", bus, device & 0x1F, function & 0x07);
+        }
+        // Отсутствующие функции тоже запоминаются, чтобы не открывать их повторно
+        const int fd = ::open(m_procfs ? path : (m_root + path).c_str(), O_RDONLY | O_CLOEXEC);
+        m_files[key] = fd;
+        return fd;
+    }
+
+    std::string m_root;
+    bool m_procfs;
+    std::map<u32, int> m_files;
+};
+
+#endif // __linux__
+
+// Файл функции читается целиком при первом обращении
+class FakeConfigAccess : public PciConfigAccess
+{
+public:
+    explicit FakeConfigAccess(const std::string &root) : m_root(root) {}
+
+    const char *name() const { return "fake"; }
+
+    bool open(std::string &error)
+    {
+        if (m_root.empty()) {
+            error = "The fake backend needs --root <directory>";
+            return false;
+        }
+        m_functions.clear();
+        return true;
+    }
+
+    void close() { m_functions.clear(); }
+    void refresh() { m_functions.clear(); }
+
+    u32 read32(u8 bus, u8 device, u8 function, u16 offset)
+    {
+        const std::vector<u8> &config = load(bus, device, function);
+        offset &= ~3;
+        if (size_t(offset) + 4 > config.size()) return 0xFFFFFFFF;
+        return readLe32(&config[offset]);
+    }
+
+    size_t read(u8 bus, u8 device, u8 function, u8 *buffer, size_t size)
+    {
+        const std::vector<u8> &config = load(bus, device, function);
+        if (size > config.size()) size = config.size();
+        if (size > 0) memcpy(buffer, &config[0], size);
+        return size;
+    }
+
+private:
+    const std::vector<u8> &load(u8 bus, u8 device, u8 function)
+    {
+        const u32 key = functionKey(bus, device, function);
+        std::map<u32, std::vector<u8> >::iterator it = m_functions.find(key);
+        if (it != m_functions.end()) return it->second;
+
+        std::vector<u8> &config = m_functions[key];
+        char name[16];
+        snprintf(name, sizeof(name), "/%02x_%02x_%x", bus, device & 0x1F, function & 0x07);
+        FILE *file = fopen((m_root + name).c_str(), "rb");
+        if (file) {
+            config.resize(4096);
+            config.resize(fread(&config[0], 1, config.size(), file));
+            fclose(file);
+        }
+        return config;
+    }
+
+    std::string m_root;
+    std::map<u32, std::vector<u8> > m_functions;
+};
+
+// Образ ECAM отображается целиком; шины за концом файла считаются пустыми
+class EcamConfigAccess : public PciConfigAccess
+{
+public:
+    explicit EcamConfigAccess(const std::string &path) : m_path(path), m_data(0), m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE), m_mapping(0)
+#endif
+    {}
+    ~EcamConfigAccess() { close(); }
+
+    const char *name() const { return "ecam"; }
+
+    bool open(std::string &error)
+    {
+        close();
+        if (m_path.empty()) {
+            error = "The ecam backend needs --root <image file>";
+            return false;
+        }
+#ifdef _WIN32
+        m_file = CreateFileA(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+        LARGE_INTEGER size;
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+            error = "Cannot open ECAM image " + m_path;
+            close();
+            return false;
+        }
+        m_mapping = CreateFileMappingA(m_file, 0, PAGE_READONLY, 0, 0, 0);
+        m_data = m_mapping ? static_cast<const u8 *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : 0;
+        m_size = size_t(size.QuadPart);
+#else
+        const int fd = ::open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+            error = "Cannot open ECAM image " + m_path;
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+        void *data = mmap(0, size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        m_data = data == MAP_FAILED ? 0 : static_cast<const u8 *>(data);
+        m_size = size_t(info.st_size);
+#endif
+        if (!m_data) {
+            error = "Cannot map ECAM image " + m_path;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = 0;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) munmap(const_cast<u8 *>(m_data), m_size);
+#endif
+        m_data = 0;
+        m_size = 0;
+    }
+
+    u32 read32(u8 bus, u8 device, u8 function, u16 offset)
+    {
+        const size_t base = functionOffset(bus, device, function);
+        offset &= 0xFFC;
+        if (!m_data || base + offset + 4 > m_size) return 0xFFFFFFFF;
+        return readLe32(m_data + base + offset);
+    }
+
+    size_t read(u8 bus, u8 device, u8 function, u8 *buffer, size_t size)
+    {
+        const size_t base = functionOffset(bus, device, function);
+        if (!m_data || base + 4 > m_size) return 0;
+        if (size > EXTENDED_CONFIG_SPACE_SIZE) size = EXTENDED_CONFIG_SPACE_SIZE;
+        if (base + size > m_size) size = m_size - base;
+        memcpy(buffer, m_data + base, size);
+        return size;
+    }
+
+    static size_t functionOffset(u8 bus, u8 device, u8 function)
+    {
+        return (size_t(bus) << 20) | (size_t(device & 0x1F) << 15) | (size_t(function & 0x07) << 12);
+    }
+
+private:
+    std::string m_path;
+    const u8 *m_data;
+    size_t m_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+};
+
+PciConfigAccess *PciConfigAccess::create(const std::string &backend, const std::string &root, std::string &error)
+{
+#ifdef _WIN32
+    if (backend == "winio") return new WinIoConfigAccess();
+#endif
+#ifdef __linux__
+    if (backend == "sysfs") return new SysfsConfigAccess(root);
+#endif
+    if (backend == "fake") return new FakeConfigAccess(root);
+    if (backend == "ecam") return new EcamConfigAccess(root);
+
+    error = "Backend '" + backend + "' is not supported on this platform";
+    return 0;
+}
+
+const char *PciConfigAccess::defaultBackend()
+{
+#ifdef _WIN32
+    return "winio";
+#elif defined(__linux__)
+    return "sysfs";
+#else
+    return "fake";
+#endif
+}
@@ -0,0 +1,53 @@
+#ifndef PCICONFIGACCESS_H
+#define PCICONFIGACCESS_H
+
+// Доступ сканера к конфигурационному пространству PCI. Без Qt: сканер
+// собирается и под Windows XP, и под Linux.
+//   winio  — порты 0xCF8/0xCFC через WinIo32.dll (только Windows)
+//   sysfs  — /sys/bus/pci/devices/*/config, иначе /proc/bus/pci (Linux)
+//   fake   — каталог с файлами "BB_DD_F" (шестнадцатеричные номера), в каждом
+//            сырое конфигурационное пространство функции; для тестов и замеров
+//   ecam   — файл-образ области ECAM: по 4 КиБ на функцию по смещению
+//            bus << 20 | device << 15 | function << 12, отображается в память
+
+#include <stddef.h>
+#include <string>
+
+class PciConfigAccess
+{
+public:
+    typedef unsigned char u8;
+    typedef unsigned short u16;
+    typedef unsigned int u32;
+
+    static const size_t CONFIG_SPACE_SIZE = 256;
+    static const size_t EXTENDED_CONFIG_SPACE_SIZE = 4096;
+
+    virtual ~PciConfigAccess() {}
+
+    virtual const char *name() const = 0;
+    // false — доступ получить не удалось, причина в error
+    virtual bool open(std::string &error) = 0;
+    virtual void close() {}
+    // Забыть закешированное: содержимое и отсутствие функций. Нужно перед
+    // повторным обходом, чтобы увидеть появившиеся и изменившиеся функции
+    virtual void refresh() {}
+
+    // Выровненное двойное слово; 0xFFFFFFFF — функции нет или чтение
+    // не удалось, как у отсутствующего устройства на шине
+    virtual u32 read32(u8 bus, u8 device, u8 function, u16 offset) = 0;
+
+    // Первые size байт пространства функции за одно обращение: pread файла
+    // config, копия из отображённого образа. Возвращает число прочитанных
+    // байт, 0 — функции нет. По умолчанию собирается из read32 и
+    // останавливается на первом двойном слове, если функции нет
+    virtual size_t read(u8 bus, u8 device, u8 function, u8 *buffer, size_t size);
+
+    // Бэкенд по имени (winio, sysfs, fake, ecam); root — каталог для sysfs
+    // и fake или файл образа для ecam, пустой — по умолчанию. 0, если бэкенд не поддерживается на этой платформе
+    static PciConfigAccess *create(const std::string &backend, const std::string &root, std::string &error);
+    // Бэкенд по умолчанию для платформы
+    static const char *defaultBackend();
+};
+
+#endif // PCICONFIGACCESS_H
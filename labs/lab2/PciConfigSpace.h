@@ -0,0 +1,210 @@
+#ifndef PCICONFIGSPACE_H
+#define PCICONFIGSPACE_H
+
+// Разбор снятого целиком конфигурационного пространства функции PCI:
+// класс, тип заголовка, BAR и списки capability. Без Qt, работает по
+// буферу в памяти и не обращается к устройству.
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+namespace PciConfig {
+
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+typedef unsigned long long u64;
+
+const u8 HEADER_TYPE_NORMAL = 0x00;
+const u8 HEADER_TYPE_PCI_BRIDGE = 0x01;
+const u8 HEADER_TYPE_CARDBUS_BRIDGE = 0x02;
+const u8 HEADER_MULTIFUNCTION = 0x80;
+
+const u16 STATUS_CAPABILITIES = 0x0010;
+
+struct Bar {
+    u8 index;
+    bool io;
+    bool is64;
+    bool prefetchable;
+    u64 address;
+};
+
+struct Capability {
+    u16 id;
+    u16 offset;
+    bool extended;      // из расширенного пространства (с 0x100)
+};
+
+struct Info {
+    u16 vendorId;
+    u16 deviceId;
+    u16 command;
+    u16 status;
+    u8 revision;
+    u8 progIf;
+    u8 subclass;
+    u8 classCode;
+    u8 headerType;          // без бита многофункциональности
+    bool multifunction;
+    u16 subsystemVendorId;  // только у заголовка типа 0
+    u16 subsystemId;
+    u8 secondaryBus;        // только у мостов
+    u8 subordinateBus;
+    std::vector<Bar> bars;
+    std::vector<Capability> capabilities;
+};
+
+inline u16 get16(const u8 *data, size_t offset)
+{
+    return u16(data[offset] | (data[offset + 1] << 8));
+}
+
+inline u32 get32(const u8 *data, size_t offset)
+{
+    return u32(data[offset]) | (u32(data[offset + 1]) << 8) | (u32(data[offset + 2]) << 16)
+           | (u32(data[offset + 3]) << 24);
+}
+
+// Заданные BAR; 64-битный BAR занимает два слота и записывается один раз
+inline void decodeBars(const u8 *config, size_t size, int count, std::vector<Bar> &bars)
+{
+    for (int i = 0; i < count; ++i) {
+        const size_t offset = 0x10 + size_t(i) * 4;
+        if (offset + 4 > size) break;
+
+        const u32 low = get32(config, offset);
+        Bar bar;
+        bar.index = u8(i);
+        bar.io = (low & 0x1) != 0;
+        bar.is64 = !bar.io && ((low >> 1) & 0x3) == 0x2;
+        bar.prefetchable = !bar.io && (low & 0x8) != 0;
+        bar.address = bar.io ? (low & ~u32(0x3)) : (low & ~u32(0xF));
+        if (bar.is64 && i + 1 < count && offset + 8 <= size) {
+            bar.address |= u64(get32(config, offset + 4)) << 32;
+            ++i;
+        }
+        if (bar.address != 0) bars.push_back(bar);
+    }
+}
+
+// Списки capability с защитой от петель и указателей за пределы буфера:
+// каждое двойное слово пространства посещается не больше одного раза,
+// указатель на уже пройденную capability (в том числе на саму себя)
+// завершает список
+inline void decodeCapabilities(const u8 *config, size_t size, u16 status, u8 headerType,
+                               std::vector<Capability> &capabilities)
+{
+    bool visited[4096 / 4] = {};
+
+    if ((status & STATUS_CAPABILITIES) && size >= 0x40) {
+        const size_t pointerOffset = headerType == HEADER_TYPE_CARDBUS_BRIDGE ? 0x14 : 0x34;
+        size_t offset = config[pointerOffset] & 0xFC;
+        while (offset >= 0x40 && offset + 2 <= size && !visited[offset / 4]) {
+            visited[offset / 4] = true;
+            Capability capability;
+            capability.id = config[offset];
+            capability.offset = u16(offset);
+            capability.extended = false;
+            capabilities.push_back(capability);
+            offset = config[offset + 1] & 0xFC;
+        }
+    }
+
+    // Расширенные: заголовок id:16 version:4 next:12, первый всегда на 0x100
+    size_t offset = 0x100;
+    while (offset >= 0x100 && offset + 4 <= size && !visited[offset / 4]) {
+        visited[offset / 4] = true;
+        const u32 header = get32(config, offset);
+        if (header == 0 || header == 0xFFFFFFFF) break;
+        Capability capability;
+        capability.id = u16(header & 0xFFFF);
+        capability.offset = u16(offset);
+        capability.extended = true;
+        capabilities.push_back(capability);
+        offset = (header >> 20) & 0xFFC;
+    }
+}
+
+// false — в буфере нет даже стандартного заголовка или функции нет
+inline bool decode(const u8 *config, size_t size, Info &info)
+{
+    if (size < 0x40) return false;
+
+    info.vendorId = get16(config, 0x00);
+    if (info.vendorId == 0xFFFF || info.vendorId == 0x0000) return false;
+    info.deviceId = get16(config, 0x02);
+    info.command = get16(config, 0x04);
+    info.status = get16(config, 0x06);
+    info.revision = config[0x08];
+    info.progIf = config[0x09];
+    info.subclass = config[0x0A];
+    info.classCode = config[0x0B];
+    info.headerType = config[0x0E] & 0x7F;
+    info.multifunction = (config[0x0E] & HEADER_MULTIFUNCTION) != 0;
+    info.subsystemVendorId = 0;
+    info.subsystemId = 0;
+    info.secondaryBus = 0;
+    info.subordinateBus = 0;
+    info.bars.clear();
+    info.capabilities.clear();
+
+    int barCount = 0;
+    if (info.headerType == HEADER_TYPE_NORMAL) {
+        barCount = 6;
+        info.subsystemVendorId = get16(config, 0x2C);
+        info.subsystemId = get16(config, 0x2E);
+    } else if (info.headerType == HEADER_TYPE_PCI_BRIDGE) {
+        barCount = 2;
+        info.secondaryBus = config[0x19];
+        info.subordinateBus = config[0x1A];
+    } else if (info.headerType == HEADER_TYPE_CARDBUS_BRIDGE) {
+        barCount = 1;
+        info.secondaryBus = config[0x19];
+        info.subordinateBus = config[0x1A];
+    }
+    decodeBars(config, size, barCount, info.bars);
+    decodeCapabilities(config, size, info.status, info.headerType, info.capabilities);
+    return true;
+}
+
+// Короткое имя capability; 0, если неизвестна
+inline const char *capabilityName(const Capability &capability)
+{
+    if (!capability.extended) {
+        switch (capability.id) {
+        case 0x01: return "PM";
+        case 0x05: return "MSI";
+        case 0x09: return "Vendor";
+        case 0x0D: return "SSVID";
+        case 0x10: return "PCIe";
+        case 0x11: return "MSI-X";
+        case 0x12: return "SATA";
+        case 0x13: return "AF";
+        }
+        return 0;
+    }
+    switch (capability.id) {
+    case 0x0001: return "AER";
+    case 0x0002: return "VC";
+    case 0x0003: return "DSN";
+    case 0x0004: return "PowerBudget";
+    case 0x000B: return "VSEC";
+    case 0x000D: return "ACS";
+    case 0x000E: return "ARI";
+    case 0x0010: return "SR-IOV";
+    case 0x0015: return "ResizableBAR";
+    case 0x0018: return "LTR";
+    case 0x0019: return "SecondaryPCIe";
+    case 0x001E: return "L1PM";
+    case 0x0023: return "DVSEC";
+    case 0x0025: return "DataLink";
+    case 0x0026: return "16GT";
+    }
+    return 0;
+}
+
+} // namespace PciConfig
+
+#endif // PCICONFIGSPACE_H
@@ -0,0 +1,46 @@
+#include "PciDelta.h"
+#include <algorithm>
+
+namespace PciDelta {
+
+static bool keyLess(const PciDevice &a, const PciDevice &b)
+{
+    return key(a) < key(b);
+}
+
+void apply(QList<PciDevice> &base, const QList<PciDevice> &changed, const QList<int> &removed)
+{
+    for (int removedKey : removed) {
+        PciDevice probe;
+        probe.bus = quint8(removedKey >> 8);
+        probe.device = quint8((removedKey >> 3) & 0x1F);
+        probe.function = quint8(removedKey & 0x07);
+        auto it = std::lower_bound(base.begin(), base.end(), probe, keyLess);
+        if (it != base.end() && key(*it) == removedKey) base.erase(it);
+    }
+    for (const PciDevice &device : changed) {
+        auto it = std::lower_bound(base.begin(), base.end(), device, keyLess);
+        if (it != base.end() && key(*it) == key(device)) {
+            *it = device;
+        } else {
+            base.insert(it, device);
+        }
+    }
+}
+
+void merge(QList<PciDevice> &changed, QList<int> &removed,
+           const QList<PciDevice> &nextChanged, const QList<int> &nextRemoved)
+{
+    for (int removedKey : nextRemoved) {
+        changed.removeIf([removedKey](const PciDevice &device) { return key(device) == removedKey; });
+        if (!removed.contains(removedKey)) removed.append(removedKey);
+    }
+    for (const PciDevice &device : nextChanged) {
+        const int changedKey = key(device);
+        removed.removeOne(changedKey);
+        changed.removeIf([changedKey](const PciDevice &other) { return key(other) == changedKey; });
+        changed.append(device);
+    }
+}
+
+} // namespace PciDelta
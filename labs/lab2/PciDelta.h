@@ -0,0 +1,27 @@
+#ifndef PCIDELTA_H
+#define PCIDELTA_H
+
+#include <QList>
+#include "PciStreamParser.h"
+
+// Изменения агента (FLAG_DELTAS) на стороне сервера. changed — добавленные
+// и изменившиеся функции, removed — ключи удалённых
+namespace PciDelta {
+
+// bus << 8 | device << 3 | function
+inline int key(const PciDevice &device)
+{
+    return (device.bus << 8) | (device.device << 3) | device.function;
+}
+
+// base упорядочен по key() и остаётся упорядоченным
+void apply(QList<PciDevice> &base, const QList<PciDevice> &changed, const QList<int> &removed);
+
+// Несколько изменений подряд в одно: функция, удалённая и снова
+// появившаяся, остаётся только в changed, и наоборот
+void merge(QList<PciDevice> &changed, QList<int> &removed,
+           const QList<PciDevice> &nextChanged, const QList<int> &nextRemoved);
+
+} // namespace PciDelta
+
+#endif // PCIDELTA_H
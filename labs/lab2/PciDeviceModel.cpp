@@ -0,0 +1,168 @@
+#include "PciDeviceModel.h"
+#include "PciIdDatabase.h"
+#include <algorithm>
+
+PciDeviceModel::PciDeviceModel(const StringPool *strings, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_strings(strings)
+{
+}
+
+int PciDeviceModel::compareKeys(const Row &a, const Row &b) const
+{
+    if (a.host != b.host) {
+        const int byHost = m_strings->view(a.host).compare(m_strings->view(b.host));
+        if (byHost != 0) return byHost;
+    }
+    return a.record.key() - b.record.key();
+}
+
+void PciDeviceModel::setRows(const QList<Row> &rows)
+{
+    const int oldCount = m_rows.size();
+    qsizetype i = 0;
+    qsizetype j = 0;
+
+    // Слияние двух упорядоченных списков; соседние вставки, удаления и
+    // изменения отдаются представлению одним диапазоном
+    while (i < m_rows.size() || j < rows.size()) {
+        if (j >= rows.size() || (i < m_rows.size() && compareKeys(m_rows[i], rows[j]) < 0)) {
+            qsizetype last = i;
+            while (last + 1 < m_rows.size()
+                   && (j >= rows.size() || compareKeys(m_rows[last + 1], rows[j]) < 0)) {
+                ++last;
+            }
+            beginRemoveRows(QModelIndex(), int(i), int(last));
+            m_rows.remove(i, last - i + 1);
+            endRemoveRows();
+        } else if (i >= m_rows.size() || compareKeys(rows[j], m_rows[i]) < 0) {
+            qsizetype last = j;
+            while (last + 1 < rows.size()
+                   && (i >= m_rows.size() || compareKeys(rows[last + 1], m_rows[i]) < 0)) {
+                ++last;
+            }
+            beginInsertRows(QModelIndex(), int(i), int(i + last - j));
+            m_rows.insert(i, last - j + 1, Row());
+            std::copy(rows.cbegin() + j, rows.cbegin() + last + 1, m_rows.begin() + i);
+            endInsertRows();
+            i += last - j + 1;
+            j = last + 1;
+        } else {
+            const qsizetype first = i;
+            while (i < m_rows.size() && j < rows.size()
+                   && compareKeys(m_rows[i], rows[j]) == 0
+                   && !(m_rows[i].record == rows[j].record)) {
+                m_rows[i] = rows[j];
+                ++i;
+                ++j;
+            }
+            if (i > first) {
+                emit dataChanged(index(int(first)), index(int(i - 1)));
+            } else {
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    if (m_rows.size() != oldCount) {
+        emit countChanged();
+    }
+}
+
+qsizetype PciDeviceModel::lowerBound(const Row &row) const
+{
+    const auto it = std::lower_bound(m_rows.cbegin(), m_rows.cend(), row, [this](const Row &a, const Row &b) {
+        return compareKeys(a, b) < 0;
+    });
+    return it - m_rows.cbegin();
+}
+
+void PciDeviceModel::updateRows(const QList<Row> &changed, const QList<Row> &removed)
+{
+    const int oldCount = m_rows.size();
+
+    for (const Row &row : removed) {
+        const qsizetype i = lowerBound(row);
+        if (i == m_rows.size() || compareKeys(m_rows[i], row) != 0) continue;
+        beginRemoveRows(QModelIndex(), int(i), int(i));
+        m_rows.remove(i);
+        endRemoveRows();
+    }
+
+    for (const Row &row : changed) {
+        const qsizetype i = lowerBound(row);
+        if (i < m_rows.size() && compareKeys(m_rows[i], row) == 0) {
+            if (m_rows[i].record == row.record) continue;
+            m_rows[i] = row;
+            const QModelIndex changedIndex = index(int(i));
+            emit dataChanged(changedIndex, changedIndex);
+        } else {
+            beginInsertRows(QModelIndex(), int(i), int(i));
+            m_rows.insert(i, row);
+            endInsertRows();
+        }
+    }
+
+    if (m_rows.size() != oldCount) {
+        emit countChanged();
+    }
+}
+
+int PciDeviceModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_rows.size());
+}
+
+QVariant PciDeviceModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) return QVariant();
+
+    const Row &row = m_rows.at(index.row());
+    const PciRecord &record = row.record;
+    const PciIds::Reader &ids = PciIdDatabase::instance().reader();
+    const bool hasHeader = record.flags & PciRecord::HasConfigHeader;
+
+    switch (role) {
+    case HostRole: return m_strings->string(row.host);
+    case BusRole: return int(record.bus);
+    case DeviceNumberRole: return int(record.device);
+    case FunctionNumberRole: return int(record.function);
+    case VendorIdRole: return QString::asprintf("%04X", record.vendorId);
+    case DeviceIdRole: return QString::asprintf("%04X", record.deviceId);
+    case VendorNameRole: {
+        const char *name = ids.vendorName(record.vendorId);
+        return *name ? QString::fromUtf8(name) : QString("Неизвестный производитель");
+    }
+    case DeviceNameRole: return QString::fromUtf8(ids.deviceName(record.vendorId, record.deviceId));
+    case SubsystemNameRole:
+        // Subsystem есть только у обычных функций (тип заголовка 0)
+        if (!hasHeader || (record.headerType & 0x7F) != 0) return QString();
+        return QString::fromUtf8(ids.subsystemName(record.vendorId, record.deviceId,
+                                                   record.subsystemVendorId, record.subsystemId));
+    case ClassCodeRole:
+        if (!hasHeader) return QString();
+        return QString::asprintf("%02X%02X%02X", record.classCode, record.subclass, record.progIf);
+    case ClassNameRole:
+        if (!hasHeader) return QString();
+        return QString::fromUtf8(ids.className(record.classCode, record.subclass, record.progIf));
+    default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> PciDeviceModel::roleNames() const
+{
+    return {
+        {HostRole, "host"},
+        {BusRole, "bus"},
+        {DeviceNumberRole, "deviceNumber"},
+        {FunctionNumberRole, "functionNumber"},
+        {VendorIdRole, "vendorId"},
+        {DeviceIdRole, "deviceId"},
+        {VendorNameRole, "vendorName"},
+        {DeviceNameRole, "deviceName"},
+        {SubsystemNameRole, "subsystemName"},
+        {ClassCodeRole, "classCode"},
+        {ClassNameRole, "className"}
+    };
+}
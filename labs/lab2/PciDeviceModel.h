@@ -0,0 +1,62 @@
+#ifndef PCIDEVICEMODEL_H
+#define PCIDEVICEMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include "common/InventoryStore.h"
+
+// Список устройств для ListView. Новый список сливается со старым по
+// ключу (хост, bus, device, function): делегаты существующих строк не
+// пересоздаются, для изменившихся приходит только dataChanged. Строка —
+// 20 байт; имена из базы pci.ids и строковые поля вычисляются при
+// обращении, то есть только для видимых делегатов
+class PciDeviceModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Roles {
+        HostRole = Qt::UserRole + 1,
+        BusRole,
+        DeviceNumberRole,
+        FunctionNumberRole,
+        VendorIdRole,
+        DeviceIdRole,
+        VendorNameRole,
+        DeviceNameRole,
+        SubsystemNameRole,
+        ClassCodeRole,
+        ClassNameRole
+    };
+
+    struct Row {
+        quint32 host;       // адрес хоста в strings
+        PciRecord record;
+    };
+
+    // strings — пул, в котором лежат адреса хостов из Row::host
+    explicit PciDeviceModel(const StringPool *strings, QObject *parent = nullptr);
+
+    // rows должны быть упорядочены по адресу хоста, затем по PciRecord::key()
+    void setRows(const QList<Row> &rows);
+    // Точечная правка: строки changed вставляются или заменяются, строки с
+    // ключами из removed удаляются. Стоит O(log n) на строку, а не O(n)
+    void updateRows(const QList<Row> &changed, const QList<Row> &removed);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    void countChanged();
+
+private:
+    int compareKeys(const Row &a, const Row &b) const;
+    qsizetype lowerBound(const Row &row) const;
+
+    const StringPool *m_strings;
+    QList<Row> m_rows;
+};
+
+#endif // PCIDEVICEMODEL_H
@@ -0,0 +1,137 @@
+#include "PciEnumerator.h"
+#include <chrono>
+#include <cstring>
+
+// Смещения в заголовке конфигурации
+static const PciEnumerator::u16 OFFSET_ID = 0x00;
+static const PciEnumerator::u16 OFFSET_HEADER_TYPE = 0x0C;   // байт 2 двойного слова
+static const PciEnumerator::u16 OFFSET_BUS_NUMBERS = 0x18;   // первичная, вторичная, подчинённая
+
+static const PciEnumerator::u8 HEADER_MULTIFUNCTION = 0x80;
+static const PciEnumerator::u8 HEADER_TYPE_PCI_BRIDGE = 0x01;
+static const PciEnumerator::u8 HEADER_TYPE_CARDBUS_BRIDGE = 0x02;
+
+static bool isPresent(PciEnumerator::u32 id)
+{
+    const PciEnumerator::u16 vendor = PciEnumerator::u16(id & 0xFFFF);
+    return vendor != 0xFFFF && vendor != 0x0000;
+}
+
+PciEnumerator::Stats PciEnumerator::scan(Mode mode, const std::function<void(const Function &)> &functionFound)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    m_functionFound = &functionFound;
+    memset(&m_stats, 0, sizeof(m_stats));
+    memset(m_visited, 0, sizeof(m_visited));
+
+    if (mode == BruteForce) {
+        bruteForce();
+    } else {
+        scanBus(0);
+        // Многофункциональный хост-мост 0:0.0: функция N обслуживает шину N
+        if (m_stats.functions > 0) {
+            const u32 headerType = (probe(0, 0, 0, OFFSET_HEADER_TYPE) >> 16) & 0xFF;
+            if (headerType != 0xFF && (headerType & HEADER_MULTIFUNCTION)) {
+                for (u8 function = 1; function < 8; ++function) {
+                    if (isPresent(probe(0, 0, function, OFFSET_ID))) scanBus(function);
+                }
+            }
+        }
+    }
+
+    m_functionFound = nullptr;
+    m_stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return m_stats;
+}
+
+PciEnumerator::u32 PciEnumerator::probe(u8 bus, u8 device, u8 function, u16 offset)
+{
+    ++m_stats.probes;
+    return m_config.read32(bus, device, function, offset);
+}
+
+// Идентификатор функции; при снятии снимка он же читается целиком
+PciEnumerator::u32 PciEnumerator::identify(u8 bus, u8 device, u8 function)
+{
+    if (m_capture.empty()) return probe(bus, device, function, OFFSET_ID);
+
+    ++m_stats.probes;
+    m_captured = m_config.read(bus, device, function, &m_capture[0], m_capture.size());
+    if (m_captured < 4) return 0xFFFFFFFF;
+    return u32(m_capture[0]) | (u32(m_capture[1]) << 8) | (u32(m_capture[2]) << 16) | (u32(m_capture[3]) << 24);
+}
+
+void PciEnumerator::report(u8 bus, u8 device, u8 function, u32 id)
+{
+    Function found;
+    found.bus = bus;
+    found.device = device;
+    found.function = function;
+    found.vendorId = u16(id & 0xFFFF);
+    found.deviceId = u16(id >> 16);
+    found.config = m_capture.empty() ? nullptr : &m_capture[0];
+    found.configSize = m_capture.empty() ? 0 : m_captured;
+    ++m_stats.functions;
+    (*m_functionFound)(found);
+}
+
+void PciEnumerator::scanBus(u8 bus)
+{
+    if (m_visited[bus]) return;
+    m_visited[bus] = true;
+    ++m_stats.buses;
+
+    for (u8 device = 0; device < 32; ++device) {
+        scanDevice(bus, device);
+    }
+}
+
+void PciEnumerator::scanDevice(u8 bus, u8 device)
+{
+    const u32 id = identify(bus, device, 0);
+    if (!isPresent(id)) return;
+
+    const bool multifunction = checkFunction(bus, device, 0, id);
+    if (!multifunction) return;
+
+    for (u8 function = 1; function < 8; ++function) {
+        const u32 functionId = identify(bus, device, function);
+        if (isPresent(functionId)) checkFunction(bus, device, function, functionId);
+    }
+}
+
+// Сообщает о функции и спускается за мост; true — устройство многофункциональное
+bool PciEnumerator::checkFunction(u8 bus, u8 device, u8 function, u32 id)
+{
+    report(bus, device, function, id);
+
+    // Из снимка, если он захватил нужные байты
+    const bool captured = !m_capture.empty() && m_captured >= OFFSET_BUS_NUMBERS + 4;
+    const u8 headerType = captured ? m_capture[OFFSET_HEADER_TYPE + 2]
+                                   : u8(probe(bus, device, function, OFFSET_HEADER_TYPE) >> 16);
+    const u8 layout = headerType & 0x7F;
+    if (layout == HEADER_TYPE_PCI_BRIDGE || layout == HEADER_TYPE_CARDBUS_BRIDGE) {
+        const u8 secondary = captured ? m_capture[OFFSET_BUS_NUMBERS + 1]
+                                      : u8(probe(bus, device, function, OFFSET_BUS_NUMBERS) >> 8);
+        // Ненастроенный мост (вторичная шина 0) или петля — не спускаемся
+        if (secondary > bus) scanBus(secondary);
+    }
+    return headerType != 0xFF && (headerType & HEADER_MULTIFUNCTION);
+}
+
+void PciEnumerator::bruteForce()
+{
+    for (int bus = 0; bus < 256; ++bus) {
+        ++m_stats.buses;
+        for (u8 device = 0; device < 32; ++device) {
+            if (!isPresent(probe(u8(bus), device, 0, OFFSET_ID))) continue;
+
+            // Как раньше: все 8 функций, включая повторное чтение функции 0
+            for (u8 function = 0; function < 8; ++function) {
+                const u32 id = identify(u8(bus), device, function);
+                if (isPresent(id)) report(u8(bus), device, function, id);
+            }
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef PCIENUMERATOR_H
+#define PCIENUMERATOR_H
+
+// Обход шин PCI сканером. Без Qt.
+//   Topology   — от шины 0 вниз только через мосты (вторичная шина из
+//                заголовка типа 1/2), функции 1-7 проверяются только у
+//                многофункциональных устройств (бит 7 типа заголовка)
+//   BruteForce — прежний перебор 256 шин x 32 устройства x 8 функций,
+//                оставлен для сравнения
+// Корневые шины, которые не видны через мосты шины 0 (второй сокет,
+// отдельные сегменты ECAM), обход Topology не найдёт — для таких машин
+// есть BruteForce.
+// С setCaptureSize() пространство каждой функции снимается одним вызовом
+// PciConfigAccess::read, и тип заголовка и номера шин моста берутся из
+// снимка без отдельных чтений.
+
+#include "PciConfigAccess.h"
+#include <functional>
+#include <vector>
+
+class PciEnumerator
+{
+public:
+    typedef PciConfigAccess::u8 u8;
+    typedef PciConfigAccess::u16 u16;
+    typedef PciConfigAccess::u32 u32;
+
+    enum Mode { Topology, BruteForce };
+
+    struct Function {
+        u8 bus;
+        u8 device;
+        u8 function;
+        u16 vendorId;
+        u16 deviceId;
+        // Снимок пространства функции, если задан setCaptureSize(); действителен
+        // только на время вызова functionFound
+        const u8 *config;
+        size_t configSize;
+    };
+
+    struct Stats {
+        unsigned probes;        // чтений конфигурационного пространства, снимок — одно
+        unsigned functions;
+        unsigned buses;         // просмотренных шин
+        double milliseconds;
+    };
+
+    explicit PciEnumerator(PciConfigAccess &config) : m_config(config) {}
+
+    // 0 — не снимать; обычно PciConfigAccess::CONFIG_SPACE_SIZE или
+    // EXTENDED_CONFIG_SPACE_SIZE
+    void setCaptureSize(size_t size) { m_capture.resize(size); }
+    size_t captureSize() const { return m_capture.size(); }
+
+    // functionFound вызывается сразу для каждой найденной функции, по
+    // возрастанию номеров внутри шины
+    Stats scan(Mode mode, const std::function<void(const Function &function)> &functionFound);
+
+    static const char *modeName(Mode mode) { return mode == Topology ? "topology" : "brute-force"; }
+
+private:
+    u32 probe(u8 bus, u8 device, u8 function, u16 offset);
+    u32 identify(u8 bus, u8 device, u8 function);
+    void report(u8 bus, u8 device, u8 function, u32 id);
+    void scanBus(u8 bus);
+    void scanDevice(u8 bus, u8 device);
+    bool checkFunction(u8 bus, u8 device, u8 function, u32 id);
+    void bruteForce();
+
+    PciConfigAccess &m_config;
+    const std::function<void(const Function &)> *m_functionFound = nullptr;
+    Stats m_stats = {};
+    bool m_visited[256] = {};
+    std::vector<u8> m_capture;
+    size_t m_captured = 0;      // байт в m_capture для текущей функции
+};
+
+#endif // PCIENUMERATOR_H
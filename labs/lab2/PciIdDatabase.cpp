@@ -0,0 +1,75 @@
+#include "PciIdDatabase.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QResource>
+
+static const char *DATABASE_RESOURCE = ":/pciids/pciids.bin";
+
+const PciIdDatabase &PciIdDatabase::instance()
+{
+    static const PciIdDatabase database;
+    return database;
+}
+
+PciIdDatabase::PciIdDatabase()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const QString override = qEnvironmentVariable("LCD_LABS_PCI_IDS_DB");
+    if (!override.isEmpty()) {
+        m_file.setFileName(override);
+        if (m_file.open(QIODevice::ReadOnly)) {
+            const uchar *data = m_file.map(0, m_file.size());
+            if (!data || !m_reader.open(data, size_t(m_file.size()))) {
+                qWarning() << "Invalid PCI ID database:" << override;
+            }
+        } else {
+            qWarning() << "Cannot open PCI ID database:" << override;
+        }
+    }
+
+    if (!m_reader.isOpen()) {
+        // Ресурс собирается без сжатия, и data() указывает прямо в образ программы
+        QResource resource(DATABASE_RESOURCE);
+        if (resource.isValid() && resource.compressionAlgorithm() == QResource::NoCompression) {
+            m_reader.open(resource.data(), size_t(resource.size()));
+        } else if (resource.isValid()) {
+            m_copy = resource.uncompressedData();
+            m_reader.open(m_copy.constData(), size_t(m_copy.size()));
+        }
+    }
+
+    if (m_reader.isOpen()) {
+        const PciIds::Header &header = m_reader.header();
+        qDebug() << "PCI ID database:" << header.vendorCount << "vendors," << header.deviceCount << "devices,"
+                 << header.subsystemCount << "subsystems, version" << header.sourceVersion
+                 << "opened in" << timer.nsecsElapsed() / 1000 << "us";
+    } else {
+        qWarning() << "PCI ID database is not available";
+    }
+}
+
+bool PciIdDatabase::parseId(const QString &text, quint16 &id)
+{
+    bool ok = false;
+    const uint value = text.toUInt(&ok, 16);
+    if (!ok || value > 0xFFFF) return false;
+    id = quint16(value);
+    return true;
+}
+
+QString PciIdDatabase::vendorName(const QString &vendorID) const
+{
+    quint16 vendor = 0;
+    if (!parseId(vendorID, vendor)) return QString();
+    return QString::fromUtf8(m_reader.vendorName(vendor));
+}
+
+QString PciIdDatabase::deviceName(const QString &vendorID, const QString &deviceID) const
+{
+    quint16 vendor = 0;
+    quint16 device = 0;
+    if (!parseId(vendorID, vendor) || !parseId(deviceID, device)) return QString();
+    return QString::fromUtf8(m_reader.deviceName(vendor, device));
+}
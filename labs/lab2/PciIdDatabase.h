@@ -0,0 +1,34 @@
+#ifndef PCIIDDATABASE_H
+#define PCIIDDATABASE_H
+
+#include <QFile>
+#include <QString>
+#include "PciIdsFormat.h"
+
+// База имён pci.ids, собранная tools/pciids при сборке. Читается прямо из
+// ресурса в образе программы (или из файла LCD_LABS_PCI_IDS_DB через
+// QFile::map), поиск не выделяет память
+class PciIdDatabase
+{
+public:
+    static const PciIdDatabase &instance();
+
+    bool isLoaded() const { return m_reader.isOpen(); }
+    const PciIds::Reader &reader() const { return m_reader; }
+
+    // Пустая строка, если имени нет или идентификатор не разобран
+    QString vendorName(const QString &vendorID) const;
+    QString deviceName(const QString &vendorID, const QString &deviceID) const;
+
+    static bool parseId(const QString &text, quint16 &id);
+
+private:
+    PciIdDatabase();
+    Q_DISABLE_COPY(PciIdDatabase)
+
+    QFile m_file;
+    QByteArray m_copy;
+    PciIds::Reader m_reader;
+};
+
+#endif // PCIIDDATABASE_H
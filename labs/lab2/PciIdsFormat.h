@@ -0,0 +1,172 @@
+#ifndef PCIIDSFORMAT_H
+#define PCIIDSFORMAT_H
+
+// Формат скомпилированной базы pci.ids (tools/pciids) и чтение из неё.
+// Заголовок без Qt. Данные используются прямо из отображённой памяти:
+// поиск не выделяет память и не копирует строки.
+//
+// Раскладка (little-endian, смещения от начала блоба):
+//   Header
+//   u32 vendors[65536]     смещение имени производителя, 0 — нет
+//   u32 classes[256]       имя класса
+//   u32 subclasses[65536]  имя подкласса, индекс class << 8 | subclass
+//   Slot devices[]         открытая адресация, ключ vendor << 16 | device
+//   Slot subsystems[]      ключ vendor << 48 | device << 32 | subvendor << 16 | subdevice
+//   Slot progIfs[]         ключ class << 16 | subclass << 8 | progIf
+//   строки UTF-8 с нулём в конце; по смещению 0 лежит пустая строка
+// Таблицы заполнены не больше чем наполовину, поэтому поиск в среднем
+// просматривает одну-две ячейки.
+
+#include <stddef.h>
+#include <string.h>
+
+namespace PciIds {
+
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+typedef unsigned long long u64;
+
+const char MAGIC[4] = {'P', 'I', 'D', 'S'};
+const u32 VERSION = 1;
+const u32 DIRECT_TABLE_SIZE = 65536;
+
+struct Header {
+    char magic[4];
+    u32 version;
+    u32 vendorTable;
+    u32 classTable;
+    u32 subclassTable;
+    u32 deviceTable;
+    u32 deviceMask;
+    u32 subsystemTable;
+    u32 subsystemMask;
+    u32 progIfTable;
+    u32 progIfMask;
+    u32 strings;
+    u32 stringsSize;
+    u32 vendorCount;
+    u32 deviceCount;
+    u32 subsystemCount;
+    u32 classCount;
+    char sourceVersion[32];
+};
+
+// Ячейка хеш-таблицы; name == 0 — пустая ячейка
+struct Slot {
+    u64 key;
+    u32 name;
+    u32 reserved;
+};
+
+inline u32 slotFor(u64 key, u32 mask)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return u32(key) & mask;
+}
+
+inline u64 deviceKey(u16 vendor, u16 device)
+{
+    return (u64(vendor) << 16) | device;
+}
+
+inline u64 subsystemKey(u16 vendor, u16 device, u16 subvendor, u16 subdevice)
+{
+    return (u64(vendor) << 48) | (u64(device) << 32) | (u64(subvendor) << 16) | subdevice;
+}
+
+inline u64 progIfKey(u8 classCode, u8 subclass, u8 progIf)
+{
+    return (u64(classCode) << 16) | (u64(subclass) << 8) | progIf;
+}
+
+// Данные в ресурсе Qt не обязательно выровнены, читаем через memcpy
+template <typename T>
+inline T readAt(const u8 *base, size_t offset)
+{
+    T value;
+    memcpy(&value, base + offset, sizeof(T));
+    return value;
+}
+
+class Reader
+{
+public:
+    Reader() : m_data(0), m_size(0) { memset(&m_header, 0, sizeof(m_header)); }
+
+    // false — блоб повреждён или другой версии
+    bool open(const void *data, size_t size)
+    {
+        m_data = 0;
+        m_size = 0;
+        if (!data || size < sizeof(Header)) return false;
+
+        memcpy(&m_header, data, sizeof(Header));
+        if (memcmp(m_header.magic, MAGIC, 4) != 0 || m_header.version != VERSION) return false;
+        if (size_t(m_header.strings) + m_header.stringsSize > size) return false;
+
+        m_data = static_cast<const u8 *>(data);
+        m_size = size;
+        return true;
+    }
+
+    bool isOpen() const { return m_data != 0; }
+    const Header &header() const { return m_header; }
+
+    // Пустая строка, если имени нет
+    const char *vendorName(u16 vendor) const
+    {
+        if (!m_data) return "";
+        return string(readAt<u32>(m_data, m_header.vendorTable + size_t(vendor) * 4));
+    }
+
+    const char *deviceName(u16 vendor, u16 device) const
+    {
+        return find(m_header.deviceTable, m_header.deviceMask, deviceKey(vendor, device));
+    }
+
+    const char *subsystemName(u16 vendor, u16 device, u16 subvendor, u16 subdevice) const
+    {
+        return find(m_header.subsystemTable, m_header.subsystemMask,
+                    subsystemKey(vendor, device, subvendor, subdevice));
+    }
+
+    // Самое точное из имён: программный интерфейс, подкласс или класс
+    const char *className(u8 classCode, u8 subclass, u8 progIf) const
+    {
+        if (!m_data) return "";
+        const char *name = find(m_header.progIfTable, m_header.progIfMask, progIfKey(classCode, subclass, progIf));
+        if (*name) return name;
+        name = string(readAt<u32>(m_data, m_header.subclassTable + (size_t(classCode) << 8 | subclass) * 4));
+        if (*name) return name;
+        return string(readAt<u32>(m_data, m_header.classTable + size_t(classCode) * 4));
+    }
+
+private:
+    const char *string(u32 offset) const
+    {
+        if (offset == 0 || offset >= m_header.stringsSize) return "";
+        return reinterpret_cast<const char *>(m_data + m_header.strings + offset);
+    }
+
+    const char *find(u32 table, u32 mask, u64 key) const
+    {
+        if (!m_data || table == 0) return "";
+        for (u32 i = slotFor(key, mask);; i = (i + 1) & mask) {
+            const size_t slot = table + size_t(i) * sizeof(Slot);
+            const u32 name = readAt<u32>(m_data, slot + offsetof(Slot, name));
+            if (name == 0) return "";
+            if (readAt<u64>(m_data, slot + offsetof(Slot, key)) == key) return string(name);
+        }
+    }
+
+    const u8 *m_data;
+    size_t m_size;
+    Header m_header;
+};
+
+} // namespace PciIds
+
+#endif // PCIIDSFORMAT_H
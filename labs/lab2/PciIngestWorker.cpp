@@ -0,0 +1,453 @@
+#include "PciIngestWorker.h"
+#include "PciDelta.h"
+#include "PciInventoryHistory.h"
+#include "common/IngestService.h"
+#include "common/Trace.h"
+#include <algorithm>
+
+static PciDevice deviceFromRecord(const PciWire::DeviceRecord &record)
+{
+    PciDevice device;
+    device.bus = record.bus;
+    device.device = record.device;
+    device.function = record.function;
+    device.vendorId = record.vendorId;
+    device.deviceId = record.deviceId;
+    return device;
+}
+
+PciIngestWorker::PciIngestWorker(quint16 port, IngestService *ingestService, QObject *parent)
+    : QObject(parent)
+    , m_port(port)
+    , m_ingestService(ingestService)
+    , m_tcpServer(nullptr)
+    , m_publishTimer(new QTimer(this))
+    , m_completedScans(0)
+{
+    // Строки появляются по мере приёма, но в GUI уходят пачками,
+    // сколько бы сканеров ни передавало одновременно
+    m_publishTimer->setSingleShot(true);
+    m_publishTimer->setInterval(50);
+    connect(m_publishTimer, &QTimer::timeout, this, &PciIngestWorker::publish);
+}
+
+PciIngestWorker::~PciIngestWorker()
+{
+    unregisterSinks();
+    closeAllSessions();
+}
+
+void PciIngestWorker::unregisterSinks()
+{
+    if (!m_ingestService) return;
+    m_ingestService->unregisterSink(Ingest::KIND_PCI_JSON, this);
+    m_ingestService->unregisterSink(Ingest::KIND_PCI_BINARY, this);
+}
+
+void PciIngestWorker::start()
+{
+    if (m_tcpServer) return;
+
+    m_tcpServer = new QTcpServer(this);
+    // Сотни сканеров подключаются почти одновременно: очередь ядра и
+    // очередь Qt должны вместить всплеск, пока цикл событий их разбирает
+    m_tcpServer->setListenBacklogSize(LISTEN_BACKLOG);
+    m_tcpServer->setMaxPendingConnections(LISTEN_BACKLOG);
+    connect(m_tcpServer, &QTcpServer::newConnection, this, &PciIngestWorker::onNewConnection);
+
+    if (m_ingestService) {
+        m_ingestService->registerSink(Ingest::KIND_PCI_JSON, this);
+        m_ingestService->registerSink(Ingest::KIND_PCI_BINARY, this);
+    }
+
+    if (m_tcpServer->listen(QHostAddress::Any, m_port)) {
+        emit started(true, QString());
+    } else {
+        const QString error = m_tcpServer->errorString();
+        delete m_tcpServer;
+        m_tcpServer = nullptr;
+        emit started(false, error);
+    }
+}
+
+void PciIngestWorker::stop()
+{
+    unregisterSinks();
+    closeAllSessions();
+    if (!m_tcpServer) return;
+
+    m_tcpServer->close();
+    delete m_tcpServer;
+    m_tcpServer = nullptr;
+    emit stopped();
+}
+
+void PciIngestWorker::clear()
+{
+    m_pending.clear();
+    m_completedScans = 0;
+
+    // Подключённые хосты снова появятся в списке, агенты — сразу со своим
+    // текущим списком: следующие изменения применяются к нему
+    const QList<Session *> sessions = m_sessions.values() + m_ingestSessions.values();
+    for (Session *session : sessions) {
+        PciHostSnapshot &snapshot = m_pending[session->host];
+        snapshot.host = session->host;
+        if (session->hasBase) {
+            snapshot.devices = session->base;
+            snapshot.devicesValid = true;
+        }
+    }
+    schedulePublish();
+}
+
+void PciIngestWorker::closeAllSessions()
+{
+    // Соединения общего порта закрывает IngestService, здесь только их состояние
+    qDeleteAll(m_ingestSessions);
+    m_ingestSessions.clear();
+    m_agentSessions.clear();
+
+    if (m_sessions.isEmpty()) return;
+    const QList<Session *> sessions = m_sessions.values();
+    m_sessions.clear();
+    for (Session *session : sessions) {
+        session->socket->disconnect(this);
+        session->socket->abort();
+        session->socket->deleteLater();
+        delete session;
+    }
+    emit connectionsChanged(0, QString());
+}
+
+void PciIngestWorker::onNewConnection()
+{
+    QString lastClient;
+
+    // Разбираем всю очередь сразу: newConnection может прийти один раз на пачку
+    while (m_tcpServer && m_tcpServer->hasPendingConnections()) {
+        QTcpSocket *socket = m_tcpServer->nextPendingConnection();
+        bool isIPv4 = false;
+        const quint32 ipv4 = socket->peerAddress().toIPv4Address(&isIPv4);
+        const QString host = isIPv4 ? QHostAddress(ipv4).toString() : socket->peerAddress().toString();
+
+        Session *session = createSession(socket, host);
+        connect(socket, &QTcpSocket::readyRead, this, [this, session]() { readSession(session); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, session]() { closeSession(session); });
+
+        m_sessions.insert(socket, session);
+        lastClient = session->host;
+    }
+
+    emit connectionsChanged(m_sessions.size(), lastClient);
+    schedulePublish();
+}
+
+// Соединение своего порта или, без socket, соединение общего порта
+PciIngestWorker::Session *PciIngestWorker::createSession(QTcpSocket *socket, const QString &host)
+{
+    auto session = new Session;
+    session->socket = socket;
+    session->host = host;
+
+    session->parser.arrayStarted = [this, session]() { beginInventory(session); };
+    session->parser.deviceParsed = [this, session](const PciDevice &device) {
+        appendDevice(session, device);
+    };
+    session->parser.arrayFinished = [this, session](int deviceCount) {
+        Q_UNUSED(deviceCount)
+        commitSession(session);
+    };
+
+    session->decoder.helloReceived = [session](PciWire::u8 version, PciWire::u8 flags) {
+        // Старый сканер принимает только свою версию
+        const PciWire::u8 agreed = qMin(version, PciWire::VERSION);
+        session->agent = agreed >= PciWire::DELTA_VERSION && (flags & PciWire::FLAG_DELTAS);
+        if (!session->socket) return;
+        std::string ack;
+        PciWire::appendAck(ack, agreed);
+        session->socket->write(ack.data(), qint64(ack.size()));
+    };
+    session->decoder.inventoryStarted = [this, session]() { beginInventory(session); };
+    session->decoder.deviceDecoded = [this, session](const PciWire::DeviceRecord &record) {
+        appendDevice(session, deviceFromRecord(record));
+    };
+    session->decoder.configHeaderDecoded = [session](const PciWire::DeviceRecord &record,
+                                                     const PciWire::u8 *header) {
+        const int key = (record.bus << 8) | (record.device << 3) | record.function;
+        const int index = session->deviceIndex.value(key, -1);
+        if (index >= 0) {
+            session->devices[index].configHeader =
+                QByteArray(reinterpret_cast<const char *>(header), int(PciWire::CONFIG_HEADER_SIZE));
+        }
+    };
+    session->decoder.inventoryFinished = [this, session](size_t deviceCount) {
+        Q_UNUSED(deviceCount)
+        commitSession(session);
+    };
+    session->decoder.functionRemoved = [session](const PciWire::DeviceRecord &record) {
+        session->removed.append((record.bus << 8) | (record.device << 3) | record.function);
+    };
+    session->decoder.deltaFinished = [this, session](size_t, size_t) { commitDelta(session); };
+    session->decoder.hostReceived = [this, session](const std::string &hostId) {
+        setHostId(session, QString::fromUtf8(hostId.data(), qsizetype(hostId.size())));
+    };
+    session->decoder.heartbeatReceived = [this, session]() {
+        PciHostSnapshot &snapshot = m_pending[session->host];
+        snapshot.host = session->host;
+        snapshot.lastSeen = QDateTime::currentDateTime();
+        schedulePublish();
+    };
+    return session;
+}
+
+void PciIngestWorker::readSession(Session *session)
+{
+    TRACE_SCOPE("pci", "PciIngestWorker::readSession");
+    const QByteArray chunk = session->socket->readAll();
+    TRACE_COUNTER("pci.chunkBytes", chunk.size());
+    // Соединение уже закрывается, остаток потока не разбираем
+    if (!session->failure.isEmpty()) return;
+
+    if (session->protocol == Session::Protocol::Unknown) {
+        const QByteArray trimmed = chunk.trimmed();
+        if (trimmed.isEmpty()) return;
+        session->protocol = trimmed.at(0) == PciWire::MAGIC[0] ? Session::Protocol::Binary
+                                                               : Session::Protocol::Json;
+    }
+
+    bool ok = false;
+    QString error;
+    if (session->protocol == Session::Protocol::Binary) {
+        ok = session->decoder.feed(chunk.constData(), size_t(chunk.size()));
+        if (!ok) error = QString("ошибка двоичного протокола: %1").arg(session->decoder.error());
+        if (ok && !session->failure.isEmpty()) {
+            ok = false;
+            error = session->failure;
+        }
+    } else {
+        ok = session->parser.feed(chunk);
+        if (!ok) error = session->parser.errorString();
+    }
+
+    if (!ok) {
+        session->failure = error;
+        emit errorOccurred(QString("%1: %2").arg(session->host, error));
+        // Повреждённый поток не восстановить: закрываем соединение.
+        // closeSession может удалить session прямо здесь
+        session->socket->disconnectFromHost();
+    }
+}
+
+void PciIngestWorker::closeSession(Session *session)
+{
+    // Недошедшую инвентаризацию отбрасываем: у хоста остаётся прежний
+    // список, агент после переподключения пришлёт полную
+    if (session->inInventory()) {
+        emit logMessage(QString("%1: передача прервана, принято %2 устройств")
+                            .arg(session->host).arg(session->receivedCount()));
+        m_pending[session->host].host = session->host;
+        schedulePublish();
+    }
+
+    if (m_agentSessions.value(session->host) == session) {
+        m_agentSessions.remove(session->host);
+    }
+    if (!session->socket) {
+        m_ingestSessions.remove(m_ingestSessions.key(session));
+        delete session;
+        return;
+    }
+
+    m_sessions.remove(session->socket);
+    session->socket->disconnect(this);
+    session->socket->deleteLater();
+    delete session;
+
+    emit connectionsChanged(m_sessions.size(), QString());
+}
+
+// Вызывается из декодера session: закрывать можно только другие соединения
+void PciIngestWorker::setHostId(Session *session, const QString &hostId)
+{
+    if (session->hasHostId || session->hasBase) {
+        if (session->failure.isEmpty()) session->failure = "имя хоста после начала инвентаризации";
+        return;
+    }
+    session->host = hostId;
+    session->hasHostId = true;
+    if (!session->agent) return;
+
+    if (Session *previous = m_agentSessions.value(hostId)) {
+        emit logMessage(QString("%1: агент переподключился, прежнее соединение закрыто").arg(hostId));
+        // Соединение общего порта остаётся открытым, но без состояния:
+        // следующее его изменение будет отвергнуто
+        QTcpSocket *previousSocket = previous->socket;
+        closeSession(previous);
+        if (previousSocket) previousSocket->abort();
+    }
+    m_agentSessions.insert(hostId, session);
+}
+
+void PciIngestWorker::beginInventory(Session *session)
+{
+    session->devices.clear();
+    session->deviceIndex.clear();
+    session->removed.clear();
+    m_pending[session->host].host = session->host;
+    schedulePublish();
+}
+
+void PciIngestWorker::appendDevice(Session *session, const PciDevice &device)
+{
+    const int key = (device.bus << 8) | (device.device << 3) | device.function;
+    session->deviceIndex.insert(key, session->devices.size());
+    session->devices.append(device);
+}
+
+void PciIngestWorker::commitSession(Session *session)
+{
+    if (session->agent) {
+        session->base = session->devices;
+        std::sort(session->base.begin(), session->base.end(), [](const PciDevice &a, const PciDevice &b) {
+            return PciDelta::key(a) < PciDelta::key(b);
+        });
+        session->hasBase = true;
+    }
+    commitInventory(session->host, session->devices);
+}
+
+// Изменения агента: полный список соединения обновляется для истории, в GUI
+// уходят только сами изменения
+void PciIngestWorker::commitDelta(Session *session)
+{
+    // Вызывается из декодера: закрывать соединение здесь нельзя
+    if (!session->hasBase) {
+        if (session->failure.isEmpty()) session->failure = "изменения без полной инвентаризации";
+        return;
+    }
+
+    QList<PciDevice> &base = session->base;
+    PciDelta::apply(base, session->devices, session->removed);
+
+    PciHostSnapshot &snapshot = m_pending[session->host];
+    snapshot.host = session->host;
+    snapshot.lastSeen = QDateTime::currentDateTime();
+    if (snapshot.devicesValid) {
+        // Полный список ещё не отправлен — отправим уже обновлённый
+        snapshot.devices = base;
+    } else {
+        PciDelta::merge(snapshot.changed, snapshot.removed, session->devices, session->removed);
+    }
+
+    ++m_completedScans;
+    PciInventoryHistory::instance().append(session->host, base, snapshot.lastSeen);
+    session->devices.clear();
+    session->deviceIndex.clear();
+    session->removed.clear();
+    schedulePublish();
+}
+
+void PciIngestWorker::commitInventory(const QString &host, const QList<PciDevice> &devices)
+{
+    PciHostSnapshot &snapshot = m_pending[host];
+    snapshot.host = host;
+    snapshot.devices = devices;
+    snapshot.devicesValid = true;
+    snapshot.changed.clear();
+    snapshot.removed.clear();
+    snapshot.lastSeen = QDateTime::currentDateTime();
+
+    ++m_completedScans;
+    PciInventoryHistory::instance().append(host, snapshot.devices, snapshot.lastSeen);
+    schedulePublish();
+}
+
+bool PciIngestWorker::ingest(quintptr connection, const QString &host, quint16 kind, const QByteArray &payload)
+{
+    TRACE_SCOPE("pci", "PciIngestWorker::ingest");
+
+    if (kind == Ingest::KIND_PCI_JSON) {
+        // Сообщение JSON — законченная инвентаризация, разбираем её целиком
+        QList<PciDevice> devices;
+        bool finished = false;
+        PciStreamParser parser;
+        parser.deviceParsed = [&devices](const PciDevice &device) { devices.append(device); };
+        parser.arrayFinished = [&finished](int) { finished = true; };
+        QString error;
+        if (!parser.feed(payload)) {
+            error = parser.errorString();
+        } else if (!finished) {
+            error = "инвентаризация не закончена";
+        }
+        if (!error.isEmpty()) {
+            emit errorOccurred(QString("%1: %2").arg(host, error));
+            return false;
+        }
+        commitInventory(host, devices);
+        return true;
+    }
+
+    // Двоичные сообщения одного соединения — продолжение одного потока
+    // PciWire без приветствия: инвентаризация может прийти несколькими
+    // сообщениями, за ней — изменения агента. Поэтому у соединения свой
+    // декодер и своя последняя инвентаризация
+    Session *&session = m_ingestSessions[connection];
+    if (!session) {
+        session = createSession(nullptr, host);
+        session->protocol = Session::Protocol::Binary;
+        std::string hello;
+        PciWire::appendHello(hello, PciWire::FLAG_DELTAS);
+        session->decoder.feed(hello.data(), hello.size());
+    }
+    Session *current = session;
+
+    QString error;
+    if (!current->decoder.feed(payload.constData(), size_t(payload.size()))) {
+        error = QString("ошибка двоичного протокола: %1").arg(current->decoder.error());
+    } else if (!current->failure.isEmpty()) {
+        error = current->failure;
+    }
+    if (!error.isEmpty()) {
+        emit errorOccurred(QString("%1: %2").arg(current->host, error));
+        closeSession(current);
+        return false;
+    }
+    return true;
+}
+
+void PciIngestWorker::connectionClosed(quintptr connection)
+{
+    if (Session *session = m_ingestSessions.value(connection)) {
+        closeSession(session);
+    }
+}
+
+void PciIngestWorker::schedulePublish()
+{
+    if (!m_publishTimer->isActive()) {
+        m_publishTimer->start();
+    }
+}
+
+void PciIngestWorker::publish()
+{
+    if (m_pending.isEmpty() && m_completedScans == 0) return;
+
+    TRACE_SCOPE("pci", "PciIngestWorker::publish");
+    // Незавершённые передачи видны только флагом receiving: список хоста
+    // меняется, когда инвентаризация пришла целиком. Снимки уходят в GUI и
+    // здесь не хранятся: единственная копия инвентаризаций — у PciManager
+    QSet<QString> receivingHosts;
+    const QList<Session *> sessions = m_sessions.values() + m_ingestSessions.values();
+    for (Session *session : sessions) {
+        if (session->inInventory()) receivingHosts.insert(session->host);
+    }
+    for (PciHostSnapshot &snapshot : m_pending) {
+        snapshot.receiving = receivingHosts.contains(snapshot.host);
+    }
+
+    emit hostsUpdated(m_pending.values(), m_completedScans);
+    m_pending.clear();
+    m_completedScans = 0;
+}
@@ -0,0 +1,136 @@
+#ifndef PCIINGESTWORKER_H
+#define PCIINGESTWORKER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDateTime>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QPointer>
+#include "PciStreamParser.h"
+#include "PciWireFormat.h"
+#include "common/IngestService.h"
+
+// Изменения одного хоста с прошлой отправки. Списки неявно разделяемые, и
+// после отправки в GUI никто их не меняет
+struct PciHostSnapshot {
+    QString host;
+    // devices заполнен, только если devicesValid; иначе хост лишь подключился
+    QList<PciDevice> devices;
+    bool devicesValid = false;
+    // Изменения от агента поверх уже показанного списка, если !devicesValid:
+    // changed — добавленные и изменившиеся функции, removed — ключи
+    // bus << 8 | device << 3 | function удалённых
+    QList<PciDevice> changed;
+    QList<int> removed;
+    // Невалидно, если инвентаризация не завершилась
+    QDateTime lastSeen;
+    bool receiving = false;
+};
+Q_DECLARE_METATYPE(PciHostSnapshot)
+
+// Приём инвентаризаций сканеров PCI. Живёт в IoThread: сокеты, буферы и
+// разбор не касаются потока GUI, в PciManager уходят только снимки хостов.
+// Слушает свой порт для старых сканеров и принимает сообщения PCI с общего
+// порта IngestService; у соединения общего порта то же состояние Session,
+// что и у соединения своего порта, только без сокета
+class PciIngestWorker : public QObject, public IngestSink
+{
+    Q_OBJECT
+
+public:
+    PciIngestWorker(quint16 port, IngestService *ingestService, QObject *parent = nullptr);
+    ~PciIngestWorker() override;
+
+    bool ingest(quintptr connection, const QString &host, quint16 kind, const QByteArray &payload) override;
+    void connectionClosed(quintptr connection) override;
+
+public slots:
+    void start();
+    void stop();
+    // Забыть принятые инвентаризации
+    void clear();
+
+signals:
+    void started(bool ok, const QString &error);
+    void stopped();
+    void connectionsChanged(int connectionCount, const QString &lastClient);
+    // Изменившиеся хосты и число завершённых инвентаризаций с прошлого раза
+    void hostsUpdated(const QList<PciHostSnapshot> &snapshots, int completedScans);
+    void logMessage(const QString &message);
+    void errorOccurred(const QString &error);
+
+private:
+    // Состояние одного соединения сканера: свой парсер и свой буфер строк.
+    // Протокол определяется по первому байту: "PCIB" — двоичный, иначе JSON.
+    // Принимаемая инвентаризация живёт здесь, пока не закончится: к хосту
+    // она попадает целиком, сколько бы соединений хоста ни шло параллельно
+    struct Session {
+        enum class Protocol { Unknown, Json, Binary };
+
+        QTcpSocket *socket = nullptr;
+        // Адрес, а у агента с FRAME_HOST — присланное им имя хоста
+        QString host;
+        bool hasHostId = false;
+        Protocol protocol = Protocol::Unknown;
+        PciStreamParser parser;
+        PciWire::Decoder decoder;
+        QList<PciDevice> devices;
+        QHash<int, int> deviceIndex;
+        // Агент (FLAG_DELTAS): последняя инвентаризация соединения, к ней
+        // применяются изменения; в devices в это время только изменения
+        bool agent = false;
+        bool hasBase = false;
+        QList<PciDevice> base;
+        QList<int> removed;
+        // Ошибка из обработчика декодера. Соединение закрывается в
+        // readSession после feed: закрытие удаляет session вместе с
+        // декодером, посреди разбора этого делать нельзя
+        QString failure;
+
+        bool inInventory() const
+        {
+            return protocol == Protocol::Binary ? decoder.inInventory() : parser.inArray();
+        }
+        int receivedCount() const
+        {
+            return protocol == Protocol::Binary ? int(decoder.deviceCount()) : parser.elementCount();
+        }
+    };
+
+    void onNewConnection();
+    Session *createSession(QTcpSocket *socket, const QString &host);
+    void readSession(Session *session);
+    void closeSession(Session *session);
+    void closeAllSessions();
+    void setHostId(Session *session, const QString &hostId);
+    void beginInventory(Session *session);
+    void appendDevice(Session *session, const PciDevice &device);
+    void commitSession(Session *session);
+    void commitInventory(const QString &host, const QList<PciDevice> &devices);
+    void commitDelta(Session *session);
+    void unregisterSinks();
+    void schedulePublish();
+    void publish();
+
+    static constexpr int LISTEN_BACKLOG = 1024;
+
+    quint16 m_port;
+    QPointer<IngestService> m_ingestService;
+    QTcpServer *m_tcpServer;
+    QTimer *m_publishTimer;
+    QHash<QTcpSocket *, Session *> m_sessions;
+    // Соединения общего порта: по ним приходят сообщения, не сокеты
+    QHash<quintptr, Session *> m_ingestSessions;
+    // Соединения агентов по имени хоста: у хоста одно, новое — это
+    // переподключение, которое сервер увидел раньше обрыва старого
+    QHash<QString, Session *> m_agentSessions;
+    // Хосты, изменившиеся с прошлой отправки
+    QHash<QString, PciHostSnapshot> m_pending;
+    int m_completedScans;
+};
+
+#endif // PCIINGESTWORKER_H
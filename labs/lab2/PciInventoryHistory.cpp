@@ -0,0 +1,548 @@
+#include "PciInventoryHistory.h"
+#include "common/Trace.h"
+#include <QDebug>
+#include <QDir>
+#include <QMap>
+#include <QStandardPaths>
+#include <algorithm>
+#include <climits>
+#include <limits>
+
+namespace {
+
+enum RecordKind : quint8 { Keyframe = 0, Delta = 1 };
+
+void putVarint(QByteArray &out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+bool getVarint(const uchar *&p, const uchar *end, quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const uchar byte = *p++;
+        value |= quint64(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+int deviceKey(const PciDevice &device)
+{
+    return (device.bus << 8) | (device.device << 3) | device.function;
+}
+
+bool sameDevice(const PciDevice &a, const PciDevice &b)
+{
+    return a.vendorId == b.vendorId && a.deviceId == b.deviceId && a.configHeader == b.configHeader;
+}
+
+void encodeDevice(QByteArray &out, const PciDevice &device, int &previousKey)
+{
+    const int key = deviceKey(device);
+    putVarint(out, quint64(key - previousKey));
+    previousKey = key;
+    putVarint(out, device.vendorId);
+    putVarint(out, device.deviceId);
+    putVarint(out, quint64(device.configHeader.size()));
+    out.append(device.configHeader);
+}
+
+bool decodeDevice(const uchar *&p, const uchar *end, PciDevice &device, int &previousKey)
+{
+    quint64 keyDelta, vendor, deviceId, headerSize;
+    if (!getVarint(p, end, keyDelta) || !getVarint(p, end, vendor) || !getVarint(p, end, deviceId)
+        || !getVarint(p, end, headerSize) || headerSize > quint64(end - p)) {
+        return false;
+    }
+
+    const int key = previousKey + int(keyDelta);
+    previousKey = key;
+    device.bus = quint8(key >> 8);
+    device.device = quint8((key >> 3) & 0x1F);
+    device.function = quint8(key & 0x07);
+    device.vendorId = quint16(vendor);
+    device.deviceId = quint16(deviceId);
+    device.configHeader = QByteArray(reinterpret_cast<const char *>(p), int(headerSize));
+    p += headerSize;
+    return true;
+}
+
+QByteArray packDevices(const QList<PciDevice> &devices)
+{
+    QByteArray out;
+    putVarint(out, quint64(devices.size()));
+    int previousKey = 0;
+    for (const PciDevice &device : devices) {
+        encodeDevice(out, device, previousKey);
+    }
+    return out;
+}
+
+QList<PciDevice> unpackDevices(const QByteArray &packed)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(packed.constData());
+    const uchar *end = p + packed.size();
+    quint64 count = 0;
+    if (!getVarint(p, end, count)) return {};
+
+    QList<PciDevice> devices;
+    devices.reserve(qsizetype(qMin<quint64>(count, quint64(packed.size()))));
+    int previousKey = 0;
+    for (quint64 i = 0; i < count; ++i) {
+        PciDevice device;
+        if (!decodeDevice(p, end, device, previousKey)) break;
+        devices.append(device);
+    }
+    return devices;
+}
+
+// FNV-1a: хеш хранится в индексе и не должен зависеть от запуска
+quint32 hostHashOf(const QString &host)
+{
+    quint32 hash = 2166136261u;
+    for (char c : host.toUtf8()) {
+        hash = (hash ^ uchar(c)) * 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+PciInventoryHistory &PciInventoryHistory::instance()
+{
+    static PciInventoryHistory history([]() {
+        QString directory = qEnvironmentVariable("LCD_LABS_PCI_HISTORY");
+        if (directory.isEmpty()) {
+            directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/pci-history";
+        }
+        return directory;
+    }());
+    return history;
+}
+
+PciInventoryHistory::PciInventoryHistory(const QString &directory)
+    : m_map(nullptr)
+    , m_mapSize(0)
+    , m_lastTime(0)
+{
+    if (!open(directory)) {
+        qWarning() << "PCI inventory history is not available:" << m_error;
+    }
+}
+
+PciInventoryHistory::~PciInventoryHistory()
+{
+    if (m_map) {
+        m_index.unmap(const_cast<uchar *>(m_map));
+    }
+}
+
+bool PciInventoryHistory::open(const QString &directory)
+{
+    TRACE_SCOPE("pci", "PciInventoryHistory::open");
+
+    if (!QDir().mkpath(directory)) {
+        m_error = QString("не удалось создать %1").arg(directory);
+        return false;
+    }
+
+    m_data.setFileName(directory + "/history.dat");
+    m_index.setFileName(directory + "/history.idx");
+    if (!m_data.open(QIODevice::ReadWrite) || !m_index.open(QIODevice::ReadWrite)) {
+        m_error = m_data.isOpen() ? m_index.errorString() : m_data.errorString();
+        m_data.close();
+        m_index.close();
+        return false;
+    }
+
+    // Запись могла оборваться при аварийном завершении: отбрасываем хвост
+    // индекса без данных и данные без записи в индексе
+    quint32 count = quint32(m_index.size() / qint64(sizeof(IndexEntry)));
+    remap();
+    while (count > 0) {
+        const IndexEntry last = entryAt(count - 1);
+        if (qint64(last.offset + last.size) <= m_data.size()) break;
+        --count;
+    }
+    const qint64 dataEnd = count > 0 ? qint64(entryAt(count - 1).offset + entryAt(count - 1).size) : 0;
+    if (m_index.size() != qint64(count) * qint64(sizeof(IndexEntry)) || m_data.size() != dataEnd) {
+        qWarning() << "PCI inventory history: dropping incomplete tail";
+        if (m_map) {
+            m_index.unmap(const_cast<uchar *>(m_map));
+            m_map = nullptr;
+            m_mapSize = 0;
+        }
+        m_index.resize(qint64(count) * qint64(sizeof(IndexEntry)));
+        m_data.resize(dataEnd);
+        remap();
+    }
+
+    // Имена хостов лежат только в ключевых записях
+    QHash<quint32, QList<quint32>> hostEntries;
+    QHash<quint32, int> sinceKeyframe;
+    for (quint32 i = 0; i < count; ++i) {
+        const IndexEntry entry = entryAt(i);
+        if (entry.kind == Keyframe && !m_hostNames.contains(entry.hostHash)) {
+            const QByteArray record = readRecord(entry);
+            const uchar *p = reinterpret_cast<const uchar *>(record.constData()) + 1;
+            const uchar *end = reinterpret_cast<const uchar *>(record.constData()) + record.size();
+            quint64 length = 0;
+            if (getVarint(p, end, length) && length <= quint64(end - p)) {
+                m_hostNames.insert(entry.hostHash, QString::fromUtf8(reinterpret_cast<const char *>(p), int(length)));
+            }
+        }
+        hostEntries[entry.hostHash].append(i);
+        sinceKeyframe[entry.hostHash] = entry.kind == Keyframe ? 0 : sinceKeyframe.value(entry.hostHash) + 1;
+        m_lastTime = entry.time;
+    }
+
+    for (auto it = hostEntries.cbegin(); it != hostEntries.cend(); ++it) {
+        const QString host = m_hostNames.value(it.key());
+        if (host.isEmpty()) continue;
+        m_hosts.insert(host, {it.value(), sinceKeyframe.value(it.key()), packDevices(reconstruct(it.value().last()))});
+    }
+
+    qDebug() << "PCI inventory history:" << m_hosts.size() << "hosts," << count << "snapshots,"
+             << m_data.size() << "bytes";
+    return true;
+}
+
+bool PciInventoryHistory::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_data.isOpen();
+}
+
+QString PciInventoryHistory::errorString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_error;
+}
+
+qint64 PciInventoryHistory::dataSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_data.size();
+}
+
+qint64 PciInventoryHistory::indexSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index.size();
+}
+
+bool PciInventoryHistory::remap() const
+{
+    const qint64 size = m_index.size();
+    if (m_map && m_mapSize == size) return true;
+
+    if (m_map) {
+        m_index.unmap(const_cast<uchar *>(m_map));
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+    if (size == 0) return true;
+
+    m_map = m_index.map(0, size);
+    m_mapSize = m_map ? size : 0;
+    return m_map != nullptr;
+}
+
+quint32 PciInventoryHistory::entryCount() const
+{
+    return quint32(m_mapSize / qint64(sizeof(IndexEntry)));
+}
+
+PciInventoryHistory::IndexEntry PciInventoryHistory::entryAt(quint32 index) const
+{
+    IndexEntry entry;
+    memcpy(&entry, m_map + size_t(index) * sizeof(IndexEntry), sizeof(IndexEntry));
+    return entry;
+}
+
+quint32 PciInventoryHistory::hashFor(const QString &host) const
+{
+    // Коллизию разрешаем следующим свободным значением; порядок появления
+    // хостов в файле тот же, поэтому после перезапуска хеши совпадут
+    quint32 hash = hostHashOf(host);
+    for (;;) {
+        auto it = m_hostNames.constFind(hash);
+        if (it == m_hostNames.cend() || it.value() == host) return hash;
+        ++hash;
+    }
+}
+
+QByteArray PciInventoryHistory::readRecord(const IndexEntry &entry) const
+{
+    if (!m_data.seek(qint64(entry.offset))) return QByteArray();
+
+    const QByteArray record = m_data.read(entry.size);
+    const uchar *p = reinterpret_cast<const uchar *>(record.constData());
+    const uchar *end = p + record.size();
+    quint64 length = 0;
+    if (!getVarint(p, end, length) || length != quint64(end - p)) return QByteArray();
+    return record.mid(int(p - reinterpret_cast<const uchar *>(record.constData())));
+}
+
+QList<PciDevice> PciInventoryHistory::reconstruct(quint32 index) const
+{
+    // Назад по цепочке хоста до ключевой записи, затем вперёд с применением разностей
+    QList<IndexEntry> chain;
+    for (quint32 i = index; i != NO_ENTRY;) {
+        const IndexEntry entry = entryAt(i);
+        chain.prepend(entry);
+        if (entry.kind == Keyframe) break;
+        i = entry.previous;
+    }
+
+    QMap<int, PciDevice> devices;
+    for (const IndexEntry &entry : std::as_const(chain)) {
+        const QByteArray record = readRecord(entry);
+        if (record.isEmpty()) {
+            qWarning() << "PCI inventory history: damaged record at" << entry.offset;
+            break;
+        }
+
+        const uchar *p = reinterpret_cast<const uchar *>(record.constData()) + 1;
+        const uchar *end = reinterpret_cast<const uchar *>(record.constData()) + record.size();
+        quint64 count = 0;
+        int previousKey = 0;
+        if (entry.kind == Keyframe) {
+            quint64 length = 0;
+            if (!getVarint(p, end, length) || length > quint64(end - p)) break;
+            p += length;
+        } else {
+            if (!getVarint(p, end, count)) break;
+            for (quint64 i = 0; i < count; ++i) {
+                quint64 keyDelta = 0;
+                if (!getVarint(p, end, keyDelta)) break;
+                previousKey += int(keyDelta);
+                devices.remove(previousKey);
+            }
+            previousKey = 0;
+        }
+
+        if (!getVarint(p, end, count)) break;
+        for (quint64 i = 0; i < count; ++i) {
+            PciDevice device;
+            if (!decodeDevice(p, end, device, previousKey)) break;
+            devices.insert(deviceKey(device), device);
+        }
+    }
+    return devices.values();
+}
+
+bool PciInventoryHistory::append(const QString &host, const QList<PciDevice> &devices, const QDateTime &time)
+{
+    TRACE_SCOPE("pci", "PciInventoryHistory::append");
+    QMutexLocker locker(&m_mutex);
+    if (!m_data.isOpen()) return false;
+
+    QList<PciDevice> sorted = devices;
+    std::sort(sorted.begin(), sorted.end(), [](const PciDevice &a, const PciDevice &b) {
+        return deviceKey(a) < deviceKey(b);
+    });
+    // Повторный адрес в одной инвентаризации — оставляем первый
+    sorted.erase(std::unique(sorted.begin(), sorted.end(), [](const PciDevice &a, const PciDevice &b) {
+        return deviceKey(a) == deviceKey(b);
+    }), sorted.end());
+
+    const quint32 hostHash = hashFor(host);
+    auto state = m_hosts.find(host);
+
+    QByteArray keyframe;
+    keyframe.append(char(Keyframe));
+    const QByteArray hostName = host.toUtf8();
+    putVarint(keyframe, quint64(hostName.size()));
+    keyframe.append(hostName);
+    const QByteArray packed = packDevices(sorted);
+    keyframe.append(packed);
+
+    QByteArray payload = keyframe;
+    if (state != m_hosts.end() && state->sinceKeyframe + 1 < KEYFRAME_INTERVAL) {
+        QList<int> removed;
+        QList<PciDevice> upserted;
+        const QList<PciDevice> previous = unpackDevices(state->devices);
+        qsizetype i = 0, j = 0;
+        while (i < previous.size() || j < sorted.size()) {
+            const int oldKey = i < previous.size() ? deviceKey(previous[i]) : INT_MAX;
+            const int newKey = j < sorted.size() ? deviceKey(sorted[j]) : INT_MAX;
+            if (oldKey < newKey) {
+                removed.append(oldKey);
+                ++i;
+            } else if (newKey < oldKey) {
+                upserted.append(sorted[j++]);
+            } else {
+                if (!sameDevice(previous[i], sorted[j])) upserted.append(sorted[j]);
+                ++i;
+                ++j;
+            }
+        }
+
+        QByteArray delta;
+        delta.append(char(Delta));
+        putVarint(delta, quint64(removed.size()));
+        int previousKey = 0;
+        for (int key : std::as_const(removed)) {
+            putVarint(delta, quint64(key - previousKey));
+            previousKey = key;
+        }
+        delta.append(packDevices(upserted));
+
+        if (delta.size() < keyframe.size()) payload = delta;
+    }
+
+    QByteArray record;
+    putVarint(record, quint64(payload.size()));
+    record.append(payload);
+
+    IndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.time = qMax(time.toMSecsSinceEpoch(), m_lastTime);
+    entry.offset = quint64(m_data.size());
+    entry.size = quint32(record.size());
+    entry.hostHash = hostHash;
+    entry.previous = state != m_hosts.end() ? state->entries.last() : NO_ENTRY;
+    entry.deviceCount = quint32(sorted.size());
+    entry.kind = quint8(payload.at(0));
+
+    // Сначала данные, потом индекс: запись без индекса отбросится при открытии
+    const quint32 index = quint32(m_index.size() / qint64(sizeof(IndexEntry)));
+    if (!m_data.seek(m_data.size()) || m_data.write(record) != record.size() || !m_data.flush()
+        || !m_index.seek(m_index.size())
+        || m_index.write(reinterpret_cast<const char *>(&entry), sizeof(entry)) != qint64(sizeof(entry))
+        || !m_index.flush()) {
+        m_error = m_data.error() != QFileDevice::NoError ? m_data.errorString() : m_index.errorString();
+        qWarning() << "PCI inventory history: write failed:" << m_error;
+        return false;
+    }
+
+    m_hostNames.insert(hostHash, host);
+    m_lastTime = entry.time;
+    const int sinceKeyframe = entry.kind == Keyframe ? 0 : state->sinceKeyframe + 1;
+    HostState &updated = m_hosts[host];
+    updated.entries.append(index);
+    updated.sinceKeyframe = sinceKeyframe;
+    updated.devices = packed;
+    TRACE_COUNTER("pci.historyBytes", m_data.size());
+    return true;
+}
+
+QStringList PciInventoryHistory::hosts() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList result = m_hosts.keys();
+    result.sort();
+    return result;
+}
+
+QList<PciInventoryHistory::Snapshot> PciInventoryHistory::snapshots(const QString &host, const QDateTime &from,
+                                                                    const QDateTime &to) const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<Snapshot> result;
+    if (!remap()) return result;
+    if (!host.isEmpty() && !m_hosts.contains(host)) return result;
+
+    const qint64 fromTime = from.isValid() ? from.toMSecsSinceEpoch() : 0;
+    const qint64 toTime = to.isValid() ? to.toMSecsSinceEpoch() : std::numeric_limits<qint64>::max();
+    auto snapshotOf = [](const IndexEntry &entry) {
+        return Snapshot{QDateTime::fromMSecsSinceEpoch(entry.time), int(entry.deviceCount), entry.kind == Keyframe};
+    };
+
+    // Записи идут по времени: начало интервала ищем двоичным поиском, у
+    // одного хоста — только среди его записей
+    if (!host.isEmpty()) {
+        const QList<quint32> &entries = m_hosts.constFind(host)->entries;
+        auto it = std::lower_bound(entries.cbegin(), entries.cend(), fromTime,
+                                   [this](quint32 index, qint64 time) { return entryAt(index).time < time; });
+        for (; it != entries.cend(); ++it) {
+            const IndexEntry entry = entryAt(*it);
+            if (entry.time > toTime) break;
+            result.append(snapshotOf(entry));
+        }
+        return result;
+    }
+
+    quint32 low = 0, high = entryCount();
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        if (entryAt(middle).time < fromTime) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (quint32 i = low; i < entryCount(); ++i) {
+        const IndexEntry entry = entryAt(i);
+        if (entry.time > toTime) break;
+        result.append(snapshotOf(entry));
+    }
+    return result;
+}
+
+quint32 PciInventoryHistory::lastEntryAt(const HostState &state, qint64 time) const
+{
+    auto it = std::upper_bound(state.entries.cbegin(), state.entries.cend(), time,
+                               [this](qint64 value, quint32 index) { return value < entryAt(index).time; });
+    return it == state.entries.cbegin() ? NO_ENTRY : *(it - 1);
+}
+
+QList<PciDevice> PciInventoryHistory::stateAt(const QString &host, qint64 time, QDateTime *snapshotTime) const
+{
+    if (snapshotTime) *snapshotTime = QDateTime();
+
+    auto state = m_hosts.constFind(host);
+    if (state == m_hosts.cend() || !remap()) return {};
+
+    const quint32 last = state->entries.last();
+    quint32 index = last;
+    if (entryAt(index).time > time) {
+        index = lastEntryAt(*state, time);
+        if (index == NO_ENTRY) return {};
+    }
+
+    if (snapshotTime) *snapshotTime = QDateTime::fromMSecsSinceEpoch(entryAt(index).time);
+    return index == last ? unpackDevices(state->devices) : reconstruct(index);
+}
+
+QList<PciDevice> PciInventoryHistory::devicesAt(const QString &host, const QDateTime &time,
+                                                QDateTime *snapshotTime) const
+{
+    QMutexLocker locker(&m_mutex);
+    return stateAt(host, time.isValid() ? time.toMSecsSinceEpoch() : std::numeric_limits<qint64>::max(),
+                   snapshotTime);
+}
+
+PciInventoryHistory::Changes PciInventoryHistory::changesSince(const QString &host, const QDateTime &since) const
+{
+    TRACE_SCOPE("pci", "PciInventoryHistory::changesSince");
+    QMutexLocker locker(&m_mutex);
+
+    Changes changes;
+    const QList<PciDevice> before = stateAt(host, since.toMSecsSinceEpoch(), &changes.since);
+    const QList<PciDevice> after = stateAt(host, std::numeric_limits<qint64>::max(), &changes.until);
+
+    qsizetype i = 0, j = 0;
+    while (i < before.size() || j < after.size()) {
+        const int oldKey = i < before.size() ? deviceKey(before[i]) : INT_MAX;
+        const int newKey = j < after.size() ? deviceKey(after[j]) : INT_MAX;
+        if (oldKey < newKey) {
+            changes.removed.append(before[i++]);
+        } else if (newKey < oldKey) {
+            changes.added.append(after[j++]);
+        } else {
+            if (!sameDevice(before[i], after[j])) changes.changed.append({before[i], after[j]});
+            ++i;
+            ++j;
+        }
+    }
+    return changes;
+}
@@ -0,0 +1,122 @@
+#ifndef PCIINVENTORYHISTORY_H
+#define PCIINVENTORYHISTORY_H
+
+#include <QFile>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include "PciStreamParser.h"
+
+// История инвентаризаций PCI на диске, только дописывается.
+//
+// history.dat — записи <длина:varint> <тип:1> <данные>. Ключевая запись
+// хранит имя хоста и все устройства, разностная — только удалённые и
+// изменённые относительно предыдущей записи того же хоста. Устройства
+// отсортированы по bus:device.function, ключи и идентификаторы упакованы
+// в varint, поэтому повторная инвентаризация без изменений занимает
+// пару байт. Каждая KEYFRAME_INTERVAL-я запись хоста — ключевая.
+//
+// history.idx — записи IndexEntry фиксированного размера в порядке
+// времени; файл отображается в память, интервал по времени ищется
+// двоичным поиском, по цепочке previous восстанавливается снимок хоста.
+// Номера записей каждого хоста держатся в памяти: снимки одного хоста
+// ищутся двоичным поиском по ним, не просмотром записей всех хостов.
+//
+// Файлы пишет поток I/O, читает GUI: всё под m_mutex
+class PciInventoryHistory
+{
+public:
+    struct Snapshot {
+        QDateTime time;
+        int deviceCount = 0;
+        bool keyframe = false;
+    };
+
+    struct Changes {
+        // Время снимка, с которым сравнивали; невалидно, если до T снимков не было
+        QDateTime since;
+        QDateTime until;
+        QList<PciDevice> added;
+        QList<PciDevice> removed;
+        // Пары «было — стало»
+        QList<QPair<PciDevice, PciDevice>> changed;
+    };
+
+    // Каталог — LCD_LABS_PCI_HISTORY или AppDataLocation/pci-history
+    static PciInventoryHistory &instance();
+    // Отдельная история в каталоге directory (тесты); приложение
+    // пользуется общей instance()
+    explicit PciInventoryHistory(const QString &directory);
+    ~PciInventoryHistory();
+
+    bool isOpen() const;
+    QString errorString() const;
+
+    // Сохраняет инвентаризацию хоста; устройства можно передавать в любом порядке
+    bool append(const QString &host, const QList<PciDevice> &devices, const QDateTime &time);
+
+    QStringList hosts() const;
+    // Снимки хоста в [from, to]; пустой host — всех хостов
+    QList<Snapshot> snapshots(const QString &host, const QDateTime &from, const QDateTime &to) const;
+    // Последний снимок не позже time; time невалидно — самый последний
+    QList<PciDevice> devicesAt(const QString &host, const QDateTime &time = QDateTime(),
+                               QDateTime *snapshotTime = nullptr) const;
+    // Что изменилось у хоста с момента since до последнего снимка
+    Changes changesSince(const QString &host, const QDateTime &since) const;
+
+    qint64 dataSize() const;
+    qint64 indexSize() const;
+
+private:
+    Q_DISABLE_COPY(PciInventoryHistory)
+
+    struct IndexEntry {
+        qint64 time;          // мс с эпохи, не убывает
+        quint64 offset;       // смещение записи в history.dat
+        quint32 size;
+        quint32 hostHash;
+        quint32 previous;     // предыдущая запись хоста или NO_ENTRY
+        quint32 deviceCount;
+        quint32 kind;
+        quint32 reserved;
+    };
+    static_assert(sizeof(IndexEntry) == 40, "IndexEntry is part of the file format");
+
+    // Последний снимок хоста в упакованном виде (varint, как в записях):
+    // основа для следующей разности и для changesSince
+    struct HostState {
+        // Записи хоста в history.idx по времени; последняя — devices
+        QList<quint32> entries;
+        int sinceKeyframe;
+        QByteArray devices;
+    };
+
+    static constexpr quint32 NO_ENTRY = 0xFFFFFFFF;
+    static constexpr int KEYFRAME_INTERVAL = 64;
+
+    bool open(const QString &directory);
+    bool remap() const;
+    quint32 entryCount() const;
+    IndexEntry entryAt(quint32 index) const;
+    quint32 lastEntryAt(const HostState &state, qint64 time) const;
+    quint32 hashFor(const QString &host) const;
+    QByteArray readRecord(const IndexEntry &entry) const;
+    QList<PciDevice> reconstruct(quint32 index) const;
+    QList<PciDevice> stateAt(const QString &host, qint64 time, QDateTime *snapshotTime) const;
+
+    mutable QMutex m_mutex;
+    mutable QFile m_data;
+    mutable QFile m_index;
+    mutable const uchar *m_map;
+    mutable qint64 m_mapSize;
+    // Хосты по хешу имени; коллизии хешей разрешаются полным именем
+    QHash<quint32, QString> m_hostNames;
+    QHash<QString, HostState> m_hosts;
+    QString m_error;
+    qint64 m_lastTime;
+};
+
+#endif // PCIINVENTORYHISTORY_H
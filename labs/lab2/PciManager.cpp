@@ -1,136 +1,199 @@
 #include "PciManager.h"
-#include <QJsonDocument>
-#include <QNetworkInterface>
+#include "PciIdDatabase.h"
+#include "PciInventoryHistory.h"
+#include "common/IngestService.h"
+#include "common/IoThread.h"
+#include "common/Trace.h"
+#include <QHostInfo>
+#include <QVariantMap>
+#include <algorithm>
 
 PciManager::PciManager(QObject *parent)
     : QObject(parent)
-    , m_currentClient(nullptr)
+    , m_deviceModel(new PciDeviceModel(&m_store.strings(), this))
+    , m_connectionCount(0)
+    , m_serverRunning(false)
+    , m_active(false)
 {
-    initVendorDatabase();
     setServerStatus("Сервер остановлен");
+    restoreHistory();
 }
 
 PciManager::~PciManager()
 {
-    stopServer();
+    IoThread::dispose(m_worker);
 }
 
-bool PciManager::isServerRunning() const
+void PciManager::activate()
 {
-    return m_tcpServer && m_tcpServer->isListening();
+    if (m_active) return;
+
+    m_active = true;
+    emit activeChanged();
+
+    startServer();
+}
+
+void PciManager::suspend()
+{
+    if (!m_active) return;
+
+    stopServer();
+
+    m_active = false;
+    emit activeChanged();
 }
 
 void PciManager::startServer()
 {
-    if (m_tcpServer) {
+    if (m_worker) {
         emit logMessage("Сервер уже запущен");
         return;
     }
 
-    m_tcpServer = std::make_unique<QTcpServer>(this);
+    // Приём и разбор идут в потоке I/O; сюда приходят только снимки хостов
+    m_worker = new PciIngestWorker(SERVER_PORT, IngestService::instance());
+    connect(m_worker, &PciIngestWorker::started, this, &PciManager::onWorkerStarted);
+    connect(m_worker, &PciIngestWorker::stopped, this, &PciManager::onWorkerStopped);
+    connect(m_worker, &PciIngestWorker::connectionsChanged, this, &PciManager::onConnectionsChanged);
+    connect(m_worker, &PciIngestWorker::hostsUpdated, this, &PciManager::onHostsUpdated);
+    connect(m_worker, &PciIngestWorker::logMessage, this, &PciManager::logMessage);
+    connect(m_worker, &PciIngestWorker::errorOccurred, this, &PciManager::errorOccurred);
+    IoThread::adopt(m_worker);
+
+    setServerStatus("Запуск сервера...");
+    QMetaObject::invokeMethod(m_worker, &PciIngestWorker::start, Qt::QueuedConnection);
+}
+
+void PciManager::stopServer()
+{
+    if (!m_worker) return;
+
+    // Сигналы, уже стоящие в очереди, до удаления рабочего не дойдут
+    m_worker->disconnect(this);
+    IoThread::dispose(m_worker);
+    m_worker = nullptr;
 
-    connect(m_tcpServer.get(), &QTcpServer::newConnection,
-            this, &PciManager::onNewConnection);
+    if (m_connectionCount != 0) {
+        m_connectionCount = 0;
+        emit connectionCountChanged();
+    }
+    onWorkerStopped();
+}
 
-    if (m_tcpServer->listen(QHostAddress::Any, SERVER_PORT)) {
+void PciManager::onWorkerStarted(bool ok, const QString &error)
+{
+    if (ok) {
+        m_serverRunning = true;
         setServerStatus(QString("Сервер запущен на порту %1").arg(SERVER_PORT));
         emit logMessage(QString("Сервер успешно запущен на порту %1").arg(SERVER_PORT));
+        emit logMessage(QString("Общий порт приёма: %1").arg(IngestService::instance()->port()));
         emit serverRunningChanged();
     } else {
-        QString error = m_tcpServer->errorString();
         emit errorOccurred(QString("Ошибка запуска сервера: %1").arg(error));
         setServerStatus("Ошибка запуска");
-        m_tcpServer.reset();
+        m_worker->disconnect(this);
+        IoThread::dispose(m_worker);
+        m_worker = nullptr;
     }
 }
 
-void PciManager::stopServer()
+void PciManager::onWorkerStopped()
 {
-    if (m_currentClient) {
-        m_currentClient->disconnectFromHost();
-        m_currentClient = nullptr;
-    }
+    if (!m_serverRunning) return;
 
-    if (m_tcpServer) {
-        m_tcpServer->close();
-        m_tcpServer.reset();
-        setServerStatus("Сервер остановлен");
-        emit logMessage("Сервер остановлен");
-        emit serverRunningChanged();
-    }
+    m_serverRunning = false;
+    setServerStatus("Сервер остановлен");
+    emit logMessage("Сервер остановлен");
+    emit serverRunningChanged();
 }
 
 void PciManager::clearDevices()
 {
-    m_devices = QJsonArray();
-    m_deviceList.clear();
+    if (m_worker) {
+        QMetaObject::invokeMethod(m_worker, &PciIngestWorker::clear, Qt::QueuedConnection);
+    }
+    // Сначала модель: её строки ссылаются на пул строк хранилища
+    m_deviceModel->setRows({});
+    m_store.clear();
+    m_selectedHost.clear();
+    emit selectedHostChanged();
+    emit hostsChanged();
     emit devicesChanged();
     emit logMessage("Список устройств очищен");
 }
 
-QString PciManager::getLocalIP() const
+int PciManager::totalDeviceCount() const
 {
-    QList<QHostAddress> addresses = QNetworkInterface::allAddresses();
-    for (const QHostAddress &address : addresses) {
-        if (address.protocol() == QAbstractSocket::IPv4Protocol
-            && address != QHostAddress::LocalHost
-            && !address.toString().startsWith("169.254")) { // APIPA
-            return address.toString();
-        }
+    int total = 0;
+    for (const InventoryStore::Host &host : m_store.entries()) {
+        total += host.pci.size();
     }
-    return "127.0.0.1";
+    return total;
 }
 
-QString PciManager::getVendorName(const QString &vendorID) const
+QVariantList PciManager::hosts() const
 {
-    return m_vendorDatabase.value(vendorID.toUpper(), "Неизвестный производитель");
+    QVariantList result;
+    const QStringList addresses = m_store.hosts();
+    for (const QString &address : addresses) {
+        const InventoryStore::Host *host = m_store.find(address);
+        QVariantMap entry;
+        entry["host"] = address;
+        entry["hostName"] = m_store.strings().string(host->hostName);
+        entry["deviceCount"] = host->pci.size();
+        entry["lastSeen"] = host->lastSeen ? QDateTime::fromMSecsSinceEpoch(host->lastSeen) : QDateTime();
+        entry["receiving"] = host->receiving;
+        result.append(entry);
+    }
+    return result;
 }
 
-void PciManager::onNewConnection()
+int PciManager::hostDeviceCount(const QString &host) const
 {
-    if (m_currentClient) {
-        m_currentClient->disconnectFromHost();
-    }
-
-    m_currentClient = m_tcpServer->nextPendingConnection();
-
-    connect(m_currentClient, &QTcpSocket::readyRead,
-            this, &PciManager::onReadyRead);
-    connect(m_currentClient, &QTcpSocket::disconnected,
-            this, &PciManager::onDisconnected);
-
-    m_clientIP = m_currentClient->peerAddress().toString();
-    emit clientIPChanged();
+    const InventoryStore::Host *entry = m_store.find(host);
+    return entry ? int(entry->pci.size()) : 0;
+}
 
-    setServerStatus(QString("Клиент подключен: %1").arg(m_clientIP));
-    emit logMessage(QString("Подключение от %1").arg(m_clientIP));
+void PciManager::setSelectedHost(const QString &host)
+{
+    if (m_selectedHost == host) return;
 
-    m_buffer.clear();
+    m_selectedHost = host;
+    emit selectedHostChanged();
+    rebuildDevices();
+    emit devicesChanged();
 }
 
-void PciManager::onReadyRead()
+QString PciManager::getLocalIP() const
 {
-    if (!m_currentClient) return;
+    return IngestService::localAddress();
+}
 
-    m_buffer.append(m_currentClient->readAll());
+QString PciManager::getVendorName(const QString &vendorID) const
+{
+    const QString name = PciIdDatabase::instance().vendorName(vendorID);
+    return name.isEmpty() ? QString("Неизвестный производитель") : name;
+}
 
-    QJsonDocument doc = QJsonDocument::fromJson(m_buffer);
-    if (!doc.isNull() && doc.isArray()) {
-        updateDevices(doc.array());
-        emit logMessage(QString("Получено %1 устройств").arg(doc.array().size()));
-        m_buffer.clear();
-    }
+QString PciManager::getDeviceName(const QString &vendorID, const QString &deviceID) const
+{
+    return PciIdDatabase::instance().deviceName(vendorID, deviceID);
 }
 
-void PciManager::onDisconnected()
+void PciManager::onConnectionsChanged(int connectionCount, const QString &lastClient)
 {
-    if (m_currentClient) {
-        emit logMessage(QString("Клиент %1 отключился").arg(m_clientIP));
-        m_currentClient->deleteLater();
-        m_currentClient = nullptr;
-        m_clientIP.clear();
+    if (!lastClient.isEmpty() && m_clientIP != lastClient) {
+        m_clientIP = lastClient;
         emit clientIPChanged();
-        setServerStatus("Ожидание подключения...");
+    }
+    if (m_connectionCount != connectionCount) {
+        m_connectionCount = connectionCount;
+        emit connectionCountChanged();
+    }
+    if (m_serverRunning) {
+        setServerStatus(m_connectionCount == 0 ? QString("Ожидание подключения...")
+                                               : QString("Подключений: %1").arg(m_connectionCount));
     }
 }
 
@@ -142,42 +205,244 @@ void PciManager::setServerStatus(const QString &status)
     }
 }
 
-void PciManager::updateDevices(const QJsonArray &devices)
+void PciManager::onHostsUpdated(const QList<PciHostSnapshot> &snapshots, int completedScans)
 {
-    m_devices = devices;
-    m_deviceList.clear();
+    TRACE_SCOPE("pci", "PciManager::onHostsUpdated");
+
+    // Полный список видимого хоста — пересборка модели; изменения от
+    // агентов — правка отдельных строк
+    bool rebuild = false;
+    QList<PciDeviceModel::Row> changedRows;
+    QList<PciDeviceModel::Row> removedRows;
+    for (const PciHostSnapshot &snapshot : snapshots) {
+        const bool isNew = !m_store.contains(snapshot.host);
+        InventoryStore::Host &host = m_store.host(snapshot.host);
+        if (isNew) {
+            lookupHostName(snapshot.host);
+        }
+        const bool visible = m_selectedHost.isEmpty() || snapshot.host == m_selectedHost;
+        if (snapshot.devicesValid) {
+            setDevices(host, snapshot.devices);
+            rebuild = rebuild || visible;
+        } else if (!snapshot.changed.isEmpty() || !snapshot.removed.isEmpty()) {
+            applyDelta(host, snapshot.changed, snapshot.removed,
+                       visible ? &changedRows : nullptr, visible ? &removedRows : nullptr);
+        }
+        if (snapshot.lastSeen.isValid()) {
+            host.lastSeen = snapshot.lastSeen.toMSecsSinceEpoch();
+        }
+        host.receiving = snapshot.receiving;
+    }
 
-    for (const auto &value : devices) {
-        QJsonObject obj = value.toObject();
-        PciDevice device;
-        device.bus = obj["bus"].toInt();
-        device.device = obj["device"].toInt();
-        device.function = obj["function"].toInt();
-        device.vendorID = obj["vendorID"].toString().toUpper();
-        device.deviceID = obj["deviceID"].toString().toUpper();
-        m_deviceList.append(device);
+    if (completedScans > 0) {
+        emit logMessage(QString("Получено инвентаризаций: %1, хостов: %2, устройств всего: %3")
+                            .arg(completedScans).arg(m_store.hostCount()).arg(totalDeviceCount()));
     }
 
+    if (snapshots.isEmpty()) return;
+
+    TRACE_COUNTER("pci.hosts", m_store.hostCount());
+    emit hostsChanged();
+    if (rebuild) {
+        rebuildDevices();
+    } else if (!changedRows.isEmpty() || !removedRows.isEmpty()) {
+        m_deviceModel->updateRows(changedRows, removedRows);
+    } else {
+        return;
+    }
+    TRACE_COUNTER("pci.devices", m_deviceModel->rowCount());
     emit devicesChanged();
 }
 
-void PciManager::initVendorDatabase()
-{
-    m_vendorDatabase["8086"] = "Intel Corporation";
-    m_vendorDatabase["1022"] = "AMD";
-    m_vendorDatabase["10DE"] = "NVIDIA Corporation";
-    m_vendorDatabase["1002"] = "AMD/ATI";
-    m_vendorDatabase["14E4"] = "Broadcom";
-    m_vendorDatabase["10EC"] = "Realtek Semiconductor";
-    m_vendorDatabase["1B21"] = "ASMedia Technology";
-    m_vendorDatabase["8087"] = "Intel Corporation";
-    m_vendorDatabase["1033"] = "NEC Corporation";
-    m_vendorDatabase["1106"] = "VIA Technologies";
-    m_vendorDatabase["10B5"] = "PLX Technology";
-    m_vendorDatabase["1039"] = "Silicon Integrated Systems";
-    m_vendorDatabase["1000"] = "LSI Logic";
-    m_vendorDatabase["15AD"] = "VMware";
-    m_vendorDatabase["80EE"] = "VirtualBox";
-    m_vendorDatabase["1D6B"] = "Linux Foundation";
-    m_vendorDatabase["1AF4"] = "Red Hat (Virtio)";
+void PciManager::rebuildDevices()
+{
+    TRACE_SCOPE("pci", "PciManager::rebuildDevices");
+
+    // Хосты по адресу, функции хоста уже упорядочены: строки идут в порядке модели
+    QList<PciDeviceModel::Row> rows;
+    auto appendHost = [&rows](const InventoryStore::Host &host) {
+        for (const PciRecord &record : host.pci) {
+            rows.append({host.address, record});
+        }
+    };
+
+    if (m_selectedHost.isEmpty()) {
+        rows.reserve(totalDeviceCount());
+        const QStringList addresses = m_store.hosts();
+        for (const QString &address : addresses) {
+            appendHost(*m_store.find(address));
+        }
+    } else if (const InventoryStore::Host *host = m_store.find(m_selectedHost)) {
+        appendHost(*host);
+    }
+
+    m_deviceModel->setRows(rows);
+}
+
+static PciRecord recordFromDevice(const PciDevice &device)
+{
+    PciRecord record = {};
+    record.bus = device.bus;
+    record.device = device.device;
+    record.function = device.function;
+    record.vendorId = device.vendorId;
+    record.deviceId = device.deviceId;
+
+    // Из заголовка конфигурации нужны только класс и subsystem
+    const QByteArray &header = device.configHeader;
+    if (header.size() >= 0x30) {
+        const auto bytes = reinterpret_cast<const uchar *>(header.constData());
+        record.flags = PciRecord::HasConfigHeader;
+        record.progIf = bytes[0x09];
+        record.subclass = bytes[0x0A];
+        record.classCode = bytes[0x0B];
+        record.headerType = bytes[0x0E];
+        record.subsystemVendorId = quint16(bytes[0x2C] | (bytes[0x2D] << 8));
+        record.subsystemId = quint16(bytes[0x2E] | (bytes[0x2F] << 8));
+    }
+    return record;
+}
+
+static bool recordKeyLess(const PciRecord &a, const PciRecord &b)
+{
+    return a.key() < b.key();
+}
+
+void PciManager::setDevices(InventoryStore::Host &host, const QList<PciDevice> &devices)
+{
+    host.pci.resize(0);
+    host.pci.reserve(devices.size());
+    for (const PciDevice &device : devices) {
+        host.pci.append(recordFromDevice(device));
+    }
+
+    std::sort(host.pci.begin(), host.pci.end(), recordKeyLess);
+    // Повторный адрес в одной инвентаризации — оставляем первый
+    host.pci.erase(std::unique(host.pci.begin(), host.pci.end(), [](const PciRecord &a, const PciRecord &b) {
+        return a.key() == b.key();
+    }), host.pci.end());
+    host.pci.squeeze();
+}
+
+void PciManager::applyDelta(InventoryStore::Host &host, const QList<PciDevice> &changed, const QList<int> &removed,
+                            QList<PciDeviceModel::Row> *changedRows, QList<PciDeviceModel::Row> *removedRows)
+{
+    for (int key : removed) {
+        PciRecord probe = {};
+        probe.bus = quint8(key >> 8);
+        probe.device = quint8((key >> 3) & 0x1F);
+        probe.function = quint8(key & 0x07);
+        auto it = std::lower_bound(host.pci.begin(), host.pci.end(), probe, recordKeyLess);
+        if (it == host.pci.end() || it->key() != key) continue;
+        if (removedRows) removedRows->append({host.address, *it});
+        host.pci.erase(it);
+    }
+
+    for (const PciDevice &device : changed) {
+        const PciRecord record = recordFromDevice(device);
+        auto it = std::lower_bound(host.pci.begin(), host.pci.end(), record, recordKeyLess);
+        if (it != host.pci.end() && it->key() == record.key()) {
+            if (*it == record) continue;
+            *it = record;
+        } else {
+            host.pci.insert(it, record);
+        }
+        if (changedRows) changedRows->append({host.address, record});
+    }
+}
+
+QVariantMap PciManager::memoryReport(const QString &host) const
+{
+    QVariantMap report = m_store.memoryReport(host).toVariantMap();
+    if (host.isEmpty()) {
+        report["modelBytes"] = qint64(m_deviceModel->rowCount()) * qint64(sizeof(PciDeviceModel::Row));
+    }
+    return report;
+}
+
+void PciManager::restoreHistory()
+{
+    TRACE_SCOPE("pci", "PciManager::restoreHistory");
+    const PciInventoryHistory &history = PciInventoryHistory::instance();
+
+    // Последние инвентаризации прошлых запусков видны сразу, до подключений
+    const QStringList hosts = history.hosts();
+    for (const QString &address : hosts) {
+        QDateTime lastSeen;
+        const QList<PciDevice> devices = history.devicesAt(address, QDateTime(), &lastSeen);
+        InventoryStore::Host &host = m_store.host(address);
+        setDevices(host, devices);
+        host.lastSeen = lastSeen.isValid() ? lastSeen.toMSecsSinceEpoch() : 0;
+        lookupHostName(address);
+    }
+
+    if (m_store.hostCount() > 0) {
+        rebuildDevices();
+        emit logMessage(QString("Из истории восстановлено хостов: %1, устройств: %2")
+                            .arg(m_store.hostCount()).arg(totalDeviceCount()));
+    }
+}
+
+static QVariantMap deviceToVariant(const PciDevice &device)
+{
+    QVariantMap entry;
+    entry["bus"] = int(device.bus);
+    entry["device"] = int(device.device);
+    entry["function"] = int(device.function);
+    entry["vendorId"] = QString::asprintf("%04X", device.vendorId);
+    entry["deviceId"] = QString::asprintf("%04X", device.deviceId);
+    entry["deviceName"] = QString::fromUtf8(PciIdDatabase::instance().reader().deviceName(device.vendorId,
+                                                                                          device.deviceId));
+    return entry;
+}
+
+QVariantList PciManager::history(const QString &host, const QDateTime &from, const QDateTime &to) const
+{
+    QVariantList result;
+    const auto snapshots = PciInventoryHistory::instance().snapshots(host, from, to);
+    for (const PciInventoryHistory::Snapshot &snapshot : snapshots) {
+        QVariantMap entry;
+        entry["time"] = snapshot.time;
+        entry["deviceCount"] = snapshot.deviceCount;
+        result.append(entry);
+    }
+    return result;
+}
+
+QVariantMap PciManager::changesSince(const QString &host, const QDateTime &since) const
+{
+    const PciInventoryHistory::Changes changes = PciInventoryHistory::instance().changesSince(host, since);
+
+    QVariantList added, removed, changed;
+    for (const PciDevice &device : changes.added) {
+        added.append(deviceToVariant(device));
+    }
+    for (const PciDevice &device : changes.removed) {
+        removed.append(deviceToVariant(device));
+    }
+    for (const auto &pair : changes.changed) {
+        QVariantMap entry;
+        entry["before"] = deviceToVariant(pair.first);
+        entry["after"] = deviceToVariant(pair.second);
+        changed.append(entry);
+    }
+
+    QVariantMap result;
+    result["since"] = changes.since;
+    result["until"] = changes.until;
+    result["added"] = added;
+    result["removed"] = removed;
+    result["changed"] = changed;
+    return result;
+}
+
+void PciManager::lookupHostName(const QString &host)
+{
+    QHostInfo::lookupHost(host, this, [this, host](const QHostInfo &info) {
+        if (!m_store.contains(host) || info.error() != QHostInfo::NoError) return;
+        if (info.hostName().isEmpty() || info.hostName() == host) return;
+
+        m_store.host(host).hostName = m_store.strings().intern(info.hostName());
+        emit hostsChanged();
+    });
 }
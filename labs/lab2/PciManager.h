@@ -2,73 +2,106 @@
 #define PCIMANAGER_H
 
 #include <QObject>
-#include <QTcpServer>
-#include <QTcpSocket>
-#include <QJsonArray>
-#include <QJsonObject>
-#include <memory>
-
-struct PciDevice {
-    int bus;
-    int device;
-    int function;
-    QString vendorID;
-    QString deviceID;
-};
+#include <QDateTime>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QPointer>
+#include "PciStreamParser.h"
+#include "PciDeviceModel.h"
+#include "PciIngestWorker.h"
+#include "common/InventoryStore.h"
 
 class PciManager : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool serverRunning READ isServerRunning NOTIFY serverRunningChanged)
     Q_PROPERTY(QString serverStatus READ serverStatus NOTIFY serverStatusChanged)
-    Q_PROPERTY(QJsonArray devices READ devices NOTIFY devicesChanged)
+    Q_PROPERTY(PciDeviceModel *deviceModel READ deviceModel CONSTANT)
     Q_PROPERTY(QString clientIP READ clientIP NOTIFY clientIPChanged)
     Q_PROPERTY(int deviceCount READ deviceCount NOTIFY devicesChanged)
+    Q_PROPERTY(int totalDeviceCount READ totalDeviceCount NOTIFY hostsChanged)
+    Q_PROPERTY(QVariantList hosts READ hosts NOTIFY hostsChanged)
+    Q_PROPERTY(int hostCount READ hostCount NOTIFY hostsChanged)
+    Q_PROPERTY(int connectionCount READ connectionCount NOTIFY connectionCountChanged)
+    Q_PROPERTY(QString selectedHost READ selectedHost WRITE setSelectedHost NOTIFY selectedHostChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
 
 public:
     explicit PciManager(QObject *parent = nullptr);
     ~PciManager();
 
-    bool isServerRunning() const;
+    bool isServerRunning() const { return m_serverRunning; }
     QString serverStatus() const { return m_serverStatus; }
-    QJsonArray devices() const { return m_devices; }
+    // Устройства выбранного хоста, без выбора — всех хостов
+    PciDeviceModel *deviceModel() const { return m_deviceModel; }
     QString clientIP() const { return m_clientIP; }
-    int deviceCount() const { return m_deviceList.size(); }
+    int deviceCount() const { return m_deviceModel->rowCount(); }
+    int totalDeviceCount() const;
+    QVariantList hosts() const;
+    int hostCount() const { return m_store.hostCount(); }
+    int connectionCount() const { return m_connectionCount; }
+    QString selectedHost() const { return m_selectedHost; }
+    void setSelectedHost(const QString &host);
+    bool isActive() const { return m_active; }
 
+    // Сервер слушает порт только пока страница лабораторной в StackView
+    Q_INVOKABLE void activate();
+    Q_INVOKABLE void suspend();
     Q_INVOKABLE void startServer();
     Q_INVOKABLE void stopServer();
     Q_INVOKABLE void clearDevices();
     Q_INVOKABLE QString getLocalIP() const;
     Q_INVOKABLE QString getVendorName(const QString &vendorID) const;
+    Q_INVOKABLE QString getDeviceName(const QString &vendorID, const QString &deviceID) const;
+    Q_INVOKABLE int hostDeviceCount(const QString &host) const;
+    // История инвентаризаций (PciInventoryHistory): снимки хоста за интервал
+    // и изменения с момента since до последней инвентаризации
+    Q_INVOKABLE QVariantList history(const QString &host, const QDateTime &from, const QDateTime &to) const;
+    Q_INVOKABLE QVariantMap changesSince(const QString &host, const QDateTime &since) const;
+    // Память под инвентаризации хоста, пустой host — всех хостов
+    Q_INVOKABLE QVariantMap memoryReport(const QString &host = QString()) const;
 
 signals:
     void serverRunningChanged();
     void serverStatusChanged();
     void devicesChanged();
+    void hostsChanged();
+    void connectionCountChanged();
+    void selectedHostChanged();
     void clientIPChanged();
+    void activeChanged();
     void logMessage(const QString &message);
     void errorOccurred(const QString &error);
 
-private slots:
-    void onNewConnection();
-    void onReadyRead();
-    void onDisconnected();
-
 private:
-    std::unique_ptr<QTcpServer> m_tcpServer;
-    QTcpSocket* m_currentClient;
+    // Живёт в IoThread, удаляется через IoThread::dispose
+    QPointer<PciIngestWorker> m_worker;
+    // Единственная копия инвентаризаций; объявлено до m_deviceModel,
+    // который ссылается на его пул строк
+    InventoryStore m_store;
+    QString m_selectedHost;
     QString m_serverStatus;
     QString m_clientIP;
-    QByteArray m_buffer;
-    QJsonArray m_devices;
-    QList<PciDevice> m_deviceList;
-    QHash<QString, QString> m_vendorDatabase;
+    PciDeviceModel *m_deviceModel;
+    int m_connectionCount;
+    bool m_serverRunning;
+    bool m_active;
 
     static constexpr int SERVER_PORT = 12345;
 
     void setServerStatus(const QString &status);
-    void updateDevices(const QJsonArray &devices);
-    void initVendorDatabase();
+    void onWorkerStarted(bool ok, const QString &error);
+    void onWorkerStopped();
+    void onConnectionsChanged(int connectionCount, const QString &lastClient);
+    void onHostsUpdated(const QList<PciHostSnapshot> &snapshots, int completedScans);
+    void setDevices(InventoryStore::Host &host, const QList<PciDevice> &devices);
+    // Изменения агента; затронутые строки модели добавляются в changedRows
+    // и removedRows, если они не nullptr
+    void applyDelta(InventoryStore::Host &host, const QList<PciDevice> &changed, const QList<int> &removed,
+                    QList<PciDeviceModel::Row> *changedRows, QList<PciDeviceModel::Row> *removedRows);
+    void restoreHistory();
+    void rebuildDevices();
+    void lookupHostName(const QString &host);
 };
 
 #endif // PCIMANAGER_H
@@ -0,0 +1,141 @@
+#include "PciStreamParser.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+
+static quint16 parseId(const QString &text)
+{
+    bool ok = false;
+    const uint value = text.toUInt(&ok, 16);
+    return ok && value <= 0xFFFF ? quint16(value) : quint16(0xFFFF);
+}
+
+static bool isJsonSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+void PciStreamParser::reset()
+{
+    m_state = State::ExpectArray;
+    m_element.clear();
+    m_depth = 0;
+    m_inString = false;
+    m_escape = false;
+    m_elementCount = 0;
+    m_error.clear();
+}
+
+bool PciStreamParser::fail(const QString &error)
+{
+    m_state = State::Error;
+    m_element.clear();
+    m_error = error;
+    return false;
+}
+
+bool PciStreamParser::feed(const char *data, qsizetype size)
+{
+    qsizetype i = 0;
+    while (i < size) {
+        switch (m_state) {
+        case State::Error:
+            return false;
+
+        case State::ExpectArray: {
+            const char c = data[i++];
+            if (isJsonSpace(c)) break;
+            if (c != '[') return fail(QString("Ожидался '[', получен '%1'").arg(QChar(c)));
+            m_state = State::ExpectElement;
+            m_elementCount = 0;
+            if (arrayStarted) arrayStarted();
+            break;
+        }
+
+        case State::ExpectElement: {
+            const char c = data[i++];
+            if (isJsonSpace(c)) break;
+            if (c == ']') {
+                m_state = State::ExpectArray;
+                if (arrayFinished) arrayFinished(m_elementCount);
+                break;
+            }
+            if (c != '{') return fail(QString("Ожидался объект устройства, получен '%1'").arg(QChar(c)));
+            m_element.clear();
+            m_element.append(c);
+            m_depth = 1;
+            m_state = State::InElement;
+            break;
+        }
+
+        case State::InElement: {
+            // Копируем элемент кусками до закрывающей скобки верхнего уровня
+            const qsizetype start = i;
+            while (i < size && m_depth > 0) {
+                const char c = data[i++];
+                if (m_inString) {
+                    if (m_escape) {
+                        m_escape = false;
+                    } else if (c == '\\') {
+                        m_escape = true;
+                    } else if (c == '"') {
+                        m_inString = false;
+                    }
+                } else if (c == '"') {
+                    m_inString = true;
+                } else if (c == '{' || c == '[') {
+                    ++m_depth;
+                } else if (c == '}' || c == ']') {
+                    --m_depth;
+                }
+            }
+            if (m_element.size() + (i - start) > MAX_ELEMENT_SIZE) {
+                return fail(QString("Устройство %1 длиннее %2 байт").arg(m_elementCount + 1).arg(MAX_ELEMENT_SIZE));
+            }
+            m_element.append(data + start, i - start);
+            if (m_depth == 0) {
+                finishElement();
+                if (m_state == State::Error) return false;
+                m_state = State::AfterElement;
+            }
+            break;
+        }
+
+        case State::AfterElement: {
+            const char c = data[i++];
+            if (isJsonSpace(c)) break;
+            if (c == ',') {
+                m_state = State::ExpectElement;
+            } else if (c == ']') {
+                m_state = State::ExpectArray;
+                if (arrayFinished) arrayFinished(m_elementCount);
+            } else {
+                return fail(QString("Ожидался ',' или ']', получен '%1'").arg(QChar(c)));
+            }
+            break;
+        }
+        }
+    }
+    return m_state != State::Error;
+}
+
+void PciStreamParser::finishElement()
+{
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(m_element, &error);
+    m_element.clear();
+    if (!doc.isObject()) {
+        fail(QString("Ошибка разбора устройства %1: %2").arg(m_elementCount + 1).arg(error.errorString()));
+        return;
+    }
+
+    const QJsonObject obj = doc.object();
+    PciDevice device;
+    device.bus = quint8(obj["bus"].toInt());
+    device.device = quint8(obj["device"].toInt() & 0x1F);
+    device.function = quint8(obj["function"].toInt() & 0x07);
+    device.vendorId = parseId(obj["vendorID"].toString());
+    device.deviceId = parseId(obj["deviceID"].toString());
+
+    ++m_elementCount;
+    if (deviceParsed) deviceParsed(device);
+}
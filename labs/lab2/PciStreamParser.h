@@ -0,0 +1,65 @@
+#ifndef PCISTREAMPARSER_H
+#define PCISTREAMPARSER_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+// Устройство в том виде, в каком его передаёт сканер. Идентификаторы —
+// числа; нераспознанный идентификатор в JSON становится 0xFFFF
+struct PciDevice {
+    quint8 bus = 0;
+    quint8 device = 0;
+    quint8 function = 0;
+    quint16 vendorId = 0xFFFF;
+    quint16 deviceId = 0xFFFF;
+    // 64 байта стандартного заголовка, если сканер их передал (двоичный протокол)
+    QByteArray configHeader;
+};
+
+// Потоковый разбор JSON-массива устройств из сокета. Каждый байт
+// просматривается один раз; как только очередной элемент массива закрыт,
+// он разбирается и отдаётся в deviceParsed, не дожидаясь конца передачи.
+// После ']' парсер ждёт следующий массив в том же соединении
+class PciStreamParser
+{
+public:
+    std::function<void()> arrayStarted;
+    std::function<void(const PciDevice &device)> deviceParsed;
+    std::function<void(int deviceCount)> arrayFinished;
+
+    // Элемент массива длиннее этого — ошибка: незакрытая '{' из сети не
+    // должна расти в памяти без конца. Запись сканера — около 100 байт
+    static constexpr qsizetype MAX_ELEMENT_SIZE = 64 * 1024;
+
+    // false — поток повреждён; дальнейшие данные игнорируются до reset()
+    bool feed(const char *data, qsizetype size);
+    bool feed(const QByteArray &data) { return feed(data.constData(), data.size()); }
+    void reset();
+
+    bool inArray() const { return m_state != State::ExpectArray && m_state != State::Error; }
+    int elementCount() const { return m_elementCount; }
+    QString errorString() const { return m_error; }
+
+private:
+    enum class State {
+        ExpectArray,
+        ExpectElement,
+        InElement,
+        AfterElement,
+        Error
+    };
+
+    void finishElement();
+    bool fail(const QString &error);
+
+    State m_state = State::ExpectArray;
+    QByteArray m_element;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+    int m_elementCount = 0;
+    QString m_error;
+};
+
+#endif // PCISTREAMPARSER_H
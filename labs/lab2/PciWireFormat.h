@@ -0,0 +1,357 @@
+#ifndef PCIWIREFORMAT_H
+#define PCIWIREFORMAT_H
+
+// Двоичный протокол сканера PCI. Заголовок без Qt: его собирает и сканер
+// под Windows XP, и сервер.
+//
+// Соединение начинается с приветствия "PCIB" <версия:1> <флаги:1>; сервер
+// отвечает "PCIB" <версия:1>. Нет ответа — сканер переподключается и шлёт
+// JSON, как раньше. Дальше идут кадры <длина:4 LE> <тип:1> <данные:длина>:
+//   FRAME_DEVICES        записи по 7 байт: bus, device, function, vendor:2, device:2
+//   FRAME_CONFIG_HEADERS записи bus, device, function + 64 байта заголовка
+//   FRAME_END            конец инвентаризации, данных нет
+// После FRAME_END в том же соединении может начаться следующая.
+//
+// Версия 2 — постоянное соединение агента (флаг FLAG_DELTAS). После первой
+// полной инвентаризации агент шлёт только изменения:
+//   FRAME_DEVICES, FRAME_CONFIG_HEADERS  добавленные и изменившиеся функции
+//   FRAME_REMOVED        записи по 3 байта: bus, device, function
+//   FRAME_DELTA_END      конец изменений; они применяются к последней
+//                        инвентаризации этого соединения
+//   FRAME_HEARTBEAT      хост жив, изменений нет
+// Сразу после приветствия агент может прислать FRAME_HOST с именем хоста
+// (UTF-8, до MAX_HOST_ID_SIZE байт). Сервер ведёт агента по этому имени, а
+// не по адресу: за NAT у многих хостов один адрес. У хоста одно соединение
+// агента, новое заменяет прежнее. Старые серверы кадр пропускают
+
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace PciWire {
+
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+
+const char MAGIC[4] = {'P', 'C', 'I', 'B'};
+const u8 VERSION = 2;
+const u8 DELTA_VERSION = 2;
+
+const u8 FLAG_CONFIG_HEADERS = 0x01;
+const u8 FLAG_DELTAS = 0x02;
+
+const u8 FRAME_DEVICES = 1;
+const u8 FRAME_CONFIG_HEADERS = 2;
+const u8 FRAME_REMOVED = 3;
+const u8 FRAME_DELTA_END = 4;
+const u8 FRAME_HEARTBEAT = 5;
+const u8 FRAME_HOST = 6;
+const u8 FRAME_END = 0xFF;
+
+const size_t HELLO_SIZE = 6;
+const size_t ACK_SIZE = 5;
+const size_t FRAME_HEADER_SIZE = 5;
+const size_t DEVICE_RECORD_SIZE = 7;
+const size_t REMOVED_RECORD_SIZE = 3;
+const size_t CONFIG_HEADER_SIZE = 64;
+const size_t CONFIG_RECORD_SIZE = 3 + CONFIG_HEADER_SIZE;
+// Больше не нужно даже для 256 шин по 32 устройства по 8 функций
+const u32 MAX_FRAME_SIZE = 4 * 1024 * 1024;
+const size_t MAX_HOST_ID_SIZE = 255;
+
+struct DeviceRecord {
+    u8 bus;
+    u8 device;
+    u8 function;
+    u16 vendorId;
+    u16 deviceId;
+};
+
+inline void putU16(std::string &out, u16 value)
+{
+    out.push_back(char(value & 0xFF));
+    out.push_back(char(value >> 8));
+}
+
+inline void putU32(std::string &out, u32 value)
+{
+    out.push_back(char(value & 0xFF));
+    out.push_back(char((value >> 8) & 0xFF));
+    out.push_back(char((value >> 16) & 0xFF));
+    out.push_back(char(value >> 24));
+}
+
+inline u16 getU16(const u8 *data)
+{
+    return u16(data[0] | (data[1] << 8));
+}
+
+inline u32 getU32(const u8 *data)
+{
+    return u32(data[0]) | (u32(data[1]) << 8) | (u32(data[2]) << 16) | (u32(data[3]) << 24);
+}
+
+inline void appendHello(std::string &out, u8 flags)
+{
+    out.append(MAGIC, 4);
+    out.push_back(char(VERSION));
+    out.push_back(char(flags));
+}
+
+inline void appendAck(std::string &out, u8 version)
+{
+    out.append(MAGIC, 4);
+    out.push_back(char(version));
+}
+
+inline bool isAck(const char *data, size_t size)
+{
+    return size >= ACK_SIZE && memcmp(data, MAGIC, 4) == 0 && u8(data[4]) >= 1;
+}
+
+// Версия, на которой говорит сервер; дельты — только с DELTA_VERSION
+inline u8 ackVersion(const char *data)
+{
+    return u8(data[4]) < VERSION ? u8(data[4]) : VERSION;
+}
+
+inline void appendDevicesFrame(std::string &out, const DeviceRecord *records, size_t count)
+{
+    putU32(out, u32(count * DEVICE_RECORD_SIZE));
+    out.push_back(char(FRAME_DEVICES));
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(char(records[i].bus));
+        out.push_back(char(records[i].device));
+        out.push_back(char(records[i].function));
+        putU16(out, records[i].vendorId);
+        putU16(out, records[i].deviceId);
+    }
+}
+
+// headers — count заголовков по CONFIG_HEADER_SIZE байт в порядке records
+inline void appendConfigHeadersFrame(std::string &out, const DeviceRecord *records,
+                                     const u8 *headers, size_t count)
+{
+    putU32(out, u32(count * CONFIG_RECORD_SIZE));
+    out.push_back(char(FRAME_CONFIG_HEADERS));
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(char(records[i].bus));
+        out.push_back(char(records[i].device));
+        out.push_back(char(records[i].function));
+        out.append(reinterpret_cast<const char *>(headers + i * CONFIG_HEADER_SIZE), CONFIG_HEADER_SIZE);
+    }
+}
+
+inline void appendEndFrame(std::string &out)
+{
+    putU32(out, 0);
+    out.push_back(char(FRAME_END));
+}
+
+// records — удалённые функции, vendorId и deviceId не передаются
+inline void appendRemovedFrame(std::string &out, const DeviceRecord *records, size_t count)
+{
+    putU32(out, u32(count * REMOVED_RECORD_SIZE));
+    out.push_back(char(FRAME_REMOVED));
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(char(records[i].bus));
+        out.push_back(char(records[i].device));
+        out.push_back(char(records[i].function));
+    }
+}
+
+inline void appendDeltaEndFrame(std::string &out)
+{
+    putU32(out, 0);
+    out.push_back(char(FRAME_DELTA_END));
+}
+
+inline void appendHeartbeatFrame(std::string &out)
+{
+    putU32(out, 0);
+    out.push_back(char(FRAME_HEARTBEAT));
+}
+
+// hostId — непустое имя не длиннее MAX_HOST_ID_SIZE байт
+inline void appendHostFrame(std::string &out, const std::string &hostId)
+{
+    putU32(out, u32(hostId.size()));
+    out.push_back(char(FRAME_HOST));
+    out.append(hostId);
+}
+
+// Инкрементальный разбор потока сервером: данные можно подавать любыми
+// кусками, каждый кадр разбирается один раз, когда пришёл целиком
+class Decoder
+{
+public:
+    std::function<void(u8 version, u8 flags)> helloReceived;
+    std::function<void()> inventoryStarted;
+    std::function<void(const DeviceRecord &record)> deviceDecoded;
+    std::function<void(const DeviceRecord &record, const u8 *header)> configHeaderDecoded;
+    std::function<void(size_t deviceCount)> inventoryFinished;
+    std::function<void(const DeviceRecord &record)> functionRemoved;
+    // Изменения закончены: changedCount добавленных и изменившихся, removedCount удалённых
+    std::function<void(size_t changedCount, size_t removedCount)> deltaFinished;
+    std::function<void()> heartbeatReceived;
+    std::function<void(const std::string &hostId)> hostReceived;
+
+    Decoder() { reset(); }
+
+    void reset()
+    {
+        m_buffer.clear();
+        m_offset = 0;
+        m_helloReceived = false;
+        m_inInventory = false;
+        m_deviceCount = 0;
+        m_removedCount = 0;
+        m_error = 0;
+    }
+
+    bool inInventory() const { return m_inInventory; }
+    size_t deviceCount() const { return m_deviceCount; }
+    const char *error() const { return m_error; }
+
+    // false — поток повреждён, причина в error()
+    bool feed(const char *data, size_t size)
+    {
+        if (m_error) return false;
+
+        m_buffer.insert(m_buffer.end(), data, data + size);
+        while (!m_error) {
+            const size_t available = m_buffer.size() - m_offset;
+            if (available == 0) break;
+            const u8 *p = &m_buffer[m_offset];
+
+            if (!m_helloReceived) {
+                if (available < HELLO_SIZE) break;
+                if (memcmp(p, MAGIC, 4) != 0) return fail("bad magic");
+                if (p[4] < 1 || p[4] > VERSION) return fail("unsupported version");
+                m_helloReceived = true;
+                m_offset += HELLO_SIZE;
+                if (helloReceived) helloReceived(p[4], p[5]);
+                continue;
+            }
+
+            if (available < FRAME_HEADER_SIZE) break;
+            const u32 length = getU32(p);
+            if (length > MAX_FRAME_SIZE) return fail("frame too large");
+            if (available < FRAME_HEADER_SIZE + length) break;
+
+            decodeFrame(p[4], p + FRAME_HEADER_SIZE, length);
+            if (m_error) return false;
+            m_offset += FRAME_HEADER_SIZE + length;
+        }
+
+        // Сдвигаем разобранное, когда оно занимает больше половины буфера
+        if (m_offset > 0 && m_offset * 2 >= m_buffer.size()) {
+            m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_offset);
+            m_offset = 0;
+        }
+        return m_error == 0;
+    }
+
+private:
+    bool fail(const char *error)
+    {
+        m_error = error;
+        m_buffer.clear();
+        m_offset = 0;
+        return false;
+    }
+
+    void beginInventory()
+    {
+        if (m_inInventory) return;
+        m_inInventory = true;
+        m_deviceCount = 0;
+        m_removedCount = 0;
+        if (inventoryStarted) inventoryStarted();
+    }
+
+    void decodeFrame(u8 type, const u8 *data, u32 length)
+    {
+        if (type == FRAME_DEVICES) {
+            if (length % DEVICE_RECORD_SIZE != 0) {
+                fail("bad device frame");
+                return;
+            }
+            beginInventory();
+            for (u32 i = 0; i < length; i += DEVICE_RECORD_SIZE) {
+                DeviceRecord record;
+                record.bus = data[i];
+                record.device = data[i + 1];
+                record.function = data[i + 2];
+                record.vendorId = getU16(data + i + 3);
+                record.deviceId = getU16(data + i + 5);
+                ++m_deviceCount;
+                if (deviceDecoded) deviceDecoded(record);
+            }
+        } else if (type == FRAME_CONFIG_HEADERS) {
+            if (length % CONFIG_RECORD_SIZE != 0) {
+                fail("bad config header frame");
+                return;
+            }
+            beginInventory();
+            for (u32 i = 0; i < length; i += CONFIG_RECORD_SIZE) {
+                DeviceRecord record;
+                record.bus = data[i];
+                record.device = data[i + 1];
+                record.function = data[i + 2];
+                record.vendorId = getU16(data + i + 3);
+                record.deviceId = getU16(data + i + 5);
+                if (configHeaderDecoded) configHeaderDecoded(record, data + i + 3);
+            }
+        } else if (type == FRAME_REMOVED) {
+            if (length % REMOVED_RECORD_SIZE != 0) {
+                fail("bad removed frame");
+                return;
+            }
+            beginInventory();
+            for (u32 i = 0; i < length; i += REMOVED_RECORD_SIZE) {
+                DeviceRecord record;
+                record.bus = data[i];
+                record.device = data[i + 1];
+                record.function = data[i + 2];
+                record.vendorId = 0xFFFF;
+                record.deviceId = 0xFFFF;
+                ++m_removedCount;
+                if (functionRemoved) functionRemoved(record);
+            }
+        } else if (type == FRAME_DELTA_END) {
+            beginInventory();
+            m_inInventory = false;
+            if (deltaFinished) deltaFinished(m_deviceCount, m_removedCount);
+        } else if (type == FRAME_HEARTBEAT) {
+            if (heartbeatReceived) heartbeatReceived();
+        } else if (type == FRAME_HOST) {
+            // Имя хоста — только до первой инвентаризации
+            if (length == 0 || length > MAX_HOST_ID_SIZE || m_inInventory) {
+                fail("bad host frame");
+                return;
+            }
+            if (hostReceived) hostReceived(std::string(reinterpret_cast<const char *>(data), length));
+        } else if (type == FRAME_END) {
+            beginInventory();
+            m_inInventory = false;
+            if (inventoryFinished) inventoryFinished(m_deviceCount);
+        }
+        // Неизвестные кадры пропускаем: их может добавить следующая версия
+    }
+
+    std::vector<u8> m_buffer;
+    size_t m_offset;
+    bool m_helloReceived;
+    bool m_inInventory;
+    size_t m_deviceCount;
+    size_t m_removedCount;
+    const char *m_error;
+};
+
+} // namespace PciWire
+
+#endif // PCIWIREFORMAT_H
@@ -1,17 +1,48 @@
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #define _WINSOCKAPI_
 #include <winsock2.h>
 #include <ws2tcpip.h>
-#include <windows.h>  
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
 #include <iostream>
 #include <vector>
-#include <cstring> 
+#include <cstring>
+#include <cstdlib>
 #include <string>
-#include <sstream>
-#include <iomanip>
 #include <cstdio>
-
-#pragma comment(lib, "ws2_32.lib")
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include "PciConfigAccess.h"
+#include "PciConfigSpace.h"
+#include "PciEnumerator.h"
+#include "PciAgent.h"
+#include "PciWireFormat.h"
+#include "common/IngestProtocol.h"
+
+#ifdef _WIN32
+typedef int socklen_t;
+static int lastSocketError() { return WSAGetLastError(); }
+#else
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned int DWORD;
+typedef int SOCKET;
+const SOCKET INVALID_SOCKET = -1;
+const int SOCKET_ERROR = -1;
+static int closesocket(SOCKET sock) { return close(sock); }
+static int lastSocketError() { return errno; }
+#endif
 
 #pragma pack(push, 1)
 struct PciEntry {
@@ -23,73 +54,42 @@ struct PciEntry {
 };
 #pragma pack(pop)
 
-typedef BOOL (__stdcall *FnInit)();
-typedef void (__stdcall *FnShutdown)();
-typedef BOOL (__stdcall *FnOutPort)(WORD, DWORD, BYTE);
-typedef BOOL (__stdcall *FnInPort)(WORD, PDWORD, BYTE);
-
-DWORD readPciConfig(FnOutPort outPort, FnInPort inPort,
-                    BYTE bus, BYTE device, BYTE function, BYTE offset)
+// Таймауты приёма и передачи: в Windows миллисекунды, в POSIX timeval
+static void setSocketTimeout(SOCKET sock, int option, int milliseconds)
 {
-    DWORD cfgAddr = (1UL << 31) | ((DWORD)bus << 16)
-                  | ((DWORD)device << 11) | ((DWORD)function << 8)
-                  | (offset & 0xFC);
-    if (!outPort(0xCF8, cfgAddr, 4))
-        return 0xFFFFFFFF;
-
-    DWORD cfgData = 0xFFFFFFFF;
-    if (!inPort(0xCFC, &cfgData, 4))
-        return 0xFFFFFFFF;
-
-    return cfgData;
+#ifdef _WIN32
+    DWORD timeout = milliseconds;
+#else
+    timeval timeout;
+    timeout.tv_sec = milliseconds / 1000;
+    timeout.tv_usec = (milliseconds % 1000) * 1000;
+#endif
+    setsockopt(sock, SOL_SOCKET, option, (const char*)&timeout, sizeof(timeout));
 }
 
-std::string createJsonFromVector(const std::vector<PciEntry>& data)
+// Без консоли (CI, ssh) пауза не нужна
+static void pauseIfInteractive(bool interactive)
 {
-    std::string out;
-    out.reserve(2048);
-    out.push_back('[');
-
-    for (size_t i = 0; i < data.size(); ++i) {
-        if (i) out.push_back(',');
-
-        char buf[128];
-        sprintf_s(buf, sizeof(buf),
-            "{\"bus\":%u,\"device\":%u,\"function\":%u,"
-            "\"vendorID\":\"%04X\",\"deviceID\":\"%04X\"}",
-            (unsigned int)data[i].busNum,
-            (unsigned int)data[i].devNum,
-            (unsigned int)data[i].funcNum,
-            (unsigned int)data[i].venID,
-            (unsigned int)data[i].devID);
-
-        out += buf;
-    }
-
-    out.push_back(']');
-    return out;
+#ifdef _WIN32
+    if (interactive)
+        system("pause");
+#else
+    (void)interactive;
+#endif
 }
 
-bool sendToServer(const char* ipAddr, int port, const std::vector<PciEntry>& data)
+// Подключение с таймаутами; INVALID_SOCKET при ошибке. quiet — не сообщать
+// об отказе: порт пробуется первым, и без него есть запасной
+SOCKET connectToServer(const char* ipAddr, int port, bool quiet = false)
 {
-    std::cout << "Connecting to " << ipAddr << ":" << port << "...\n";
-    
-    WSADATA wsa;
-    if (WSAStartup(MAKEWORD(2,2), &wsa) != 0) {
-        std::cerr << "WSAStartup failed\n";
-        return false;
-    }
-
     SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (sock == INVALID_SOCKET) {
         std::cerr << "Socket creation failed\n";
-        WSACleanup();
-        return false;
+        return INVALID_SOCKET;
     }
 
-    int timeout = 5000;
-    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    setSocketTimeout(sock, SO_SNDTIMEO, 5000);
+    setSocketTimeout(sock, SO_RCVTIMEO, 5000);
 
     sockaddr_in srv = {};
     srv.sin_family = AF_INET;
@@ -99,169 +99,910 @@ bool sendToServer(const char* ipAddr, int port, const std::vector<PciEntry>& dat
     if (srv.sin_addr.s_addr == INADDR_NONE) {
         std::cerr << "Invalid IP address\n";
         closesocket(sock);
-        WSACleanup();
-        return false;
+        return INVALID_SOCKET;
     }
 
     if (connect(sock, reinterpret_cast<sockaddr*>(&srv), sizeof(srv)) != 0) {
-        std::cerr << "Connection failed, WSAGetLastError=" << WSAGetLastError() << "\n";
+        if (!quiet)
+            std::cerr << "Connection failed, error " << lastSocketError() << "\n";
         closesocket(sock);
-        WSACleanup();
-        return false;
+        return INVALID_SOCKET;
     }
-    
-    std::cout << "Connected successfully!\n";
 
-    std::string json = createJsonFromVector(data);
-    if (json.empty()) {
-        std::cerr << "Nothing to send (empty JSON)\n";
-        closesocket(sock);
-        WSACleanup();
-        return false;
-    }
+    return sock;
+}
 
-    const char* ptr = json.c_str();
-    int bytesToSend = static_cast<int>(json.size());
-    std::cout << "Sending JSON (" << bytesToSend << " bytes)...\n";
+bool sendAll(SOCKET sock, const std::string& payload)
+{
+    const char* ptr = payload.data();
+    int bytesToSend = static_cast<int>(payload.size());
 
     int totalSent = 0;
     while (totalSent < bytesToSend) {
         int n = send(sock, ptr + totalSent, bytesToSend - totalSent, 0);
         if (n == SOCKET_ERROR) {
-            int err = WSAGetLastError();
-            std::cerr << "Send failed: " << err << "\n";
-            closesocket(sock);
-            WSACleanup();
+            std::cerr << "Send failed: " << lastSocketError() << "\n";
             return false;
         }
         if (n == 0) {
             std::cerr << "Send returned 0 (peer closed?)\n";
-            break;
+            return false;
         }
         totalSent += n;
     }
+    return true;
+}
 
-    std::cout << "Sent " << totalSent << " bytes\n";
+// Приветствие двоичного протокола; версия сервера или 0, если он протокол не понимает
+int negotiateBinary(SOCKET sock, BYTE flags)
+{
+    std::string hello;
+    PciWire::appendHello(hello, flags);
+    if (send(sock, hello.data(), static_cast<int>(hello.size()), 0) != static_cast<int>(hello.size()))
+        return 0;
+
+    // Старый сервер молчит или закрывает соединение на непонятных данных
+    setSocketTimeout(sock, SO_RCVTIMEO, 2000);
+
+    char ack[PciWire::ACK_SIZE];
+    int received = 0;
+    while (received < (int)sizeof(ack)) {
+        int n = recv(sock, ack + received, (int)sizeof(ack) - received, 0);
+        if (n <= 0)
+            return 0;
+        received += n;
+    }
+    return PciWire::isAck(ack, sizeof(ack)) ? PciWire::ackVersion(ack) : 0;
+}
 
+// Общий порт приёма (IngestProtocol.h): сервер отвечает на приветствие LCDI
+// тем же. INVALID_SOCKET, если порт не слушается или это не он
+SOCKET connectToIngest(const char* ipAddr, int port)
+{
+    if (port <= 0)
+        return INVALID_SOCKET;
+    SOCKET sock = connectToServer(ipAddr, port, true);
+    if (sock == INVALID_SOCKET)
+        return INVALID_SOCKET;
+
+    std::string hello;
+    Ingest::appendHello(hello);
+    setSocketTimeout(sock, SO_RCVTIMEO, 2000);
+    char ack[Ingest::HELLO_SIZE];
+    int received = 0;
+    if (send(sock, hello.data(), static_cast<int>(hello.size()), 0) == static_cast<int>(hello.size())) {
+        while (received < (int)sizeof(ack)) {
+            int n = recv(sock, ack + received, (int)sizeof(ack) - received, 0);
+            if (n <= 0)
+                break;
+            received += n;
+        }
+    }
+    if (received == (int)sizeof(ack) && Ingest::isHello(ack, sizeof(ack)))
+        return sock;
     closesocket(sock);
-    WSACleanup();
-    return (totalSent == bytesToSend);
+    return INVALID_SOCKET;
 }
 
-int main()
+// Данные PciWire на общем порту идут сообщениями KIND_PCI_BINARY
+bool sendPayload(SOCKET sock, bool ingest, const std::string& payload, std::string& message)
 {
-    std::cout << "PCI Scanner starting...\n";
-    
-    const char* dllPath = "C:\\WinIo\\Binaries\\WinIo32.dll";
-    
-    if (GetFileAttributesA(dllPath) == INVALID_FILE_ATTRIBUTES) {
-        std::cerr << "ERROR: " << dllPath << " not found!\n";
-        std::cerr << "Please create folder C:\\WinIo\\Binaries\\ and copy WinIo32.dll there\n";
-        system("pause");
-        return 1;
+    if (!ingest)
+        return sendAll(sock, payload);
+    message.clear();
+    Ingest::appendMessage(message, Ingest::KIND_PCI_BINARY, payload.data(), payload.size());
+    return sendAll(sock, message);
+}
+
+// Соединение открывается до обхода: приветствие и ответ сервера не ждут
+// конца сканирования. Сначала общий порт (ingest, всегда двоичный
+// протокол), затем порт PCI: binary — сервер принял двоичный протокол,
+// при отказе — повторное подключение для JSON
+SOCKET openInventoryConnection(const char* ipAddr, int port, int ingestPort, bool useBinary, bool withHeaders,
+                               bool& binary, bool& ingest)
+{
+    binary = false;
+    ingest = false;
+    if (useBinary && ingestPort > 0) {
+        std::cout << "Connecting to " << ipAddr << ":" << ingestPort << "...\n";
+        SOCKET sock = connectToIngest(ipAddr, ingestPort);
+        if (sock != INVALID_SOCKET) {
+            binary = true;
+            ingest = true;
+            return sock;
+        }
+        std::cout << "Shared ingest port is not available, using the PCI port\n";
     }
-    
-    const char* sysPath = "C:\\WinIo\\Binaries\\WinIo32.sys";
-    if (GetFileAttributesA(sysPath) == INVALID_FILE_ATTRIBUTES) {
-        std::cerr << "ERROR: " << sysPath << " not found!\n";
-        std::cerr << "Please copy WinIo32.sys to C:\\WinIo\\Binaries\\\n";
-        system("pause");
-        return 1;
+
+    std::cout << "Connecting to " << ipAddr << ":" << port << "...\n";
+    SOCKET sock = connectToServer(ipAddr, port);
+    if (sock == INVALID_SOCKET || !useBinary)
+        return sock;
+
+    if (negotiateBinary(sock, withHeaders ? PciWire::FLAG_CONFIG_HEADERS : 0) > 0) {
+        binary = true;
+        return sock;
     }
+    std::cout << "Server does not support binary protocol, falling back to JSON\n";
+    closesocket(sock);
+    return connectToServer(ipAddr, port);
+}
 
-    HMODULE hDll = LoadLibraryA(dllPath);
-    if (!hDll) {
-        DWORD err = GetLastError();
-        std::cerr << "Failed to load WinIo32.dll. Error: " << err << "\n";
-        system("pause");
-        return 1;
+template <size_t N>
+static char* putText(char* out, const char (&text)[N])
+{
+    memcpy(out, text, N - 1);
+    return out + N - 1;
+}
+
+// Четыре шестнадцатеричные цифры в верхнем регистре, как "%04X";
+// std::to_chars даёт нижний регистр и без ведущих нулей
+static char* putHex4(char* out, unsigned value)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    out[0] = digits[(value >> 12) & 0xF];
+    out[1] = digits[(value >> 8) & 0xF];
+    out[2] = digits[(value >> 4) & 0xF];
+    out[3] = digits[value & 0xF];
+    return out + 4;
+}
+
+// Инвентаризация уходит на сервер по ходу обхода: записи копятся в одном
+// буфере и отправляются пачками, когда набралось FLUSH_SIZE байт или
+// прошло FLUSH_INTERVAL с прошлой записи в сокет. Двоичный протокол —
+// несколько кадров FRAME_DEVICES/FRAME_CONFIG_HEADERS и FRAME_END, на общем
+// порту каждая пачка — отдельное сообщение; JSON — тот же массив, что и
+// раньше, только по частям
+class InventoryStream
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr size_t FLUSH_SIZE = 4096;
+    static constexpr int FLUSH_INTERVAL_MS = 10;
+
+    InventoryStream(SOCKET sock, bool binary, bool ingest, bool withHeaders)
+        : m_sock(sock), m_binary(binary), m_ingest(binary && ingest), m_withHeaders(binary && withHeaders)
+    {
+        m_buffer.reserve(FLUSH_SIZE + 256);
+        m_lastWrite = Clock::now();
     }
-    
-    std::cout << "WinIo32.dll loaded\n";
 
-    FnInit initLib = (FnInit)GetProcAddress(hDll, "InitializeWinIo");
-    FnShutdown shutdownLib = (FnShutdown)GetProcAddress(hDll, "ShutdownWinIo");
-    FnInPort getPortVal = (FnInPort)GetProcAddress(hDll, "GetPortVal");
-    FnOutPort setPortVal = (FnOutPort)GetProcAddress(hDll, "SetPortVal");
+    bool begin()
+    {
+        if (!m_binary) {
+            m_buffer.push_back('[');
+            return flush();
+        }
+        return true;
+    }
 
-    if (!initLib || !shutdownLib || !getPortVal || !setPortVal) {
-        std::cerr << "Failed to get WinIo functions\n";
-        FreeLibrary(hDll);
-        system("pause");
-        return 1;
+    // header — 64 байта заголовка, если сервер их принимает; иначе 0
+    bool add(const PciEntry& entry, const BYTE* header)
+    {
+        if (m_failed)
+            return false;
+
+        if (m_binary) {
+            PciWire::DeviceRecord record;
+            record.bus = entry.busNum;
+            record.device = entry.devNum;
+            record.function = entry.funcNum;
+            record.vendorId = entry.venID;
+            record.deviceId = entry.devID;
+            m_records.push_back(record);
+            m_pendingSize += PciWire::DEVICE_RECORD_SIZE;
+            if (m_withHeaders) {
+                m_headers.insert(m_headers.end(), header, header + PciWire::CONFIG_HEADER_SIZE);
+                m_pendingSize += PciWire::CONFIG_RECORD_SIZE;
+            }
+        } else {
+            appendJson(entry);
+            m_pendingSize = m_buffer.size();
+        }
+        ++m_count;
+
+        // Первая запись уходит сразу: сервер видит начало инвентаризации
+        // через миллисекунды после запуска
+        if (m_count == 1 || m_pendingSize >= FLUSH_SIZE
+            || Clock::now() - m_lastWrite >= std::chrono::milliseconds(FLUSH_INTERVAL_MS))
+            return flush();
+        return true;
     }
 
-    std::cout << "Initializing WinIo...\n";
-    if (!initLib()) {
-        std::cerr << "WinIo initialization failed!\n";
-        std::cerr << "Make sure:\n";
-        std::cerr << "1. You run as Administrator\n";
-        std::cerr << "2. WinIo32.sys is in C:\\WinIo\\Binaries\\\n";
-        std::cerr << "3. VMware IO settings are correct\n";
-        FreeLibrary(hDll);
-        system("pause");
-        return 1;
+    bool finish()
+    {
+        if (m_failed)
+            return false;
+        appendPending();
+        if (m_binary)
+            PciWire::appendEndFrame(m_buffer);
+        else
+            m_buffer.push_back(']');
+        return flush();
     }
-    
-    std::cout << "WinIo initialized successfully\n";
-    std::cout << "Scanning PCI devices...\n";
 
-    std::vector<PciEntry> pciDevices;
+    size_t bytesSent() const { return m_bytesSent; }
+    unsigned writes() const { return m_writes; }
+    Clock::time_point firstRecordSent() const { return m_firstRecordSent; }
+
+private:
+    void appendJson(const PciEntry& entry)
+    {
+        // Самая длинная запись — 91 байт, на число байта — не больше 3 цифр
+        char record[96];
+        char* out = record;
+        if (m_count)
+            *out++ = ',';
+        out = putText(out, "{\"bus\":");
+        out = std::to_chars(out, out + 3, unsigned(entry.busNum)).ptr;
+        out = putText(out, ",\"device\":");
+        out = std::to_chars(out, out + 3, unsigned(entry.devNum)).ptr;
+        out = putText(out, ",\"function\":");
+        out = std::to_chars(out, out + 3, unsigned(entry.funcNum)).ptr;
+        out = putText(out, ",\"vendorID\":\"");
+        out = putHex4(out, entry.venID);
+        out = putText(out, "\",\"deviceID\":\"");
+        out = putHex4(out, entry.devID);
+        out = putText(out, "\"}");
+        m_buffer.append(record, out - record);
+    }
 
-	int counter = 0;
-	int jj = 0;
-	int kk = 0;
-    for (int bus = 0; bus < 256; ++bus) {
-		kk++;
-		
-        for (int dev = 0; dev < 32; ++dev) {
-            DWORD baseData = readPciConfig(setPortVal, getPortVal, bus, dev, 0, 0);
-			jj++;
-            if (baseData == 0xFFFFFFFF)
-                continue;
+    // Накопленные записи двоичного протокола — в кадры
+    void appendPending()
+    {
+        if (!m_binary || m_records.empty())
+            return;
+        PciWire::appendDevicesFrame(m_buffer, &m_records[0], m_records.size());
+        if (m_withHeaders)
+            PciWire::appendConfigHeadersFrame(m_buffer, &m_records[0], &m_headers[0], m_records.size());
+        m_records.clear();
+        m_headers.clear();
+    }
+
+    bool flush()
+    {
+        appendPending();
+        m_pendingSize = 0;
+        if (m_buffer.empty())
+            return true;
+
+        if (!sendPayload(m_sock, m_ingest, m_buffer, m_message)) {
+            m_failed = true;
+            return false;
+        }
+        m_lastWrite = Clock::now();
+        ++m_writes;
+        if (m_count > 0 && m_firstRecordSent == Clock::time_point())
+            m_firstRecordSent = m_lastWrite;
+        m_bytesSent += m_ingest ? m_message.size() : m_buffer.size();
+        m_buffer.clear();   // ёмкость остаётся для следующей пачки
+        return true;
+    }
+
+    SOCKET m_sock;
+    bool m_binary;
+    bool m_ingest;
+    bool m_withHeaders;
+    bool m_failed = false;
+    std::string m_buffer;
+    std::string m_message;
+    std::vector<PciWire::DeviceRecord> m_records;
+    std::vector<BYTE> m_headers;
+    size_t m_pendingSize = 0;
+    size_t m_count = 0;
+    size_t m_bytesSent = 0;
+    unsigned m_writes = 0;
+    Clock::time_point m_lastWrite;
+    Clock::time_point m_firstRecordSent;
+};
+
+// Резидентный режим (--agent): одно постоянное соединение, повторная
+// проверка по таймеру и отправка только изменений (PciWire версии 2).
+// Снимки и изменения между ними — PciAgent.h, здесь сокет и расписание
+
+struct AgentOptions {
+    std::string server;
+    int port;
+    int ingestPort;         // общий порт, пробуется первым; 0 — только port
+    bool withHeaders;
+    PciEnumerator::Mode scanMode;
+    int intervalSeconds;    // между проверками, не меньше 1
+    int rescanEvery;        // полный обход раз в столько проверок
+    int heartbeatSeconds;   // без изменений — сигнал «жив» не реже
+    int cycles;             // 0 — бесконечно
+    std::string hostId;     // имя хоста для сервера, пусто — gethostname
+};
 
-            for (int func = 0; func < 8; ++func) {
-				counter++;
-                DWORD cfgVal = readPciConfig(setPortVal, getPortVal, bus, dev, func, 0);
-                WORD ven = (WORD)(cfgVal & 0xFFFF);
-                WORD devID = (WORD)((cfgVal >> 16) & 0xFFFF);
-
-                if (ven != 0xFFFF && ven != 0x0000) {
-                    PciEntry entry;
-                    entry.busNum = (BYTE)bus;
-                    entry.devNum = (BYTE)dev;
-                    entry.funcNum = (BYTE)func;
-                    entry.venID = ven;
-                    entry.devID = devID;
-                    pciDevices.push_back(entry);
-                    
-                    std::cout << "Found device: Bus " << (int)bus 
-                              << ", Dev " << (int)dev 
-                              << ", Func " << (int)func
-                              << ", VenID 0x" << std::hex << ven
-                              << ", DevID 0x" << devID << std::dec << "\n";
+static void sleepMilliseconds(int milliseconds)
+{
+#ifdef _WIN32
+    Sleep(milliseconds);
+#else
+    usleep(useconds_t(milliseconds) * 1000);
+#endif
+}
+
+// Сервер закрыл соединение: сокет читается, а данных нет. Агент сам
+// ничего не ждёт от сервера, поэтому любое чтение — это закрытие или ошибка
+static bool connectionClosed(SOCKET sock)
+{
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(sock, &readable);
+    timeval timeout = { 0, 0 };
+    if (select(int(sock) + 1, &readable, 0, 0, &timeout) <= 0)
+        return false;
+    char byte;
+    return recv(sock, &byte, 1, 0) <= 0;
+}
+
+// Имя, по которому сервер ведёт агента: за NAT адрес у хостов общий
+std::string agentHostId(const AgentOptions& options)
+{
+    std::string hostId = options.hostId;
+    if (hostId.empty()) {
+        char name[256] = {0};
+        if (gethostname(name, sizeof(name) - 1) == 0)
+            hostId = name;
+    }
+    if (hostId.size() > PciWire::MAX_HOST_ID_SIZE)
+        hostId.resize(PciWire::MAX_HOST_ID_SIZE);
+    return hostId;
+}
+
+int runAgent(PciConfigAccess& config, const AgentOptions& options)
+{
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2,2), &wsa) != 0) {
+        std::cerr << "WSAStartup failed\n";
+        return 1;
+    }
+#endif
+    const std::string hostId = agentHostId(options);
+
+    typedef std::chrono::steady_clock Clock;
+    PciEnumerator enumerator(config);
+    SOCKET sock = INVALID_SOCKET;
+    bool ingest = false;
+    bool deltas = false;
+    std::string message;
+    PciAgent::Inventory sent;
+    Clock::time_point lastSend = Clock::now();
+    int retryDelay = 1;
+
+    unsigned long long bytesSent = 0;
+    unsigned checks = 0, rescans = 0, updates = 0, heartbeats = 0;
+    double checkMilliseconds = 0;
+
+    std::cout << "Agent: " << (hostId.empty() ? "?" : hostId) << " -> " << options.server << ":"
+              << options.ingestPort << " or " << options.port << ", check every " << options.intervalSeconds << " s, full scan every " << options.rescanEvery << " checks\n";
+
+    for (int cycle = 0; options.cycles == 0 || cycle < options.cycles; ) {
+        if (sock == INVALID_SOCKET) {
+            // Общий порт изменения принимает всегда; нет его — порт PCI
+            int version = 0;
+            sock = connectToIngest(options.server.c_str(), options.ingestPort);
+            ingest = sock != INVALID_SOCKET;
+            if (ingest)
+                version = PciWire::VERSION;
+            else
+                sock = connectToServer(options.server.c_str(), options.port);
+            if (sock != INVALID_SOCKET && !ingest) {
+                BYTE flags = PciWire::FLAG_DELTAS;
+                if (options.withHeaders)
+                    flags |= PciWire::FLAG_CONFIG_HEADERS;
+                version = negotiateBinary(sock, flags);
+                if (version == 0) {
+                    std::cerr << "Server does not support the binary protocol\n";
+                    closesocket(sock);
+                    sock = INVALID_SOCKET;
                 }
             }
+            if (sock == INVALID_SOCKET) {
+                // Повтор с нарастающей паузой, но не реже интервала проверки
+                sleepMilliseconds(retryDelay * 1000);
+                retryDelay = std::min(retryDelay * 2, options.intervalSeconds);
+                continue;
+            }
+
+            // Старый сервер получает полные инвентаризации, но только при изменениях
+            retryDelay = 1;
+            deltas = version >= PciWire::DELTA_VERSION;
+            int keepAlive = 1;
+            setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (const char*)&keepAlive, sizeof(keepAlive));
+
+            sent = PciAgent::scanInventory(enumerator, options.scanMode, options.withHeaders);
+            ++rescans;
+            std::string payload;
+            if (deltas && !hostId.empty())
+                PciWire::appendHostFrame(payload, hostId);
+            payload += PciAgent::createFullInventory(sent, options.withHeaders);
+            if (!sendPayload(sock, ingest, payload, message)) {
+                closesocket(sock);
+                sock = INVALID_SOCKET;
+                continue;
+            }
+            bytesSent += ingest ? message.size() : payload.size();
+            lastSend = Clock::now();
+            std::cout << "Agent: connected (" << (ingest ? "shared port, " : "") << "protocol " << version
+                      << "), sent " << sent.size() << " functions\n";
+        }
+
+        sleepMilliseconds(options.intervalSeconds * 1000);
+        ++cycle;
+
+        // Сначала перечитываются известные функции; полный обход — по
+        // расписанию или если проверка что-то нашла
+        const Clock::time_point start = Clock::now();
+        ++checks;
+        config.refresh();
+        PciAgent::Inventory current;
+        bool changed = false;
+        if (cycle % options.rescanEvery == 0 || !PciAgent::verifyInventory(config, sent, options.withHeaders)) {
+            ++rescans;
+            current = PciAgent::scanInventory(enumerator, options.scanMode, options.withHeaders);
+            changed = !PciAgent::sameInventory(sent, current, options.withHeaders);
+        }
+        checkMilliseconds += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        if (connectionClosed(sock)) {
+            std::cerr << "Agent: server closed the connection, reconnecting\n";
+            closesocket(sock);
+            sock = INVALID_SOCKET;
+            continue;
+        }
+
+        std::string payload;
+        if (changed) {
+            // Старому серверу уходит весь список, но в журнал — те же изменения
+            size_t changedCount = 0, removedCount = 0;
+            if (deltas) {
+                payload = PciAgent::createDelta(sent, current, options.withHeaders, changedCount, removedCount);
+            } else {
+                PciAgent::countChanges(sent, current, options.withHeaders, changedCount, removedCount);
+                payload = PciAgent::createFullInventory(current, options.withHeaders);
+            }
+            std::cout << "Agent: " << changedCount << " changed, " << removedCount << " removed\n";
+            ++updates;
+        } else if (deltas && Clock::now() - lastSend >= std::chrono::seconds(options.heartbeatSeconds)) {
+            PciWire::appendHeartbeatFrame(payload);
+            ++heartbeats;
         }
-        
-        if (bus % 16 == 0) {
-            std::cout << "Scanned bus " << bus << " of 256...\n";
+        if (payload.empty())
+            continue;
+
+        if (!sendPayload(sock, ingest, payload, message)) {
+            closesocket(sock);
+            sock = INVALID_SOCKET;
+            continue;
         }
+        bytesSent += ingest ? message.size() : payload.size();
+        lastSend = Clock::now();
+        if (changed)
+            sent.swap(current);
     }
 
-	std::cout << "\n!!!!!!!!!!!\n" << counter << std::endl << jj << std::endl << kk << std::endl;
+    if (sock != INVALID_SOCKET)
+        closesocket(sock);
+#ifdef _WIN32
+    WSACleanup();
+#endif
 
-    std::cout << "Found " << pciDevices.size() << " PCI devices\n";
+    char line[200];
+    snprintf(line, sizeof(line), "Agent: %u checks, %u full scans, %u updates, %u heartbeats, %llu bytes sent, "
+             "%.3f ms per check\n", checks, rescans, updates, heartbeats, bytesSent,
+             checks ? checkMilliseconds / checks : 0.0);
+    std::cout << line;
+    return 0;
+}
+
+// Сохраняет найденные функции в формате бэкенда fake: так снимок
+// реальной машины становится тестовым набором
+bool dumpConfigSpace(PciConfigAccess& config, const std::vector<PciEntry>& data, const std::string& dir)
+{
+    for (size_t i = 0; i < data.size(); ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "/%02x_%02x_%x", data[i].busNum, data[i].devNum, data[i].funcNum);
+        FILE* file = fopen((dir + name).c_str(), "wb");
+        if (!file) {
+            std::cerr << "Cannot write " << dir << name << "\n";
+            return false;
+        }
 
-    shutdownLib();
-    FreeLibrary(hDll);
+        // Сколько отдаст бэкенд: 64 байта без прав root в sysfs, 256 через порты
+        std::vector<BYTE> space(PciConfigAccess::EXTENDED_CONFIG_SPACE_SIZE);
+        const size_t size = config.read(data[i].busNum, data[i].devNum, data[i].funcNum, &space[0], space.size());
+        fwrite(&space[0], 1, size, file);
+        fclose(file);
+    }
+    std::cout << "Dumped " << data.size() << " functions to " << dir << "\n";
+    return true;
+}
 
-    if (sendToServer("10.217.9.232", 12345, pciDevices)) {
-        std::cout << "Data sent successfully!\n";
-    } else {
-        std::cout << "Failed to send data\n";
+// Тот же снимок в виде образа ECAM для бэкенда ecam: шины до последней
+// найденной, отсутствующие функции заполнены 0xFF
+bool dumpEcamImage(PciConfigAccess& config, const std::vector<PciEntry>& data, const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Cannot write " << path << "\n";
+        return false;
     }
 
-    system("pause");
-    return 0;
+    const size_t busSize = size_t(1) << 20;
+    int lastBus = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+        lastBus = std::max(lastBus, (int)data[i].busNum);
+
+    std::vector<BYTE> space(busSize, 0xFF);
+    bool ok = true;
+    for (int bus = 0; bus <= lastBus && ok; ++bus)
+        ok = fwrite(&space[0], 1, busSize, file) == busSize;
+
+    space.resize(PciConfigAccess::EXTENDED_CONFIG_SPACE_SIZE);
+    for (size_t i = 0; i < data.size() && ok; ++i) {
+        std::fill(space.begin(), space.end(), 0);
+        config.read(data[i].busNum, data[i].devNum, data[i].funcNum, &space[0], space.size());
+        const long offset = (long(data[i].busNum) << 20) | (long(data[i].devNum) << 15) | (long(data[i].funcNum) << 12);
+        ok = fseek(file, offset, SEEK_SET) == 0 && fwrite(&space[0], 1, space.size(), file) == space.size();
+    }
+    fclose(file);
+
+    if (!ok) {
+        std::cerr << "Cannot write " << path << "\n";
+        return false;
+    }
+    std::cout << "Dumped " << data.size() << " functions to ECAM image " << path << "\n";
+    return true;
+}
+
+// Разобранный снимок: класс, BAR и capability в одну строку
+void printConfigSpace(const BYTE* config, size_t size)
+{
+    PciConfig::Info info;
+    if (!PciConfig::decode(config, size, info))
+        return;
+
+    char line[96];
+    snprintf(line, sizeof(line), "    class %02x%02x%02x rev %02x header %u%s",
+             info.classCode, info.subclass, info.progIf, info.revision, info.headerType,
+             info.multifunction ? " multifunction" : "");
+    std::cout << line;
+    if (info.headerType != PciConfig::HEADER_TYPE_NORMAL) {
+        snprintf(line, sizeof(line), " buses %02x-%02x", info.secondaryBus, info.subordinateBus);
+        std::cout << line;
+    }
+    std::cout << "\n";
+
+    for (size_t i = 0; i < info.bars.size(); ++i) {
+        const PciConfig::Bar& bar = info.bars[i];
+        snprintf(line, sizeof(line), "    BAR%u %s %llx%s\n", bar.index,
+                 bar.io ? "I/O" : (bar.is64 ? "mem64" : "mem32"), bar.address,
+                 bar.prefetchable ? " prefetchable" : "");
+        std::cout << line;
+    }
+
+    if (!info.capabilities.empty()) {
+        std::cout << "    caps";
+        for (size_t i = 0; i < info.capabilities.size(); ++i) {
+            const PciConfig::Capability& capability = info.capabilities[i];
+            const char* name = PciConfig::capabilityName(capability);
+            if (name)
+                snprintf(line, sizeof(line), " %s@%x", name, capability.offset);
+            else
+                snprintf(line, sizeof(line), " %s%02x@%x", capability.extended ? "ext" : "", capability.id, capability.offset);
+            std::cout << line;
+        }
+        std::cout << "\n";
+    }
+}
+
+void printStats(PciEnumerator::Mode mode, const PciEnumerator::Stats& stats)
+{
+    char line[160];
+    snprintf(line, sizeof(line), "%-12s %6u functions %8u probes %4u buses %10.3f ms\n",
+             PciEnumerator::modeName(mode), stats.functions, stats.probes, stats.buses, stats.milliseconds);
+    std::cout << line;
+}
+
+// Оба обхода на одном бэкенде; false — обход по топологии нашёл не все
+// функции (например, есть корневая шина, не видная с шины 0)
+bool compareScanModes(PciConfigAccess& config, size_t captureSize)
+{
+    PciEnumerator enumerator(config);
+    enumerator.setCaptureSize(captureSize);
+    std::vector<int> found[2];
+    const PciEnumerator::Mode modes[2] = { PciEnumerator::BruteForce, PciEnumerator::Topology };
+    PciEnumerator::Stats stats[2];
+    for (int i = 0; i < 2; ++i) {
+        // Каждый обход с холодного бэкенда: без открытых файлов и кеша
+        std::string error;
+        config.close();
+        if (!config.open(error)) {
+            std::cerr << "ERROR: " << error << "\n";
+            return false;
+        }
+
+        std::vector<int>& keys = found[i];
+        stats[i] = enumerator.scan(modes[i], [&keys](const PciEnumerator::Function& function) {
+            keys.push_back((function.bus << 8) | (function.device << 3) | function.function);
+        });
+        std::sort(keys.begin(), keys.end());
+        printStats(modes[i], stats[i]);
+    }
+
+    if (stats[1].probes > 0 && stats[1].milliseconds > 0) {
+        char line[96];
+        snprintf(line, sizeof(line), "topology: %.1fx fewer probes, %.1fx faster\n",
+                 double(stats[0].probes) / stats[1].probes, stats[0].milliseconds / stats[1].milliseconds);
+        std::cout << line;
+    }
+    if (found[0] != found[1]) {
+        std::cout << "WARNING: scan modes found different functions, use --scan brute on this machine\n";
+        return false;
+    }
+    return true;
+}
+
+void printUsage()
+{
+    std::cout << "Usage: pciscanner [options]\n"
+                 "  --server <ip>       server address (default 10.217.9.232)\n"
+                 "  --port <n>          PCI server port (default 12345)\n"
+                 "  --ingest-port <n>   shared ingest port, tried first for the binary protocol;\n"
+                 "                      0 uses only --port (default 12340)\n"
+                 "  --backend <name>    winio, sysfs, fake or ecam (default " << PciConfigAccess::defaultBackend() << ")\n"
+                 "  --root <path>       directory for sysfs and fake, image file for ecam\n"
+                 "  --dump <dir>        save found functions in the fake backend format\n"
+                 "  --scan <mode>       topology (default) or brute\n"
+                 "  --compare-scan      run both scan modes, print probes and time, exit\n"
+                 "  --capture <size>    read 256 or 4096 bytes per function in one call and decode\n"
+                 "                      class, BARs and capabilities\n"
+                 "  --dump-ecam <file>  save found functions as an image for the ecam backend\n"
+                 "  --no-send           scan only\n"
+                 "  --json              legacy JSON protocol only\n"
+                 "  --headers           send 64-byte config headers\n"
+                 "  --batch             do not wait for a key press at exit\n"
+                 "  --verbose           print every found function\n"
+                 "  --agent             stay resident: keep one connection, recheck periodically,\n"
+                 "                      send only changes\n"
+                 "  --interval <s>      agent: seconds between checks (default 60)\n"
+                 "  --rescan-every <n>  agent: full scan every n checks (default 10)\n"
+                 "  --heartbeat <s>     agent: keep-alive frame when idle this long (default 300)\n"
+                 "  --cycles <n>        agent: stop after n checks (default 0, run forever)\n"
+                 "  --host-id <name>    agent: name the server keeps this host under (default hostname)\n";
+}
+
+int main(int argc, char* argv[])
+{
+    const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    // --json: только старый протокол; --headers: передать 64-байтные заголовки
+    bool useBinary = true;
+    bool withHeaders = false;
+    bool send = true;
+    bool interactive = true;
+    bool verbose = false;
+    std::string server = "10.217.9.232";
+    int port = 12345;
+    int ingestPort = Ingest::DEFAULT_PORT;
+    std::string backend = PciConfigAccess::defaultBackend();
+    std::string root;
+    std::string dumpDir;
+    PciEnumerator::Mode scanMode = PciEnumerator::Topology;
+    bool compareScan = false;
+    size_t captureSize = 0;
+    std::string ecamImage;
+    bool agent = false;
+    AgentOptions agentOptions;
+    agentOptions.intervalSeconds = 60;
+    agentOptions.rescanEvery = 10;
+    agentOptions.heartbeatSeconds = 300;
+    agentOptions.cycles = 0;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--json") == 0)
+            useBinary = false;
+        else if (strcmp(argv[i], "--headers") == 0)
+            withHeaders = true;
+        else if (strcmp(argv[i], "--no-send") == 0)
+            send = false;
+        else if (strcmp(argv[i], "--batch") == 0)
+            interactive = false;
+        else if (strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else if (strcmp(argv[i], "--server") == 0 && hasValue)
+            server = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0 && hasValue)
+            port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ingest-port") == 0 && hasValue)
+            ingestPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--backend") == 0 && hasValue)
+            backend = argv[++i];
+        else if (strcmp(argv[i], "--root") == 0 && hasValue)
+            root = argv[++i];
+        else if (strcmp(argv[i], "--dump") == 0 && hasValue)
+            dumpDir = argv[++i];
+        else if (strcmp(argv[i], "--scan") == 0 && hasValue && strcmp(argv[i + 1], "topology") == 0)
+            scanMode = PciEnumerator::Topology, ++i;
+        else if (strcmp(argv[i], "--scan") == 0 && hasValue && strcmp(argv[i + 1], "brute") == 0)
+            scanMode = PciEnumerator::BruteForce, ++i;
+        else if (strcmp(argv[i], "--compare-scan") == 0)
+            compareScan = true;
+        else if (strcmp(argv[i], "--capture") == 0 && hasValue && strcmp(argv[i + 1], "256") == 0)
+            captureSize = PciConfigAccess::CONFIG_SPACE_SIZE, ++i;
+        else if (strcmp(argv[i], "--capture") == 0 && hasValue && strcmp(argv[i + 1], "4096") == 0)
+            captureSize = PciConfigAccess::EXTENDED_CONFIG_SPACE_SIZE, ++i;
+        else if (strcmp(argv[i], "--dump-ecam") == 0 && hasValue)
+            ecamImage = argv[++i];
+        else if (strcmp(argv[i], "--agent") == 0)
+            agent = true;
+        else if (strcmp(argv[i], "--interval") == 0 && hasValue)
+            agentOptions.intervalSeconds = std::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--rescan-every") == 0 && hasValue)
+            agentOptions.rescanEvery = std::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--heartbeat") == 0 && hasValue)
+            agentOptions.heartbeatSeconds = std::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--cycles") == 0 && hasValue)
+            agentOptions.cycles = std::max(atoi(argv[++i]), 0);
+        else if (strcmp(argv[i], "--host-id") == 0 && hasValue)
+            agentOptions.hostId = argv[++i];
+        else {
+            printUsage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+    if (port <= 0 || port > 65535 || ingestPort < 0 || ingestPort > 65535) {
+        std::cerr << "Invalid port\n";
+        return 2;
+    }
+
+    std::cout << "PCI Scanner starting...\n";
+
+    std::string error;
+    PciConfigAccess* config = PciConfigAccess::create(backend, root, error);
+    if (!config || !config->open(error)) {
+        std::cerr << "ERROR: " << error << "\n";
+        delete config;
+        pauseIfInteractive(interactive);
+        return 1;
+    }
+
+    std::cout << "Config space access: " << config->name() << "\n";
+
+    if (agent) {
+        if (!useBinary) {
+            std::cerr << "Agent mode needs the binary protocol\n";
+            delete config;
+            return 2;
+        }
+        agentOptions.server = server;
+        agentOptions.port = port;
+        agentOptions.ingestPort = ingestPort;
+        agentOptions.withHeaders = withHeaders;
+        agentOptions.scanMode = scanMode;
+        const int result = runAgent(*config, agentOptions);
+        config->close();
+        delete config;
+        return result;
+    }
+
+    if (compareScan) {
+        const bool same = compareScanModes(*config, captureSize);
+        config->close();
+        delete config;
+        pauseIfInteractive(interactive);
+        return same ? 0 : 1;
+    }
+
+    // Заголовки для сервера берутся из того же снимка
+    const bool decodeCapture = captureSize > 0;
+    if (withHeaders && captureSize < PciWire::CONFIG_HEADER_SIZE)
+        captureSize = PciWire::CONFIG_HEADER_SIZE;
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (send && WSAStartup(MAKEWORD(2,2), &wsa) != 0) {
+        std::cerr << "WSAStartup failed\n";
+        send = false;
+    }
+#endif
+
+    // Сервер получает записи по ходу обхода; без соединения обход всё равно
+    // выполняется ради --dump
+    bool ok = true;
+    bool binary = false;
+    bool ingest = false;
+    SOCKET sock = INVALID_SOCKET;
+    if (send) {
+        sock = openInventoryConnection(server.c_str(), port, ingestPort, useBinary, withHeaders, binary, ingest);
+        if (sock == INVALID_SOCKET)
+            ok = false;
+    }
+    InventoryStream stream(sock, binary, ingest, withHeaders);
+    bool streaming = sock != INVALID_SOCKET && stream.begin();
+
+    std::cout << "Scanning PCI devices (" << PciEnumerator::modeName(scanMode) << ")...\n";
+
+    // Построчный вывод — по --verbose или вместе с разбором снимка
+    const bool listFunctions = verbose || decodeCapture;
+    std::vector<PciEntry> pciDevices;
+    BYTE header[PciWire::CONFIG_HEADER_SIZE];
+
+    PciEnumerator enumerator(*config);
+    enumerator.setCaptureSize(captureSize);
+    PciEnumerator::Stats stats = enumerator.scan(scanMode, [&](const PciEnumerator::Function& function) {
+        PciEntry entry;
+        entry.busNum = function.bus;
+        entry.devNum = function.device;
+        entry.funcNum = function.function;
+        entry.venID = function.vendorId;
+        entry.devID = function.deviceId;
+        pciDevices.push_back(entry);
+
+        if (streaming) {
+            if (withHeaders) {
+                const size_t size = std::min(function.configSize, PciWire::CONFIG_HEADER_SIZE);
+                memcpy(header, function.config, size);
+                memset(header + size, 0xFF, sizeof(header) - size);
+            }
+            streaming = stream.add(entry, withHeaders ? header : 0);
+        }
+
+        if (listFunctions) {
+            // Строка собирается так же, как запись JSON, и уходит одной
+            // записью; самая длинная — 66 байт
+            char line[80];
+            char* out = putText(line, "Found device: Bus ");
+            out = std::to_chars(out, out + 3, unsigned(function.bus)).ptr;
+            out = putText(out, ", Dev ");
+            out = std::to_chars(out, out + 3, unsigned(function.device)).ptr;
+            out = putText(out, ", Func ");
+            out = std::to_chars(out, out + 3, unsigned(function.function)).ptr;
+            out = putText(out, ", VenID 0x");
+            out = putHex4(out, function.vendorId);
+            out = putText(out, ", DevID 0x");
+            out = putHex4(out, function.deviceId);
+            *out++ = '\n';
+            std::cout.write(line, out - line);
+            if (decodeCapture)
+                printConfigSpace(function.config, function.configSize);
+        }
+    });
+    if (streaming)
+        streaming = stream.finish();
+    printStats(scanMode, stats);
+
+    std::cout << "Found " << pciDevices.size() << " PCI devices\n";
+
+    if (sock != INVALID_SOCKET) {
+        closesocket(sock);
+        if (streaming) {
+            char line[160];
+            snprintf(line, sizeof(line), "Sent %zu bytes (%s) in %u writes, first record %.3f ms after start\n",
+                     stream.bytesSent(), ingest ? "shared port" : binary ? "binary" : "JSON", stream.writes(),
+                     std::chrono::duration<double, std::milli>(stream.firstRecordSent() - started).count());
+            std::cout << line;
+        }
+        ok = streaming && ok;
+    }
+#ifdef _WIN32
+    if (send)
+        WSACleanup();
+#endif
+    if (send)
+        std::cout << (ok ? "Data sent successfully!\n" : "Failed to send data\n");
+
+    if (!dumpDir.empty())
+        ok = dumpConfigSpace(*config, pciDevices, dumpDir) && ok;
+    if (!ecamImage.empty())
+        ok = dumpEcamImage(*config, pciDevices, ecamImage) && ok;
+
+    config->close();
+    delete config;
+
+    pauseIfInteractive(interactive);
+    return ok ? 0 : 1;
 }
\ No newline at end of file
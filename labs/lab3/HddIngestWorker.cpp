@@ -0,0 +1,200 @@
+#include "HddIngestWorker.h"
+#include "common/Trace.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+HddIngestWorker::HddIngestWorker(quint16 port, IngestService *ingestService, QObject *parent)
+    : QObject(parent)
+    , m_port(port)
+    , m_ingestService(ingestService)
+    , m_tcpServer(new QTcpServer(this))
+    , m_currentClient(nullptr)
+{
+    connect(m_tcpServer, &QTcpServer::newConnection,
+            this, &HddIngestWorker::onNewConnection);
+}
+
+HddIngestWorker::~HddIngestWorker()
+{
+    if (m_ingestService) {
+        m_ingestService->unregisterSink(Ingest::KIND_HDD_JSON, this);
+    }
+}
+
+void HddIngestWorker::start()
+{
+    if (m_ingestService) {
+        m_ingestService->registerSink(Ingest::KIND_HDD_JSON, this);
+    }
+
+    if (m_tcpServer->listen(QHostAddress::Any, m_port)) {
+        emit started(true, QString());
+    } else {
+        emit started(false, m_tcpServer->errorString());
+    }
+}
+
+QString HddIngestWorker::formatBytes(qint64 bytes)
+{
+    const qint64 KB = 1024;
+    const qint64 MB = KB * 1024;
+    const qint64 GB = MB * 1024;
+    const qint64 TB = GB * 1024;
+
+    if (bytes >= TB) {
+        double tb = static_cast<double>(bytes) / TB;
+        return QString::number(tb, 'f', 2) + " TB";
+    } else if (bytes >= GB) {
+        double gb = static_cast<double>(bytes) / GB;
+        return QString::number(gb, 'f', 2) + " GB";
+    } else if (bytes >= MB) {
+        double mb = static_cast<double>(bytes) / MB;
+        return QString::number(mb, 'f', 2) + " MB";
+    } else if (bytes >= KB) {
+        double kb = static_cast<double>(bytes) / KB;
+        return QString::number(kb, 'f', 2) + " KB";
+    } else {
+        return QString::number(bytes) + " B";
+    }
+}
+
+QString HddIngestWorker::manufacturer(const QString& model)
+{
+    QString modelUpper = model.toUpper();
+
+    if (modelUpper.contains("WDC") || modelUpper.contains("WESTERN")) {
+        return "Western Digital";
+    } else if (modelUpper.contains("SEAGATE") || modelUpper.startsWith("ST")) {
+        return "Seagate";
+    } else if (modelUpper.contains("SAMSUNG")) {
+        return "Samsung";
+    } else if (modelUpper.contains("TOSHIBA")) {
+        return "Toshiba";
+    } else if (modelUpper.contains("HITACHI") || modelUpper.contains("HGST")) {
+        return "Hitachi/HGST";
+    } else if (modelUpper.contains("MAXTOR")) {
+        return "Maxtor";
+    } else if (modelUpper.contains("KINGSTON")) {
+        return "Kingston";
+    } else if (modelUpper.contains("SANDISK")) {
+        return "SanDisk";
+    } else if (modelUpper.contains("CRUCIAL")) {
+        return "Crucial";
+    } else if (modelUpper.contains("INTEL")) {
+        return "Intel";
+    } else if (modelUpper.contains("VMWARE")) {
+        return "VMware Virtual";
+    } else if (modelUpper.contains("VBOX")) {
+        return "VirtualBox";
+    }
+
+    return "Unknown";
+}
+
+bool HddIngestWorker::ingest(quintptr connection, const QString &host, quint16 kind, const QByteArray &payload)
+{
+    Q_UNUSED(connection)
+    Q_UNUSED(kind)
+    emit clientChanged(host);
+    emit logMessage(QString("Получено %1 байт данных от %2").arg(payload.size()).arg(host));
+    parseHddData(host, payload);
+    return true;
+}
+
+void HddIngestWorker::onNewConnection()
+{
+    if (m_currentClient) {
+        m_currentClient->disconnectFromHost();
+    }
+
+    m_currentClient = m_tcpServer->nextPendingConnection();
+    const QString clientIP = m_currentClient->peerAddress().toString();
+
+    emit clientChanged(clientIP);
+    emit logMessage("Подключен клиент: " + clientIP);
+
+    connect(m_currentClient, &QTcpSocket::readyRead,
+            this, &HddIngestWorker::onDataReceived);
+    connect(m_currentClient, &QTcpSocket::disconnected,
+            this, &HddIngestWorker::onClientDisconnected);
+
+    m_buffer.clear();
+}
+
+void HddIngestWorker::onClientDisconnected()
+{
+    emit clientChanged(QString());
+    emit logMessage("Клиент отключился");
+
+    if (m_currentClient) {
+        m_currentClient->deleteLater();
+        m_currentClient = nullptr;
+    }
+}
+
+void HddIngestWorker::onDataReceived()
+{
+    if (!m_currentClient) return;
+
+    QByteArray newData = m_currentClient->readAll();
+    m_buffer.append(newData);
+
+    // Проверка на завершение JSON
+    if (m_buffer.contains(']')) {
+        int endIndex = m_buffer.lastIndexOf(']');
+        QByteArray jsonData = m_buffer.left(endIndex + 1);
+
+        emit logMessage(QString("Получено %1 байт данных").arg(jsonData.size()));
+        parseHddData(m_currentClient->peerAddress().toString(), jsonData);
+
+        m_buffer = m_buffer.mid(endIndex + 1);
+    }
+}
+
+void HddIngestWorker::parseHddData(const QString &host, const QByteArray& data)
+{
+    TRACE_SCOPE("hdd", "HddIngestWorker::parseHddData");
+    QJsonDocument doc;
+    {
+        TRACE_SCOPE("hdd", "HddIngestWorker: QJsonDocument::fromJson");
+        doc = QJsonDocument::fromJson(data);
+    }
+    if (!doc.isArray()) {
+        emit errorOccurred("Неверный формат данных");
+        return;
+    }
+
+    QList<HddDrive> drives;
+    QJsonArray array = doc.array();
+    drives.reserve(array.size());
+
+    for (const QJsonValue& value : array) {
+        if (!value.isObject()) continue;
+
+        QJsonObject obj = value.toObject();
+        HddDrive drive;
+
+        drive.index = obj["index"].toInt();
+        drive.model = obj["model"].toString();
+        drive.serial = obj["serial"].toString();
+        drive.firmware = obj["firmware"].toString();
+        drive.interface = obj["interface"].toString();
+
+        drive.totalBytes = obj["totalBytes"].toDouble();
+        drive.freeBytes = obj["freeBytes"].toDouble();
+        drive.usedBytes = obj["usedBytes"].toDouble();
+
+        // Режимы
+        QJsonArray modesArray = obj["modes"].toArray();
+        QStringList modes;
+        for (const QJsonValue& mode : modesArray) {
+            modes.append(mode.toString());
+        }
+        drive.modes = modes.join(", ");
+
+        drives.append(drive);
+    }
+
+    emit drivesReceived(host, drives);
+}
@@ -0,0 +1,65 @@
+#ifndef HDDINGESTWORKER_H
+#define HDDINGESTWORKER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QList>
+#include <QPointer>
+#include "common/IngestService.h"
+
+// Диск в том виде, в каком он пришёл от сканера
+struct HddDrive {
+    int index = 0;
+    QString model;
+    QString serial;
+    QString firmware;
+    QString interface;
+    QString modes;
+    qint64 totalBytes = 0;
+    qint64 freeBytes = 0;
+    qint64 usedBytes = 0;
+};
+Q_DECLARE_METATYPE(HddDrive)
+
+// Приём данных о дисках. Живёт в IoThread: чтение и разбор JSON не
+// занимают поток GUI, в HddManager уходит разобранный список дисков.
+// Кроме своего порта принимает сообщения KIND_HDD_JSON с общего порта
+class HddIngestWorker : public QObject, public IngestSink
+{
+    Q_OBJECT
+
+public:
+    HddIngestWorker(quint16 port, IngestService *ingestService, QObject *parent = nullptr);
+    ~HddIngestWorker() override;
+
+    bool ingest(quintptr connection, const QString &host, quint16 kind, const QByteArray &payload) override;
+
+    static QString formatBytes(qint64 bytes);
+    static QString manufacturer(const QString &model);
+
+public slots:
+    void start();
+
+signals:
+    void started(bool ok, const QString &error);
+    // Пустой адрес — клиент отключился
+    void clientChanged(const QString &clientIP);
+    void drivesReceived(const QString &host, const QList<HddDrive> &drives);
+    void logMessage(const QString &message);
+    void errorOccurred(const QString &error);
+
+private:
+    void onNewConnection();
+    void onClientDisconnected();
+    void onDataReceived();
+    void parseHddData(const QString &host, const QByteArray &data);
+
+    quint16 m_port;
+    QPointer<IngestService> m_ingestService;
+    QTcpServer *m_tcpServer;
+    QTcpSocket *m_currentClient;
+    QByteArray m_buffer;
+};
+
+#endif // HDDINGESTWORKER_H
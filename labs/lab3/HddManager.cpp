@@ -1,51 +1,68 @@
 #include "HddManager.h"
-#include <QDebug>
+#include "common/IngestService.h"
+#include "common/IoThread.h"
+#include <QDateTime>
 
 HddManager::HddManager(QObject *parent)
     : QObject(parent)
-    , m_tcpServer(new QTcpServer(this))
-    , m_currentClient(nullptr)
     , m_serverRunning(false)
+    , m_active(false)
     , m_serverStatus("Не инициализирован")
 {
-    connect(m_tcpServer, &QTcpServer::newConnection,
-            this, &HddManager::onNewConnection);
 }
 
 HddManager::~HddManager()
 {
+    IoThread::dispose(m_worker);
+}
+
+void HddManager::activate()
+{
+    if (m_active) return;
+
+    m_active = true;
+    emit activeChanged();
+
+    startServer();
+}
+
+void HddManager::suspend()
+{
+    if (!m_active) return;
+
     stopServer();
+
+    m_active = false;
+    emit activeChanged();
 }
 
 void HddManager::startServer()
 {
-    if (m_tcpServer->isListening()) {
+    if (m_worker) {
         emit logMessage("Сервер уже запущен");
         return;
     }
 
-    if (m_tcpServer->listen(QHostAddress::Any, 12346)) {
-        m_serverRunning = true;
-        m_serverStatus = "Сервер запущен";
-        emit serverRunningChanged();
-        emit serverStatusChanged();
-        emit logMessage("Сервер запущен на порту 12346");
-        emit logMessage("IP адрес: " + getLocalIP());
-    } else {
-        m_serverStatus = "Ошибка запуска";
-        emit serverStatusChanged();
-        emit errorOccurred("Не удалось запустить сервер: " + m_tcpServer->errorString());
-    }
+    // Приём и разбор идут в потоке I/O; сюда приходит готовый список дисков
+    m_worker = new HddIngestWorker(SERVER_PORT, IngestService::instance());
+    connect(m_worker, &HddIngestWorker::started, this, &HddManager::onWorkerStarted);
+    connect(m_worker, &HddIngestWorker::clientChanged, this, &HddManager::onClientChanged);
+    connect(m_worker, &HddIngestWorker::drivesReceived, this, &HddManager::onDrivesReceived);
+    connect(m_worker, &HddIngestWorker::logMessage, this, &HddManager::logMessage);
+    connect(m_worker, &HddIngestWorker::errorOccurred, this, &HddManager::errorOccurred);
+    IoThread::adopt(m_worker);
+
+    QMetaObject::invokeMethod(m_worker, &HddIngestWorker::start, Qt::QueuedConnection);
 }
 
 void HddManager::stopServer()
 {
-    if (m_currentClient) {
-        m_currentClient->disconnectFromHost();
-        m_currentClient = nullptr;
+    if (m_worker) {
+        m_worker->disconnect(this);
+        IoThread::dispose(m_worker);
+        m_worker = nullptr;
     }
 
-    m_tcpServer->close();
     m_serverRunning = false;
     m_serverStatus = "Сервер остановлен";
     m_clientIP.clear();
@@ -56,192 +73,133 @@ void HddManager::stopServer()
     emit logMessage("Сервер остановлен");
 }
 
-void HddManager::clearDrives()
+void HddManager::onWorkerStarted(bool ok, const QString& error)
 {
-    m_drives.clear();
-    emit drivesChanged();
-    emit driveCountChanged();
-    emit logMessage("Список дисков очищен");
-}
-
-QString HddManager::getLocalIP()
-{
-    const QList<QHostAddress> addresses = QNetworkInterface::allAddresses();
-    for (const QHostAddress &address : addresses) {
-        if (address.protocol() == QAbstractSocket::IPv4Protocol &&
-            !address.isLoopback() &&
-            address != QHostAddress::LocalHost) {
-            return address.toString();
-        }
-    }
-    return "127.0.0.1";
-}
-
-QString HddManager::formatBytes(qint64 bytes)
-{
-    const qint64 KB = 1024;
-    const qint64 MB = KB * 1024;
-    const qint64 GB = MB * 1024;
-    const qint64 TB = GB * 1024;
-
-    if (bytes >= TB) {
-        double tb = static_cast<double>(bytes) / TB;
-        return QString::number(tb, 'f', 2) + " TB";
-    } else if (bytes >= GB) {
-        double gb = static_cast<double>(bytes) / GB;
-        return QString::number(gb, 'f', 2) + " GB";
-    } else if (bytes >= MB) {
-        double mb = static_cast<double>(bytes) / MB;
-        return QString::number(mb, 'f', 2) + " MB";
-    } else if (bytes >= KB) {
-        double kb = static_cast<double>(bytes) / KB;
-        return QString::number(kb, 'f', 2) + " KB";
+    if (ok) {
+        m_serverRunning = true;
+        m_serverStatus = "Сервер запущен";
+        emit serverRunningChanged();
+        emit serverStatusChanged();
+        emit logMessage(QString("Сервер запущен на порту %1").arg(SERVER_PORT));
+        emit logMessage(QString("Общий порт приёма: %1").arg(IngestService::instance()->port()));
+        emit logMessage("IP адрес: " + getLocalIP());
     } else {
-        return QString::number(bytes) + " B";
-    }
-}
+        m_worker->disconnect(this);
+        IoThread::dispose(m_worker);
+        m_worker = nullptr;
 
-QString HddManager::getManufacturer(const QString& model)
-{
-    QString modelUpper = model.toUpper();
-
-    if (modelUpper.contains("WDC") || modelUpper.contains("WESTERN")) {
-        return "Western Digital";
-    } else if (modelUpper.contains("SEAGATE") || modelUpper.startsWith("ST")) {
-        return "Seagate";
-    } else if (modelUpper.contains("SAMSUNG")) {
-        return "Samsung";
-    } else if (modelUpper.contains("TOSHIBA")) {
-        return "Toshiba";
-    } else if (modelUpper.contains("HITACHI") || modelUpper.contains("HGST")) {
-        return "Hitachi/HGST";
-    } else if (modelUpper.contains("MAXTOR")) {
-        return "Maxtor";
-    } else if (modelUpper.contains("KINGSTON")) {
-        return "Kingston";
-    } else if (modelUpper.contains("SANDISK")) {
-        return "SanDisk";
-    } else if (modelUpper.contains("CRUCIAL")) {
-        return "Crucial";
-    } else if (modelUpper.contains("INTEL")) {
-        return "Intel";
-    } else if (modelUpper.contains("VMWARE")) {
-        return "VMware Virtual";
-    } else if (modelUpper.contains("VBOX")) {
-        return "VirtualBox";
+        m_serverStatus = "Ошибка запуска";
+        emit serverStatusChanged();
+        emit errorOccurred("Не удалось запустить сервер: " + error);
     }
-
-    return "Unknown";
 }
 
-void HddManager::onNewConnection()
+void HddManager::onClientChanged(const QString& clientIP)
 {
-    if (m_currentClient) {
-        m_currentClient->disconnectFromHost();
-    }
-
-    m_currentClient = m_tcpServer->nextPendingConnection();
-    m_clientIP = m_currentClient->peerAddress().toString();
-
+    m_clientIP = clientIP;
     emit clientIPChanged();
-    emit logMessage("Подключен клиент: " + m_clientIP);
-
-    connect(m_currentClient, &QTcpSocket::readyRead,
-            this, &HddManager::onDataReceived);
-    connect(m_currentClient, &QTcpSocket::disconnected,
-            this, &HddManager::onClientDisconnected);
-
-    m_buffer.clear();
 }
 
-void HddManager::onClientDisconnected()
+void HddManager::onDrivesReceived(const QString& host, const QList<HddDrive>& drives)
 {
-    m_clientIP.clear();
-    emit clientIPChanged();
-    emit logMessage("Клиент отключился");
-
-    if (m_currentClient) {
-        m_currentClient->deleteLater();
-        m_currentClient = nullptr;
+    InventoryStore::Host &entry = m_store.host(host);
+    StringPool &strings = m_store.strings();
+
+    entry.drives.resize(0);
+    entry.drives.reserve(drives.size());
+    for (const HddDrive &drive : drives) {
+        DriveRecord record;
+        record.totalBytes = drive.totalBytes;
+        record.freeBytes = drive.freeBytes;
+        record.usedBytes = drive.usedBytes;
+        record.index = quint32(drive.index);
+        record.model = strings.intern(drive.model);
+        record.serial = strings.intern(drive.serial);
+        record.firmware = strings.intern(drive.firmware);
+        record.interface = strings.intern(drive.interface);
+        record.manufacturer = strings.intern(HddIngestWorker::manufacturer(drive.model));
+        record.modes = strings.intern(drive.modes);
+        entry.drives.append(record);
     }
+    entry.drives.squeeze();
+    entry.lastSeen = QDateTime::currentMSecsSinceEpoch();
+    m_currentHost = host;
+
+    emit drivesChanged();
+    emit driveCountChanged();
+    emit logMessage(QString("Получена информация о %1 дисках").arg(drives.size()));
 }
 
-void HddManager::onDataReceived()
+int HddManager::driveCount() const
 {
-    if (!m_currentClient) return;
-
-    QByteArray newData = m_currentClient->readAll();
-    m_buffer.append(newData);
-
-    // Проверка на завершение JSON
-    if (m_buffer.contains(']')) {
-        int endIndex = m_buffer.lastIndexOf(']');
-        QByteArray jsonData = m_buffer.left(endIndex + 1);
-
-        emit logMessage(QString("Получено %1 байт данных").arg(jsonData.size()));
-        parseHddData(jsonData);
-
-        m_buffer = m_buffer.mid(endIndex + 1);
-    }
+    const InventoryStore::Host *entry = m_store.find(m_currentHost);
+    return entry ? int(entry->drives.size()) : 0;
 }
 
-void HddManager::parseHddData(const QByteArray& data)
+QVariantList HddManager::drives() const
 {
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isArray()) {
-        emit errorOccurred("Неверный формат данных");
-        return;
-    }
-
-    m_drives.clear();
-    QJsonArray array = doc.array();
-
-    for (const QJsonValue& value : array) {
-        if (!value.isObject()) continue;
+    QVariantList result;
+    const InventoryStore::Host *entry = m_store.find(m_currentHost);
+    if (!entry) return result;
 
-        QJsonObject obj = value.toObject();
+    const StringPool &strings = m_store.strings();
+    result.reserve(entry->drives.size());
+    for (const DriveRecord &record : entry->drives) {
         QVariantMap drive;
+        drive["index"] = int(record.index);
+        drive["model"] = strings.string(record.model);
+        drive["serial"] = strings.string(record.serial);
+        drive["firmware"] = strings.string(record.firmware);
+        drive["interface"] = strings.string(record.interface);
 
-        drive["index"] = obj["index"].toInt();
-        drive["model"] = obj["model"].toString();
-        drive["serial"] = obj["serial"].toString();
-        drive["firmware"] = obj["firmware"].toString();
-        drive["interface"] = obj["interface"].toString();
-
-        qint64 totalBytes = obj["totalBytes"].toDouble();
-        qint64 freeBytes = obj["freeBytes"].toDouble();
-        qint64 usedBytes = obj["usedBytes"].toDouble();
-
-        drive["totalBytes"] = totalBytes;
-        drive["freeBytes"] = freeBytes;
-        drive["usedBytes"] = usedBytes;
+        drive["totalBytes"] = record.totalBytes;
+        drive["freeBytes"] = record.freeBytes;
+        drive["usedBytes"] = record.usedBytes;
 
-        drive["totalFormatted"] = formatBytes(totalBytes);
-        drive["freeFormatted"] = formatBytes(freeBytes);
-        drive["usedFormatted"] = formatBytes(usedBytes);
+        drive["totalFormatted"] = HddIngestWorker::formatBytes(record.totalBytes);
+        drive["freeFormatted"] = HddIngestWorker::formatBytes(record.freeBytes);
+        drive["usedFormatted"] = HddIngestWorker::formatBytes(record.usedBytes);
 
         // Процент использования
-        if (totalBytes > 0) {
-            double usedPercent = (static_cast<double>(usedBytes) / totalBytes) * 100;
+        if (record.totalBytes > 0) {
+            double usedPercent = (static_cast<double>(record.usedBytes) / record.totalBytes) * 100;
             drive["usedPercent"] = QString::number(usedPercent, 'f', 1);
         } else {
             drive["usedPercent"] = "0.0";
         }
 
-        drive["manufacturer"] = getManufacturer(obj["model"].toString());
-
-        // Режимы
-        QJsonArray modesArray = obj["modes"].toArray();
-        QStringList modes;
-        for (const QJsonValue& mode : modesArray) {
-            modes.append(mode.toString());
-        }
-        drive["modes"] = modes.join(", ");
-
-        m_drives.append(drive);
+        drive["manufacturer"] = strings.string(record.manufacturer);
+        drive["modes"] = strings.string(record.modes);
+        result.append(drive);
     }
+    return result;
+}
 
+QVariantMap HddManager::memoryReport(const QString &host) const
+{
+    return m_store.memoryReport(host).toVariantMap();
+}
+
+void HddManager::clearDrives()
+{
+    m_store.clear();
+    m_currentHost.clear();
     emit drivesChanged();
     emit driveCountChanged();
-    emit logMessage(QString("Получена информация о %1 дисках").arg(m_drives.size()));
+    emit logMessage("Список дисков очищен");
+}
+
+QString HddManager::getLocalIP()
+{
+    return IngestService::localAddress();
+}
+
+QString HddManager::formatBytes(qint64 bytes)
+{
+    return HddIngestWorker::formatBytes(bytes);
+}
+
+QString HddManager::getManufacturer(const QString& model)
+{
+    return HddIngestWorker::manufacturer(model);
 }
@@ -2,15 +2,10 @@
 #define HDDMANAGER_H
 
 #include <QObject>
-#include <QTcpServer>
-#include <QTcpSocket>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QVariantList>
-#include <QVariantMap>
-#include <QHostAddress>
-#include <QNetworkInterface>
+#include <QPointer>
+#include "HddIngestWorker.h"
+#include "common/InventoryStore.h"
 
 class HddManager : public QObject
 {
@@ -20,6 +15,7 @@ class HddManager : public QObject
     Q_PROPERTY(QString clientIP READ clientIP NOTIFY clientIPChanged)
     Q_PROPERTY(int driveCount READ driveCount NOTIFY driveCountChanged)
     Q_PROPERTY(QVariantList drives READ drives NOTIFY drivesChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
 
 public:
     explicit HddManager(QObject *parent = nullptr);
@@ -28,8 +24,14 @@ public:
     bool serverRunning() const { return m_serverRunning; }
     QString serverStatus() const { return m_serverStatus; }
     QString clientIP() const { return m_clientIP; }
-    int driveCount() const { return m_drives.size(); }
-    QVariantList drives() const { return m_drives; }
+    int driveCount() const;
+    // Список строится из хранилища при каждом обращении
+    QVariantList drives() const;
+    bool isActive() const { return m_active; }
+
+    // Сервер слушает порт только пока страница лабораторной в StackView
+    Q_INVOKABLE void activate();
+    Q_INVOKABLE void suspend();
 
     Q_INVOKABLE void startServer();
     Q_INVOKABLE void stopServer();
@@ -37,6 +39,8 @@ public:
     Q_INVOKABLE QString getLocalIP();
     Q_INVOKABLE QString formatBytes(qint64 bytes);
     Q_INVOKABLE QString getManufacturer(const QString& model);
+    // Память, занятая дисками; пустой адрес — все хосты
+    Q_INVOKABLE QVariantMap memoryReport(const QString &host = QString()) const;
 
 signals:
     void serverRunningChanged();
@@ -44,24 +48,26 @@ signals:
     void clientIPChanged();
     void driveCountChanged();
     void drivesChanged();
+    void activeChanged();
     void logMessage(const QString& message);
     void errorOccurred(const QString& error);
 
-private slots:
-    void onNewConnection();
-    void onClientDisconnected();
-    void onDataReceived();
-
 private:
-    void parseHddData(const QByteArray& data);
+    void onWorkerStarted(bool ok, const QString& error);
+    void onClientChanged(const QString& clientIP);
+    void onDrivesReceived(const QString& host, const QList<HddDrive>& drives);
 
-    QTcpServer* m_tcpServer;
-    QTcpSocket* m_currentClient;
+    // Живёт в IoThread, удаляется через IoThread::dispose
+    QPointer<HddIngestWorker> m_worker;
     bool m_serverRunning;
+    bool m_active;
     QString m_serverStatus;
     QString m_clientIP;
-    QVariantList m_drives;
-    QByteArray m_buffer;
+    InventoryStore m_store;
+    // Хост, чьи диски показываются
+    QString m_currentHost;
+
+    static constexpr int SERVER_PORT = 12346;
 };
 
 #endif // HDDMANAGER_H
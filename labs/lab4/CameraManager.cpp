@@ -1,4 +1,5 @@
 #include "CameraManager.h"
+#include "common/Trace.h"
 #include <QCameraDevice>
 #include <QMediaDevices>
 #include <QStandardPaths>
@@ -25,6 +26,7 @@ CameraManager::CameraManager(QObject *parent)
     , m_recording(false)
     , m_stealthMode(false)
     , m_stealthRecording(false)
+    , m_active(false)
     , m_photoCount(0)
     , m_videoCount(0)
 {
@@ -32,9 +34,6 @@ CameraManager::CameraManager(QObject *parent)
     s_instance = this;
 #endif
 
-    createOutputDirectories();
-    initializeCamera();
-
     m_recordingTimer = new QTimer(this);
     m_recordingTimer->setInterval(1000);
     connect(m_recordingTimer, &QTimer::timeout, this, &CameraManager::updateRecordingTime);
@@ -42,25 +41,44 @@ CameraManager::CameraManager(QObject *parent)
     m_activityCheckTimer = new QTimer(this);
     m_activityCheckTimer->setInterval(500);
     connect(m_activityCheckTimer, &QTimer::timeout, this, &CameraManager::checkForCameraActivity);
-    m_activityCheckTimer->start();
+}
+
+CameraManager::~CameraManager()
+{
+    uninstallGlobalHotkeys();
+    releaseCamera();
+}
+
+void CameraManager::activate()
+{
+    if (m_active) return;
 
+    createOutputDirectories();
+    initializeCamera();
+    m_activityCheckTimer->start();
     setupHotkeys();
+
+    m_active = true;
+    emit activeChanged();
 }
 
-CameraManager::~CameraManager()
+void CameraManager::suspend()
 {
+    if (!m_active) return;
+
+    stopCamera();
+    m_activityCheckTimer->stop();
     uninstallGlobalHotkeys();
-    if (m_camera) {
-        m_camera->stop();
-        delete m_camera;
-    }
-    delete m_captureSession;
-    delete m_imageCapture;
-    delete m_mediaRecorder;
+    releaseCamera();
+
+    m_active = false;
+    emit activeChanged();
 }
 
 void CameraManager::initializeCamera()
 {
+    if (m_camera) return;
+
     const QList<QCameraDevice> cameras = QMediaDevices::videoInputs();
     if (cameras.isEmpty()) {
         qWarning() << "No cameras found";
@@ -91,6 +109,9 @@ void CameraManager::initializeCamera()
     m_captureSession->setCamera(m_camera);
     m_captureSession->setImageCapture(m_imageCapture);
     m_captureSession->setRecorder(m_mediaRecorder);
+    if (m_videoSink) {
+        m_captureSession->setVideoOutput(m_videoSink);
+    }
 
     m_imageCapture->setQuality(QImageCapture::VeryHighQuality);
     m_imageCapture->setFileFormat(QImageCapture::JPEG);
@@ -118,6 +139,26 @@ void CameraManager::initializeCamera()
     emit cameraDescriptionChanged();
 }
 
+void CameraManager::releaseCamera()
+{
+    if (m_camera) {
+        m_camera->stop();
+        delete m_camera;
+        m_camera = nullptr;
+    }
+    delete m_captureSession;
+    m_captureSession = nullptr;
+    delete m_imageCapture;
+    m_imageCapture = nullptr;
+    delete m_mediaRecorder;
+    m_mediaRecorder = nullptr;
+
+    if (m_cameraActive) {
+        m_cameraActive = false;
+        emit cameraActiveChanged();
+    }
+}
+
 void CameraManager::createOutputDirectories()
 {
     QString documentsPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
@@ -153,6 +194,7 @@ void CameraManager::startCamera()
 {
     if (!m_camera || m_cameraActive) return;
 
+    TRACE_SCOPE("camera", "CameraManager::startCamera");
     m_camera->start();
     m_cameraActive = true;
     emit cameraActiveChanged();
@@ -163,6 +205,7 @@ void CameraManager::stopCamera()
 {
     if (!m_camera || !m_cameraActive) return;
 
+    TRACE_SCOPE("camera", "CameraManager::stopCamera");
     if (m_recording) {
         stopRecording();
     }
@@ -176,6 +219,7 @@ void CameraManager::takePhoto()
 {
     if (!m_camera || !m_cameraActive || !m_imageCapture) return;
 
+    TRACE_SCOPE("camera", "CameraManager::takePhoto");
     QString path = generatePhotoPath();
     m_imageCapture->captureToFile(path);
     m_lastPhotoPath = path;
@@ -213,6 +257,7 @@ void CameraManager::startRecording()
 {
     if (!m_camera || !m_cameraActive || !m_mediaRecorder || m_recording) return;
 
+    TRACE_SCOPE("camera", "CameraManager::startRecording");
     QString path = generateVideoPath();
     m_mediaRecorder->setOutputLocation(QUrl::fromLocalFile(path));
     m_mediaRecorder->record();
@@ -229,6 +274,7 @@ void CameraManager::stopRecording()
 {
     if (!m_mediaRecorder || !m_recording) return;
 
+    TRACE_SCOPE("camera", "CameraManager::stopRecording");
     m_mediaRecorder->stop();
     m_recording = false;
     m_stealthRecording = false;
@@ -348,6 +394,7 @@ void CameraManager::onImageCaptured(int id, const QImage& image)
 {
     Q_UNUSED(id)
     Q_UNUSED(image)
+    TRACE_INSTANT("camera.imageCaptured");
     m_photoCount++;
     emit photoCountChanged();
 }
@@ -355,11 +402,13 @@ void CameraManager::onImageCaptured(int id, const QImage& image)
 void CameraManager::onImageSaved(int id, const QString& fileName)
 {
     Q_UNUSED(id)
+    TRACE_INSTANT("camera.imageSaved");
     emit photoTaken(fileName);
 }
 
 void CameraManager::onRecorderStateChanged(QMediaRecorder::RecorderState state)
 {
+    TRACE_COUNTER("camera.recorderState", state);
     if (state == QMediaRecorder::StoppedState && !m_lastVideoPath.isEmpty()) {
         m_videoCount++;
         emit videoCountChanged();
@@ -34,6 +34,7 @@ class CameraManager : public QObject
     Q_PROPERTY(int videoCount READ videoCount NOTIFY videoCountChanged)
     Q_PROPERTY(QString recordingTime READ recordingTime NOTIFY recordingTimeChanged)
     Q_PROPERTY(QObject* videoSink READ videoSink WRITE setVideoSink NOTIFY videoSinkChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
 
 public:
     explicit CameraManager(QObject *parent = nullptr);
@@ -52,6 +53,12 @@ public:
     QString recordingTime() const;
     QObject* videoSink() const { return m_videoSink; }
     void setVideoSink(QObject* sink);
+    bool isActive() const { return m_active; }
+
+    // Камера, таймер активности и хуки клавиатуры захватываются только
+    // пока страница лабораторной в StackView
+    Q_INVOKABLE void activate();
+    Q_INVOKABLE void suspend();
 
     Q_INVOKABLE void startCamera();
     Q_INVOKABLE void stopCamera();
@@ -83,6 +90,7 @@ signals:
     void videoCountChanged();
     void recordingTimeChanged();
     void videoSinkChanged();
+    void activeChanged();
     void photoTaken(const QString& path);
     void videoSaved(const QString& path);
     void errorOccurred(const QString& error);
@@ -104,6 +112,7 @@ private slots:
 
 private:
     void initializeCamera();
+    void releaseCamera();
     void createOutputDirectories();
     QString generatePhotoPath();
     QString generateVideoPath();
@@ -121,6 +130,7 @@ private:
     bool m_recording;
     bool m_stealthMode;
     bool m_stealthRecording;
+    bool m_active;
 
     QString m_cameraName;
     QString m_cameraDescription;
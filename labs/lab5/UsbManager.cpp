@@ -1,4 +1,5 @@
 #include "UsbManager.h"
+#include "common/Trace.h"
 #include <QGuiApplication>
 #include <QWindow>
 #include <QDebug>
@@ -10,33 +11,61 @@
 DEFINE_GUID(GUID_DEVCLASS_HID, 0x745a17a0, 0x74d3, 0x11d0, 0xb6, 0xfe, 0x00, 0xa0, 0xc9, 0x0f, 0x57, 0xda);
 #endif
 
-UsbManager::UsbManager(QObject *parent) : QObject(parent), m_notifyHandle(nullptr)
+UsbManager::UsbManager(QObject *parent)
+    : QObject(parent)
+    , m_notifyHandle(nullptr)
+    , m_notifyWindow(nullptr)
+    , m_active(false)
 {
     m_rescanTimer = new QTimer(this);
     m_rescanTimer->setInterval(500);
     m_rescanTimer->setSingleShot(true);
     connect(m_rescanTimer, &QTimer::timeout, this, &UsbManager::rescanDevices);
+}
+
+UsbManager::~UsbManager()
+{
+    suspend();
+}
+
+void UsbManager::activate()
+{
+    if (m_active) return;
 
-    QWindow* window = new QWindow();
-    window->create();
-    m_windowId = window->winId();
+    // Скрытое окно нужно только как получатель WM_DEVICECHANGE
+    m_notifyWindow = new QWindow();
+    m_notifyWindow->create();
     qApp->installNativeEventFilter(this);
     DEV_BROADCAST_DEVICEINTERFACE notificationFilter;
     ZeroMemory(&notificationFilter, sizeof(notificationFilter));
     notificationFilter.dbcc_size = sizeof(DEV_BROADCAST_DEVICEINTERFACE);
     notificationFilter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
-    m_notifyHandle = RegisterDeviceNotification(reinterpret_cast<HWND>(m_windowId), &notificationFilter, DEVICE_NOTIFY_WINDOW_HANDLE | DEVICE_NOTIFY_ALL_INTERFACE_CLASSES);
+    m_notifyHandle = RegisterDeviceNotification(reinterpret_cast<HWND>(m_notifyWindow->winId()), &notificationFilter, DEVICE_NOTIFY_WINDOW_HANDLE | DEVICE_NOTIFY_ALL_INTERFACE_CLASSES);
     if (!m_notifyHandle) {
         emit logMessage("Error: Could not register for device notifications.");
     }
+
+    m_active = true;
+    emit activeChanged();
+
+    rescanDevices();
 }
 
-UsbManager::~UsbManager()
+void UsbManager::suspend()
 {
+    if (!m_active) return;
+
+    m_rescanTimer->stop();
     if (m_notifyHandle) {
         UnregisterDeviceNotification(m_notifyHandle);
+        m_notifyHandle = nullptr;
     }
     qApp->removeNativeEventFilter(this);
+    delete m_notifyWindow;
+    m_notifyWindow = nullptr;
+
+    m_active = false;
+    emit activeChanged();
 }
 
 void UsbManager::initialScan()
@@ -59,6 +88,7 @@ bool UsbManager::nativeEventFilter(const QByteArray &eventType, void *message, q
 
 void UsbManager::rescanDevices()
 {
+    TRACE_SCOPE("usb", "UsbManager::rescanDevices");
     emit logMessage("Rescanning all USB bus devices...");
     m_devices.clear();
 
@@ -90,7 +120,11 @@ void UsbManager::rescanDevices()
     SetupDiDestroyDeviceInfoList(hDevInfo);
 
     // --- Шаг 2: "Обогащаем" флешки информацией о дисках ---
-    const auto drives = QStorageInfo::mountedVolumes();
+    QList<QStorageInfo> drives;
+    {
+        TRACE_SCOPE("usb", "QStorageInfo::mountedVolumes");
+        drives = QStorageInfo::mountedVolumes();
+    }
     for (const QStorageInfo &drive : drives) {
         QString root = drive.rootPath();
         if (root.isEmpty()) continue;
@@ -117,6 +151,7 @@ void UsbManager::rescanDevices()
             }
         }
     }
+    TRACE_COUNTER("usb.devices", m_devices.size());
     emit devicesChanged();
 }
 
@@ -153,6 +188,7 @@ void UsbManager::addDevice(const QVariantMap &deviceDetails)
 
 void UsbManager::ejectDevice(const QString &deviceId)
 {
+    TRACE_SCOPE("usb", "UsbManager::ejectDevice");
     QString driveLetter = deviceId.left(2);
     if (driveLetter.length() != 2 || !driveLetter.endsWith(':')) {
         emit logMessage("Eject error: Invalid device ID for ejection. Expected a drive path like 'E:/'.");
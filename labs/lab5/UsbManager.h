@@ -5,7 +5,7 @@
 #include <QAbstractNativeEventFilter>
 #include <QVariantList>
 #include <QTimer>
-#include <qwindowdefs.h> // Для WId
+#include <QWindow>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -18,6 +18,7 @@ class UsbManager : public QObject, public QAbstractNativeEventFilter
 {
     Q_OBJECT
     Q_PROPERTY(QVariantList devices READ devices NOTIFY devicesChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
 
 public:
     explicit UsbManager(QObject *parent = nullptr);
@@ -27,10 +28,16 @@ public:
     Q_INVOKABLE void disableDevice(qulonglong devInst);
     Q_INVOKABLE void initialScan();
 
+    // Подписка на WM_DEVICECHANGE держится только пока страница лабораторной в StackView
+    Q_INVOKABLE void activate();
+    Q_INVOKABLE void suspend();
+
     QVariantList devices() const;
+    bool isActive() const { return m_active; }
 
 signals:
     void devicesChanged();
+    void activeChanged();
     void logMessage(const QString &message);
 
 protected:
@@ -44,8 +51,9 @@ private:
 
     QVariantList m_devices;
     HDEVNOTIFY m_notifyHandle;
-    WId m_windowId;
+    QWindow* m_notifyWindow;
     QTimer* m_rescanTimer;
+    bool m_active;
 };
 
 #endif // USBMANAGER_H
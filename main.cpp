@@ -3,139 +3,139 @@
 #include <QQmlContext>
 #include <QCoreApplication>
 #include <QQuickStyle>
+#include <QQuickWindow>
+#include <QElapsedTimer>
 #include <QDebug>
-#include <QFile>
 #include <QDir>
 #include <QUrl>
+#include <atomic>
 #include "labs/lab1/PowerManager.h"
 #include "labs/lab2/PciManager.h"
 #include "labs/lab3/HddManager.h"
 #include "labs/lab4/CameraManager.h"
 #include "labs/lab5/UsbManager.h"
+#include "common/SpriteItem.h"
+#include "common/AnimationClock.h"
+#include "common/PageCache.h"
+#include "common/ImageCache.h"
+#include "common/AssetImageProvider.h"
+#include "common/FrameStats.h"
+#include "common/Trace.h"
+#include "common/StallWatchdog.h"
 
 
-static bool looksLikeProjectRoot(const QDir &dir) {
-    QFileInfo f1(dir.filePath("qml/Main.qml"));
-    QFileInfo f2(dir.filePath("resources/images/MM_left.png"));
-    return f1.exists() || f2.exists();
-}
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startupTimer;
+    startupTimer.start();
 
-static QString findProjectRootFrom(const QString &startPath, int maxLevels = 10) {
-    QDir dir(startPath);
-    for (int i = 0; i < maxLevels && dir.exists(); ++i) {
-        if (looksLikeProjectRoot(dir)) {
-            QFileInfo fi(dir.absolutePath());
-            QString canon = fi.canonicalFilePath();
-            if (!canon.isEmpty()) return canon;
-            return fi.absoluteFilePath();
-        }
-        if (!dir.cdUp()) break;
-    }
-    return QString();
-}
+    QGuiApplication app(argc, argv);
 
-static QString detectProjectRoot() {
-    QStringList starts;
-    starts << QDir::currentPath();
-    starts << QCoreApplication::applicationDirPath();
-    starts << QDir::currentPath() + "/..";
-    starts << QCoreApplication::applicationDirPath() + "/..";
+    QQuickStyle::setStyle("Fusion");
+    QQmlApplicationEngine engine;
 
-    for (const QString &s : starts) {
-        QString root = findProjectRootFrom(QDir(s).absolutePath(), 12);
-        if (!root.isEmpty()) return root;
-    }
-    return QString();
-}
+    qmlRegisterType<SpriteItem>("com.company.Sprites", 1, 0, "SpriteItem");
+    qmlRegisterSingletonInstance<AnimationClock>("com.company.Sprites", 1, 0, "AnimationClock", AnimationClock::instance());
 
-static QString findMainQml(const QString &projectRoot) {
-    if (!projectRoot.isEmpty()) {
-        QDir root(projectRoot);
-        QString candidate = root.filePath("qml/Main.qml");
-        if (QFile::exists(candidate)) return QDir(candidate).canonicalPath();
-        candidate = root.filePath("Main.qml");
-        if (QFile::exists(candidate)) return QDir(candidate).canonicalPath();
+    // LCD_LABS_TRACE=<файл> пишет трассировку с самого старта до выхода
+    const QString tracePath = qEnvironmentVariable("LCD_LABS_TRACE");
+    if (!tracePath.isEmpty()) {
+        Trace::instance()->start();
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath]() {
+            Trace::instance()->stop(tracePath);
+        });
     }
-
-    QStringList candidates;
-    candidates << QDir::current().filePath("qml/Main.qml");
-    candidates << QDir(QCoreApplication::applicationDirPath()).filePath("qml/Main.qml");
-    candidates << QDir(QCoreApplication::applicationDirPath()).filePath("../qml/Main.qml");
-    candidates << QDir::current().filePath("Main.qml");
-
-    for (const QString &p : candidates) {
-        if (QFile::exists(p)) {
-            QFileInfo fi(p);
-            return fi.canonicalFilePath().isEmpty() ? fi.absoluteFilePath() : fi.canonicalFilePath();
+    qmlRegisterSingletonInstance<Trace>("com.company.Trace", 1, 0, "Trace", Trace::instance());
+
+    // LCD_LABS_WATCHDOG=1 или список порогов в мс ("16,50,250") включает
+    // сторожа зависаний GUI; журнал — LCD_LABS_WATCHDOG_LOG или lcd_labs_stalls.log
+    StallWatchdog *watchdog = StallWatchdog::instance();
+    qmlRegisterSingletonInstance<StallWatchdog>("com.company.Stats", 1, 0, "StallWatchdog", watchdog);
+    if (qEnvironmentVariableIsSet("LCD_LABS_WATCHDOG")) {
+        QList<int> budgets;
+        for (const QString &part : qEnvironmentVariable("LCD_LABS_WATCHDOG").split(',', Qt::SkipEmptyParts)) {
+            budgets.append(part.trimmed().toInt());
+        }
+        if (budgets.size() > 1 || (budgets.size() == 1 && budgets.first() > 1)) {
+            watchdog->setBudgets(budgets);
+        }
+        if (qEnvironmentVariableIsSet("LCD_LABS_WATCHDOG_LOG")) {
+            watchdog->setLogPath(qEnvironmentVariable("LCD_LABS_WATCHDOG_LOG"));
         }
+        watchdog->setEnabled(true);
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, watchdog, [watchdog]() {
+            watchdog->setEnabled(false);
+        });
     }
 
-    return QString();
-}
-
-int main(int argc, char *argv[])
-{
-    QGuiApplication app(argc, argv);
-
-    QQuickStyle::setStyle("Fusion");
-    QQmlApplicationEngine engine;
-
-    qmlRegisterSingletonInstance<PowerManager>("com.company.PowerManager", 1, 0, "PowerManager", new PowerManager());
+    FrameStats *frameStats = FrameStats::instance();
+    qmlRegisterSingletonInstance<FrameStats>("com.company.Stats", 1, 0, "FrameStats", frameStats);
+
+    // Менеджеры создаются при первом обращении со страницы и захватывают
+    // устройства, таймеры и сокеты только между activate() и suspend()
+    qmlRegisterSingletonType<PowerManager>("com.company.PowerManager", 1, 0, "PowerManager",
+                                           [](QQmlEngine *engine, QJSEngine *scriptEngine) -> QObject * {
+                                               Q_UNUSED(engine)
+                                               Q_UNUSED(scriptEngine)
+                                               auto manager = new PowerManager();
+                                               FrameStats::instance()->trackSignal(manager, &PowerManager::powerInfoChanged, "PowerManager.powerInfoChanged");
+                                               return manager;
+                                           });
+    qmlRegisterUncreatableType<PciDeviceModel>("com.company.PciManager", 1, 0, "PciDeviceModel",
+                                               "PciDeviceModel доступна только через PciManager.deviceModel");
     qmlRegisterSingletonType<PciManager>("com.company.PciManager", 1, 0, "PciManager",
                                          [](QQmlEngine *engine, QJSEngine *scriptEngine) -> QObject * {
                                              Q_UNUSED(engine)
                                              Q_UNUSED(scriptEngine)
-                                             return new PciManager();
+                                             auto manager = new PciManager();
+                                             FrameStats::instance()->trackSignal(manager, &PciManager::devicesChanged, "PciManager.devicesChanged");
+                                             return manager;
                                          });
     qmlRegisterSingletonType<HddManager>("com.company.HddManager", 1, 0, "HddManager",
                                          [](QQmlEngine *engine, QJSEngine *scriptEngine) -> QObject * {
                                              Q_UNUSED(engine)
                                              Q_UNUSED(scriptEngine)
-                                             return new HddManager();
+                                             auto manager = new HddManager();
+                                             FrameStats::instance()->trackSignal(manager, &HddManager::drivesChanged, "HddManager.drivesChanged");
+                                             return manager;
                                          });
     qmlRegisterSingletonType<CameraManager>("com.company.CameraManager", 1, 0, "CameraManager",
                                             [](QQmlEngine *engine, QJSEngine *scriptEngine) -> QObject * {
                                                 Q_UNUSED(engine)
                                                 Q_UNUSED(scriptEngine)
-                                                return new CameraManager();
+                                                auto manager = new CameraManager();
+                                                FrameStats::instance()->trackSignal(manager, &CameraManager::cameraDetected, "CameraManager.cameraDetected");
+                                                FrameStats::instance()->trackSignal(manager, &CameraManager::recordingTimeChanged, "CameraManager.recordingTimeChanged");
+                                                return manager;
                                             });
     qmlRegisterSingletonType<UsbManager>("com.company.UsbManager", 1, 0, "UsbManager",
                                          [](QQmlEngine *engine, QJSEngine *scriptEngine) -> QObject * {
                                              Q_UNUSED(engine)
                                              Q_UNUSED(scriptEngine)
-                                             return new UsbManager();
+                                             auto manager = new UsbManager();
+                                             FrameStats::instance()->trackSignal(manager, &UsbManager::devicesChanged, "UsbManager.devicesChanged");
+                                             return manager;
                                          });
 
 
 
-    QString projectRoot = detectProjectRoot();
-    if (!projectRoot.isEmpty()) {
-        qDebug() << "Detected project root (source dir):" << projectRoot;
-    } else {
-        qDebug() << "Could not detect project root; falling back to current/application dirs.";
-        projectRoot = QDir::current().absolutePath();
-    }
+    engine.addImageProvider("assets", new AssetImageProvider());
+    qmlRegisterSingletonInstance<ImageCache>("com.company.Assets", 1, 0, "ImageCache", ImageCache::instance());
 
-    if (!projectRoot.endsWith(QDir::separator()))
-        projectRoot += QDir::separator();
+    PageCache pageCache(&engine);
+    qmlRegisterSingletonInstance<PageCache>("com.company.PageCache", 1, 0, "PageCache", &pageCache);
 
-    QString projectDirUrl = QUrl::fromLocalFile(projectRoot).toString(); //file:///C:
-    engine.rootContext()->setContextProperty("projectDir", projectDirUrl);
-    qDebug() << "projectDir set to:" << projectDirUrl;
+    QObject::connect(&engine, &QQmlApplicationEngine::objectCreationFailed,
+                     &app, []() { QCoreApplication::exit(-1); }, Qt::QueuedConnection);
 
-    QString mainQmlPath = findMainQml(projectRoot);
-    if (!mainQmlPath.isEmpty()) {
-        qDebug() << "Loading QML from filesystem:" << mainQmlPath;
-        engine.load(QUrl::fromLocalFile(mainQmlPath));
+    // LCD_LABS_QML_DIR=<папка qml> загружает страницы с диска, как раньше,
+    // чтобы сравнить время до первого кадра с компилированным модулем
+    const QString qmlDir = qEnvironmentVariable("LCD_LABS_QML_DIR");
+    if (!qmlDir.isEmpty()) {
+        qDebug() << "Loading QML from filesystem:" << qmlDir;
+        engine.load(QUrl::fromLocalFile(QDir(qmlDir).filePath("Main.qml")));
     } else {
-        qDebug() << "Main.qml not found on filesystem. Trying qrc:/Main.qml as fallback.";
-        const QUrl url(QStringLiteral("qrc:/Main.qml"));
-        QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
-                         &app, [url](QObject *obj, const QUrl &objUrl) {
-                             if (!obj && url == objUrl)
-                                 QCoreApplication::exit(-1);
-                         }, Qt::QueuedConnection);
-        engine.load(url);
+        engine.loadFromModule("LcdLabs", "Main");
     }
 
     if (engine.rootObjects().isEmpty()) {
@@ -143,5 +143,29 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // frameSwapped приходит из потока рендера, поэтому время берём прямо там
+    static std::atomic_bool firstFrameReported(false);
+    if (auto window = qobject_cast<QQuickWindow *>(engine.rootObjects().first())) {
+        // Асинхронные инкубаторы PageCache работают в паузах между кадрами окна
+        if (!engine.incubationController()) {
+            engine.setIncubationController(window->incubationController());
+        }
+        frameStats->attach(window);
+        if (qEnvironmentVariableIsSet("LCD_LABS_STATS")) {
+            frameStats->setEnabled(true);
+        }
+        // LCD_LABS_EXIT_AFTER_FIRST_FRAME=1 завершает приложение после первого
+        // кадра: так сборки сравнивает tools/startupbench
+        const bool exitAfterFirstFrame = qEnvironmentVariableIsSet("LCD_LABS_EXIT_AFTER_FIRST_FRAME");
+        QObject::connect(window, &QQuickWindow::frameSwapped, window, [&startupTimer, exitAfterFirstFrame]() {
+            if (firstFrameReported.exchange(true)) return;
+            qDebug() << "Time to first frame:" << startupTimer.elapsed() << "ms"
+                     << (qEnvironmentVariableIsSet("LCD_LABS_QML_DIR") ? "(filesystem QML)" : "(compiled module)");
+            if (exitAfterFirstFrame) {
+                QMetaObject::invokeMethod(qApp, &QCoreApplication::quit, Qt::QueuedConnection);
+            }
+        }, Qt::DirectConnection);
+    }
+
     return app.exec();
 }
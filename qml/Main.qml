@@ -1,5 +1,7 @@
 import QtQuick
 import QtQuick.Controls
+import com.company.Stats 1.0
+import com.company.Trace 1.0
 
 ApplicationWindow {
     id: win
@@ -10,12 +12,8 @@ ApplicationWindow {
     color: "transparent"
 
     Component.onCompleted: {
-            var component = Qt.createComponent("qrc:/qml/labs/lab2/Lab2Page.qml")
-            if (component.status === Component.Ready) {
-                console.log("Lab2Page preloaded")
-            }
-            console.log("Main window loaded");
-        }
+        console.log("Main window loaded");
+    }
 
     StackView {
         id: stackView
@@ -25,4 +23,24 @@ ApplicationWindow {
             console.log("StackView current item changed:", currentItem)
         }
     }
+
+    StatsOverlay {
+        anchors.top: parent.top
+        anchors.right: parent.right
+        anchors.margins: 8
+        z: 100
+    }
+
+    Shortcut {
+        sequence: "F12"
+        context: Qt.ApplicationShortcut
+        onActivated: FrameStats.enabled = !FrameStats.enabled
+    }
+
+    // F11 начинает запись трассировки, повторное нажатие сохраняет файл
+    Shortcut {
+        sequence: "F11"
+        context: Qt.ApplicationShortcut
+        onActivated: Trace.recording ? Trace.stop() : Trace.start()
+    }
 }
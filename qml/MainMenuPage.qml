@@ -1,5 +1,7 @@
 import QtQuick
 import QtQuick.Controls
+import com.company.PageCache 1.0
+import com.company.Trace 1.0
 
 Item {
     id: root
@@ -7,10 +9,28 @@ Item {
     property int hoveredButtonIndex: -1
     property bool initialized: false
 
+    readonly property var labPages: [
+        Qt.resolvedUrl("labs/lab1/Lab1Page.qml"),
+        Qt.resolvedUrl("labs/lab2/Lab2Page.qml"),
+        Qt.resolvedUrl("labs/lab3/Lab3Page.qml"),
+        Qt.resolvedUrl("labs/lab4/Lab4Page.qml"),
+        Qt.resolvedUrl("labs/lab5/Lab5Page.qml"),
+        Qt.resolvedUrl("labs/lab6/Lab6Page.qml")
+    ]
+
+    function openLab(index) {
+        Trace.beginSpan("push lab" + (index + 1));
+        var page = PageCache.acquire(labPages[index]);
+        if (page) {
+            stackView.push(page);
+        }
+        Trace.endSpan();
+    }
+
     Image {
         id: bg
         anchors.fill: parent
-        source: (typeof projectDir !== "undefined" && projectDir !== "") ? projectDir + "resources/images/MM_bg.png" : "qrc:/images/MM_bg.png"
+        source: "image://assets/MM_bg"
         fillMode: Image.PreserveAspectCrop
         z: -1
     }
@@ -42,16 +62,7 @@ Item {
                 height: root.height * 0.08
                 z: 2
 
-                onClicked: {
-                    switch(index) {
-                        case 0: stackView.push("labs/lab1/Lab1Page.qml"); break;
-                        case 1: stackView.push("labs/lab2/Lab2Page.qml"); break;
-                        case 2: stackView.push("labs/lab3/Lab3Page.qml"); break;
-                        case 3: stackView.push("labs/lab4/Lab4Page.qml"); break;
-                        case 4: stackView.push("labs/lab5/Lab5Page.qml"); break;
-                        case 5: stackView.push("labs/lab6/Lab6Page.qml"); break;
-                    }
-                }
+                onClicked: root.openLab(index)
 
                 background: Rectangle {
                     color: btn.down ? "green" : (btn.hovered ? "lightgreen" : "darkgreen")
@@ -162,6 +173,9 @@ Item {
         avatar.y = (root.height - avatar.height) / 2;
         avatar.stopAnimationToStatic();
 
+        // Страницы лабораторных инкубируются в фоне, пока открыто меню
+        PageCache.preload(labPages.slice(0, 5));
+
         console.log("MainMenuPage loaded")
         console.log("Root size:", root.width, root.height)
     }
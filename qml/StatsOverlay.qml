@@ -0,0 +1,98 @@
+import QtQuick
+import com.company.Stats 1.0
+import com.company.Sprites 1.0
+import com.company.Assets 1.0
+import com.company.PageCache 1.0
+
+// Оверлей статистики кадров, переключается по F12
+Rectangle {
+    id: overlay
+    visible: FrameStats.enabled
+    width: statsColumn.implicitWidth + 20
+    height: statsColumn.implicitHeight + 20
+    radius: 6
+    color: "#C0000000"
+
+    Column {
+        id: statsColumn
+        x: 10
+        y: 10
+        spacing: 2
+
+        Text {
+            color: FrameStats.fps < 55 ? "#FF8080" : "#80FF80"
+            font.pixelSize: 14
+            font.bold: true
+            text: "FPS: " + FrameStats.fps.toFixed(0)
+        }
+        Text {
+            color: "white"
+            font.pixelSize: 12
+            text: "Кадр p50/p95/p99: " + FrameStats.p50.toFixed(1) + " / "
+                  + FrameStats.p95.toFixed(1) + " / " + FrameStats.p99.toFixed(1) + " мс"
+        }
+        Text {
+            color: "white"
+            font.pixelSize: 12
+            text: "Рендер p95: " + FrameStats.renderP95.toFixed(1) + " мс"
+        }
+        Text {
+            color: "white"
+            font.pixelSize: 12
+            text: "Ожидание swap p95: " + FrameStats.swapP95.toFixed(1) + " мс"
+        }
+        Text {
+            color: FrameStats.droppedFrames > 0 ? "#FFC080" : "white"
+            font.pixelSize: 12
+            text: "Пропущено кадров: " + FrameStats.droppedFrames
+        }
+        Text {
+            color: "white"
+            font.pixelSize: 12
+            text: "Активных спрайтов: " + AnimationClock.activeSubscribers
+        }
+        Text {
+            color: "white"
+            font.pixelSize: 12
+            text: "Кэш картинок: " + ImageCache.hits + " попаданий, " + ImageCache.misses + " промахов"
+        }
+        Text {
+            color: "white"
+            font.pixelSize: 12
+            text: "Страниц в кэше: " + PageCache.cachedPages
+        }
+
+        Text {
+            visible: StallWatchdog.enabled
+            color: StallWatchdog.stallCount > 0 ? "#FFC080" : "white"
+            font.pixelSize: 12
+            text: "Зависаний GUI: " + StallWatchdog.stallCount
+                  + ", худшее " + StallWatchdog.worstStall.toFixed(0) + " мс"
+        }
+        Repeater {
+            model: StallWatchdog.enabled ? StallWatchdog.histogram : []
+            delegate: Text {
+                required property var modelData
+                color: "#FFD0A0"
+                font.pixelSize: 12
+                text: "  ≥ " + modelData.budget + " мс: " + modelData.count
+            }
+        }
+        Text {
+            visible: StallWatchdog.enabled && StallWatchdog.lastCulprit !== ""
+            color: "#FFD0A0"
+            font.pixelSize: 12
+            text: "  последнее: " + StallWatchdog.lastCulprit
+        }
+
+        Repeater {
+            model: FrameStats.signalRates
+            delegate: Text {
+                required property var modelData
+                color: "#C0C0FF"
+                font.pixelSize: 12
+                text: modelData.name + ": " + modelData.rate + "/с (всего " + modelData.total + ")"
+            }
+        }
+    }
+}
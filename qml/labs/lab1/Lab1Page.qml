@@ -2,28 +2,28 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import com.company.PowerManager 1.0
+import com.company.Sprites 1.0
 
 Item {
     id: root
     property StackView stackView: parent
     property var powerManager: PowerManager
 
+    StackView.onActivating: {
+        powerManager.activate()
+    }
+
+    StackView.onRemoved: {
+        powerManager.suspend()
+    }
+
     Image {
         anchors.fill: parent
-        source: (typeof projectDir !== "undefined" && projectDir !== "") ?
-                projectDir + "resources/images/MM_bg.png" : "qrc:/images/MM_bg.png"
+        source: "image://assets/MM_bg"
         fillMode: Image.PreserveAspectCrop
     }
 
-    property var fireFrameWidths: [55, 50, 65, 65, 57, 43, 80, 85]
-    property var pilaFrameWidths: [155, 150, 135, 135, 150, 145, 140, 142]
-    property int animationFrameIndex: 0
-
     readonly property bool onAcPower: powerManager.powerSourceType === "От сети"
-    readonly property var currentFrameWidths: onAcPower ? fireFrameWidths : pilaFrameWidths
-
-    Image { id: fireSpriteSheet; source: (typeof projectDir !== "undefined" && projectDir !== "") ? projectDir + "resources/images/MM_fire.png" : "qrc:/images/MM_fire.png"; visible: false }
-    Image { id: pilaSpriteSheet; source: (typeof projectDir !== "undefined" && projectDir !== "") ? projectDir + "resources/images/MM_pila.png" : "qrc:/images/MM_pila.png"; visible: false }
 
 
 
@@ -83,29 +83,26 @@ Item {
 
         Item { Layout.fillHeight: true }
 
-        Canvas {
-            id: statusAnimationCanvas
+        Item {
+            id: statusAnimation
             Layout.alignment: Qt.AlignHCenter
-            width: 160
-            height: 160
-
-            onPaint: {
-                var ctx = getContext("2d");
-                ctx.reset();
-
-                var sourceImage = root.onAcPower ? fireSpriteSheet : pilaSpriteSheet;
-                if (sourceImage.status !== Image.Ready || root.animationFrameIndex >= root.currentFrameWidths.length) return;
-
-                var sx = 0;
-                for (var i=0; i < root.animationFrameIndex; ++i) {
-                    sx += root.currentFrameWidths[i];
-                }
-                var sw = root.currentFrameWidths[root.animationFrameIndex];
-                var sh = sourceImage.height;
-
-                var drawX = (width - sw) / 2;
+            Layout.preferredWidth: 160
+            Layout.preferredHeight: 160
+
+            SpriteItem {
+                anchors.fill: parent
+                visible: root.onAcPower
+                sheet: "fire"
+                interval: 120
+                playing: root.onAcPower
+            }
 
-                ctx.drawImage(sourceImage, sx, 0, sw, sh, drawX, 0, sw, sh);
+            SpriteItem {
+                anchors.fill: parent
+                visible: !root.onAcPower
+                sheet: "pila"
+                interval: 120
+                playing: !root.onAcPower
             }
         }
 
@@ -122,21 +119,5 @@ Item {
                 stackView.pop();
             }
         }
-        Timer {
-            interval: 120
-            running: true
-            repeat: true
-            onTriggered: {
-                root.animationFrameIndex = (root.animationFrameIndex + 1) % root.currentFrameWidths.length;
-                statusAnimationCanvas.requestPaint();
-            }
-        }
-        Connections {
-            target: powerManager
-            function onPowerSourceTypeChanged() {
-                root.animationFrameIndex = 0;
-                statusAnimationCanvas.requestPaint();
-            }
-        }
     }
 }
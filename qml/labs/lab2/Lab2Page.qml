@@ -9,18 +9,17 @@ Page {
 
     background: null
 
-    Component.onCompleted: {
-        PciManager.startServer()
+    StackView.onActivating: {
+        PciManager.activate()
     }
 
-    Component.onDestruction: {
-        PciManager.stopServer()
+    StackView.onRemoved: {
+        PciManager.suspend()
     }
 
     Image {
         anchors.fill: parent
-        source: (typeof projectDir !== "undefined" && projectDir !== "") ?
-                projectDir + "resources/images/MM_bg.png" : "qrc:/images/MM_bg.png"
+        source: "image://assets/MM_bg"
         fillMode: Image.PreserveAspectCrop
     }
 
@@ -35,7 +34,7 @@ Page {
             Button {
                 text: "← Назад"
                 font.pixelSize: 14
-                onClicked: stackView.pop()
+                onClicked: root.StackView.view.pop()
 
                 background: Rectangle {
                     color: parent.pressed ? "#666666" : "#444444"
@@ -110,13 +109,25 @@ Page {
                     color: PciManager.clientIP ? "#4CAF50" : "#FFA500"
                 }
 
+                Label {
+                    text: "Хостов / подключений:"
+                    font.bold: true
+                    color: "white"
+                }
+                Label {
+                    text: PciManager.hostCount + " / " + PciManager.connectionCount
+                    color: "white"
+                }
+
                 Label {
                     text: "Найдено устройств:"
                     font.bold: true
                     color: "white"
                 }
                 Label {
-                    text: PciManager.deviceCount
+                    text: PciManager.selectedHost === ""
+                          ? PciManager.deviceCount
+                          : PciManager.deviceCount + " (всего " + PciManager.totalDeviceCount + ")"
                     font.bold: true
                     color: "#00BCD4"
                     font.pixelSize: 16
@@ -177,6 +188,25 @@ Page {
                 onClicked: PciManager.clearDevices()
             }
 
+            ComboBox {
+                id: hostSelector
+                Layout.preferredWidth: 260
+                textRole: "title"
+                valueRole: "host"
+                model: {
+                    var items = [{ title: "Все хосты", host: "" }]
+                    var hosts = PciManager.hosts
+                    for (var i = 0; i < hosts.length; ++i) {
+                        var name = hosts[i].hostName ? hosts[i].hostName + " (" + hosts[i].host + ")" : hosts[i].host
+                        items.push({ title: name + " — " + hosts[i].deviceCount, host: hosts[i].host })
+                    }
+                    return items
+                }
+                onActivated: PciManager.selectedHost = currentValue
+                Component.onCompleted: currentIndex = indexOfValue(PciManager.selectedHost)
+                onModelChanged: currentIndex = indexOfValue(PciManager.selectedHost)
+            }
+
             Item { Layout.fillWidth: true }
 
             Label {
@@ -245,7 +275,7 @@ Page {
                             Layout.preferredWidth: 100
                         }
                         Label {
-                            text: "Производитель"
+                            text: "Производитель / устройство"
                             font.bold: true
                             color: "white"
                             Layout.fillWidth: true
@@ -258,9 +288,21 @@ Page {
                     Layout.fillWidth: true
                     Layout.fillHeight: true
                     clip: true
-                    model: PciManager.devices
+                    model: PciManager.deviceModel
+                    reuseItems: true
 
                     delegate: Rectangle {
+                        required property int bus
+                        required property int deviceNumber
+                        required property int functionNumber
+                        required property string vendorId
+                        required property string deviceId
+                        required property string vendorName
+                        required property string deviceName
+                        required property string subsystemName
+                        required property string classCode
+                        required property string className
+
                         width: deviceList.width
                         height: 30
                         color: "transparent"
@@ -277,34 +319,37 @@ Page {
                             anchors.margins: 10
 
                             Label {
-                                text: modelData.bus
+                                text: bus
                                 color: "white"
                                 Layout.preferredWidth: 60
                             }
                             Label {
-                                text: modelData.device
+                                text: deviceNumber
                                 color: "white"
                                 Layout.preferredWidth: 60
                             }
                             Label {
-                                text: modelData.function;
+                                text: functionNumber
                                 color: "white"
                                 Layout.preferredWidth: 70
                             }
                             Label {
-                                text: "0x" + modelData.vendorID
+                                text: "0x" + vendorId
                                 font.family: "monospace"
                                 color: "#00BCD4"
                                 Layout.preferredWidth: 100
                             }
                             Label {
-                                text: "0x" + modelData.deviceID
+                                text: "0x" + deviceId
                                 font.family: "monospace"
                                 color: "#00BCD4"
                                 Layout.preferredWidth: 100
                             }
                             Label {
-                                text: PciManager.getVendorName(modelData.vendorID)
+                                text: vendorName
+                                      + (deviceName ? " — " + deviceName : "")
+                                      + (subsystemName ? " (" + subsystemName + ")" : "")
+                                      + (className ? "  · " + className : classCode ? "  · класс " + classCode : "")
                                 color: "#4CAF50"
                                 Layout.fillWidth: true
                                 elide: Text.ElideRight
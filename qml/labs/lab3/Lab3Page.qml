@@ -9,18 +9,17 @@ Page {
 
     background: null
 
-    Component.onCompleted: {
-        HddManager.startServer()
+    StackView.onActivating: {
+        HddManager.activate()
     }
 
-    Component.onDestruction: {
-        HddManager.stopServer()
+    StackView.onRemoved: {
+        HddManager.suspend()
     }
 
     Image {
         anchors.fill: parent
-        source: (typeof projectDir !== "undefined" && projectDir !== "") ?
-                projectDir + "resources/images/MM_bg.png" : "qrc:/images/MM_bg.png"
+        source: "image://assets/MM_bg"
         fillMode: Image.PreserveAspectCrop
     }
 
@@ -36,7 +35,7 @@ Page {
             Button {
                 text: "← Назад"
                 font.pixelSize: 14
-                onClicked: stackView.pop()
+                onClicked: root.StackView.view.pop()
 
                 background: Rectangle {
                     color: parent.pressed ? "#666666" : "#444444"
@@ -1,60 +1,22 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
+import com.company.Sprites 1.0
 
 Item {
     id: root
 
-    property url spriteSource: (typeof projectDir !== "undefined" && projectDir !== "") ?
-                               projectDir + "resources/images/camera_warning.png" :
-                               "qrc:/images/camera_warning.png"
-    property var frameWidths: [104, 110, 104, 65, 57, 84, 88, 68, 90, 140, 118, 128, 94, 78]
-    property int frameHeight: 188
-    property int frameIndex: 0
+    property string sheet: "cameraWarning"
     property bool playing: true
 
     width: 140
-    height: frameHeight
+    height: 188
 
-    Image {
-        id: spriteSheet
-        source: root.spriteSource
-        visible: false
-        cache: true
-    }
-
-    Canvas {
-        id: canvas
+    SpriteItem {
         anchors.fill: parent
-
-        onPaint: {
-            var ctx = getContext("2d");
-            ctx.reset();
-
-            if (spriteSheet.status !== Image.Ready || frameIndex >= frameWidths.length) return;
-
-            var sx = 0;
-            for (var i = 0; i < root.frameIndex; ++i) {
-                sx += frameWidths[i];
-            }
-            var sw = frameWidths[root.frameIndex];
-            var sh = root.frameHeight;
-
-            var drawX = (root.width - sw) / 2;
-            var drawY = (root.height - sh) / 2;
-
-            ctx.drawImage(spriteSheet, sx, 0, sw, sh, drawX, drawY, sw, sh);
-        }
-    }
-
-    Timer {
+        sheet: root.sheet
         interval: 100
-        repeat: true
-        running: root.playing && root.visible
-        onTriggered: {
-            root.frameIndex = (root.frameIndex + 1) % root.frameWidths.length;
-            canvas.requestPaint();
-        }
+        playing: root.playing
     }
 
     SequentialAnimation on opacity {
@@ -10,14 +10,15 @@ Page {
 
     property bool cameraWarning: false
 
-    Component.onCompleted: {
+    StackView.onActivating: {
+        CameraManager.activate()
         if (CameraManager.cameraAvailable) {
             CameraManager.startCamera()
         }
     }
 
-    Component.onDestruction: {
-        CameraManager.stopCamera()
+    StackView.onRemoved: {
+        CameraManager.suspend()
     }
 
     Connections {
@@ -74,8 +75,7 @@ Page {
 
     Image {
         anchors.fill: parent
-        source: (typeof projectDir !== "undefined" && projectDir !== "") ?
-                projectDir + "resources/images/MM_bg.png" : "qrc:/images/MM_bg.png"
+        source: "image://assets/MM_bg"
         fillMode: Image.PreserveAspectCrop
     }
 
@@ -89,7 +89,7 @@ Page {
 
             Button {
                 text: "← Back"
-                onClicked: stackView.pop()
+                onClicked: root.StackView.view.pop()
 
                 background: Rectangle {
                     color: parent.pressed ? "#666666" : "#444444"
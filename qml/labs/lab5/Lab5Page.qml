@@ -8,14 +8,17 @@ Page {
     title: "USB Device Monitor"
 
     background: Image {
-        source: (typeof projectDir !== "undefined" && projectDir !== "") ?
-                projectDir + "resources/images/MM_bg.png" : "qrc:/images/MM_bg.png"
+        source: "image://assets/MM_bg"
         fillMode: Image.PreserveAspectCrop
     }
 
-    Component.onCompleted: {
-        // Запускаем первое сканирование при открытии страницы
-        UsbManager.initialScan();
+    StackView.onActivating: {
+        // Подписка на события устройств и первое сканирование при открытии страницы
+        UsbManager.activate();
+    }
+
+    StackView.onRemoved: {
+        UsbManager.suspend();
     }
 
     ColumnLayout {
@@ -30,7 +33,7 @@ Page {
 
             Button {
                 text: "← Назад"
-                onClicked: stackView.pop()
+                onClicked: root.StackView.view.pop()
                 // Стилизация кнопки для единообразия
                 background: Rectangle { color: parent.pressed ? "#666" : "#444"; radius: 5 }
                 contentItem: Text { text: parent.text; color: "white"; horizontalAlignment: Text.AlignHCenter; verticalAlignment: Text.AlignVCenter }
@@ -0,0 +1,49 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QStringList>
+#include <QTest>
+
+// Общая обвязка тестов потоковых разборщиков: разборщик, журнал его
+// событий одной строкой на событие и подача данных кусками. Разбор одним
+// куском и по байту сравниваются одним QCOMPARE по events. Stream — класс
+// с feed(const char *, размер) -> bool; обработчики событий подключает
+// наследник
+template <typename Stream>
+class EventLog
+{
+public:
+    EventLog() = default;
+    EventLog(const EventLog &) = delete;
+    EventLog &operator=(const EventLog &) = delete;
+
+    // chunkSize 0 — всё одним вызовом feed; false — разборщик отказался,
+    // остаток не подаётся
+    bool feedChunks(const char *data, qsizetype size, qsizetype chunkSize = 0)
+    {
+        if (chunkSize <= 0) chunkSize = qMax<qsizetype>(1, size);
+        for (qsizetype i = 0; i < size; i += chunkSize) {
+            if (!stream.feed(data + i, qMin(chunkSize, size - i))) return false;
+        }
+        return true;
+    }
+
+    Stream stream;
+    QStringList events;
+};
+
+// Столбец chunkSize для тестов *_data: целиком, по байту и размеры, которые
+// режут записи обоих протоколов в разных местах
+inline void addChunkSizeRows()
+{
+    QTest::addColumn<int>("chunkSize");
+    QTest::newRow("whole") << 0;
+    QTest::newRow("byte") << 1;
+    QTest::newRow("2 bytes") << 2;
+    QTest::newRow("5 bytes") << 5;
+    QTest::newRow("7 bytes") << 7;
+    QTest::newRow("64 bytes") << 64;
+    QTest::newRow("67 bytes") << 67;
+}
+
+#endif // EVENTLOG_H
@@ -0,0 +1,193 @@
+#include "labs/lab2/PciAgent.h"
+#include "labs/lab2/PciDelta.h"
+#include <QTest>
+#include <cstring>
+#include <memory>
+
+// Изменения агента на дереве tests/fixtures/pci (PCI_FIXTURE_DIR) от
+// PciAgent::createDelta через PciWire до PciDelta::apply на сервере
+
+static QStringList describe(const QList<PciDevice> &devices)
+{
+    QStringList result;
+    for (const PciDevice &d : devices) {
+        result << QString::asprintf("%02x:%02x.%x %04x:%04x ", d.bus, d.device, d.function, d.vendorId, d.deviceId)
+                      + QString::fromLatin1(d.configHeader.toHex());
+    }
+    return result;
+}
+
+// Что собирает соединение сервера из кадров агента
+struct Received {
+    QList<PciDevice> devices;
+    QList<int> removed;
+    int inventories = 0;
+    int deltas = 0;
+};
+
+static bool decode(const std::string &payload, Received &received)
+{
+    PciWire::Decoder decoder;
+    decoder.deviceDecoded = [&received](const PciWire::DeviceRecord &record) {
+        PciDevice device;
+        device.bus = record.bus;
+        device.device = record.device;
+        device.function = record.function;
+        device.vendorId = record.vendorId;
+        device.deviceId = record.deviceId;
+        received.devices.append(device);
+    };
+    decoder.configHeaderDecoded = [&received](const PciWire::DeviceRecord &record, const PciWire::u8 *header) {
+        for (PciDevice &device : received.devices) {
+            if (device.bus == record.bus && device.device == record.device && device.function == record.function) {
+                device.configHeader =
+                    QByteArray(reinterpret_cast<const char *>(header), int(PciWire::CONFIG_HEADER_SIZE));
+            }
+        }
+    };
+    decoder.functionRemoved = [&received](const PciWire::DeviceRecord &record) {
+        received.removed.append(PciAgent::functionKey(record.bus, record.device, record.function));
+    };
+    decoder.inventoryFinished = [&received](size_t) { ++received.inventories; };
+    decoder.deltaFinished = [&received](size_t, size_t) { ++received.deltas; };
+
+    std::string stream;
+    PciWire::appendHello(stream, PciWire::FLAG_DELTAS);
+    stream += payload;
+    return decoder.feed(stream.data(), stream.size());
+}
+
+class TestPciDelta : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void agentDeltaReachesServer_data();
+    void agentDeltaReachesServer();
+    void unchangedInventoryHasEmptyDelta();
+    void mergeCollapsesConsecutiveDeltas();
+
+private:
+    QList<PciDevice> serverList(const PciAgent::Inventory &inventory, bool withHeaders);
+
+    std::unique_ptr<PciConfigAccess> m_config;
+};
+
+void TestPciDelta::initTestCase()
+{
+    std::string error;
+    m_config.reset(PciConfigAccess::create("fake", PCI_FIXTURE_DIR, error));
+    QVERIFY2(m_config && m_config->open(error), error.c_str());
+}
+
+// Список хоста на сервере после полной инвентаризации агента
+QList<PciDevice> TestPciDelta::serverList(const PciAgent::Inventory &inventory, bool withHeaders)
+{
+    Received received;
+    if (!decode(PciAgent::createFullInventory(inventory, withHeaders), received) || received.inventories != 1) {
+        return {};
+    }
+    return received.devices;
+}
+
+void TestPciDelta::agentDeltaReachesServer_data()
+{
+    QTest::addColumn<bool>("withHeaders");
+    QTest::newRow("ids") << false;
+    QTest::newRow("headers") << true;
+}
+
+// Функция исчезла, другая сменила идентификатор, появилась новая: сервер,
+// применив изменения к прежнему списку, получает тот же список, что и
+// после полной инвентаризации
+void TestPciDelta::agentDeltaReachesServer()
+{
+    QFETCH(bool, withHeaders);
+    PciEnumerator enumerator(*m_config);
+    const PciAgent::Inventory before = PciAgent::scanInventory(enumerator, PciEnumerator::Topology, withHeaders);
+    QCOMPARE(before.size(), size_t(10));
+
+    PciAgent::Inventory after = before;
+    QCOMPARE(after.erase(PciAgent::functionKey(2, 0, 3)), size_t(1));
+    PciAgent::Function &nic = after.at(PciAgent::functionKey(1, 0, 0));
+    nic.record.deviceId ^= 0x0001;
+    if (withHeaders) nic.header[2] ^= 0x01;
+    PciAgent::Function added = {};
+    added.record = {4, 0, 0, 0x8086, 0x1234};
+    memset(added.header, 0xFF, sizeof(added.header));
+    after[PciAgent::functionKey(4, 0, 0)] = added;
+
+    size_t changedCount = 0, removedCount = 0;
+    const std::string delta = PciAgent::createDelta(before, after, withHeaders, changedCount, removedCount);
+    QCOMPARE(changedCount, size_t(2));
+    QCOMPARE(removedCount, size_t(1));
+    size_t countedChanged = 0, countedRemoved = 0;
+    PciAgent::countChanges(before, after, withHeaders, countedChanged, countedRemoved);
+    QCOMPARE(countedChanged, changedCount);
+    QCOMPARE(countedRemoved, removedCount);
+
+    Received received;
+    QVERIFY(decode(delta, received));
+    QCOMPARE(received.deltas, 1);
+    QCOMPARE(received.inventories, 0);
+    QCOMPARE(received.removed, QList<int>({PciAgent::functionKey(2, 0, 3)}));
+
+    QList<PciDevice> base = serverList(before, withHeaders);
+    QCOMPARE(base.size(), 10);
+    PciDelta::apply(base, received.devices, received.removed);
+    QCOMPARE(describe(base), describe(serverList(after, withHeaders)));
+}
+
+void TestPciDelta::unchangedInventoryHasEmptyDelta()
+{
+    PciEnumerator enumerator(*m_config);
+    const PciAgent::Inventory inventory = PciAgent::scanInventory(enumerator, PciEnumerator::Topology, true);
+    QVERIFY(PciAgent::sameInventory(inventory, inventory, true));
+
+    size_t changedCount = 1, removedCount = 1;
+    const std::string delta = PciAgent::createDelta(inventory, inventory, true, changedCount, removedCount);
+    QCOMPARE(changedCount, size_t(0));
+    QCOMPARE(removedCount, size_t(0));
+    std::string deltaEnd;
+    PciWire::appendDeltaEndFrame(deltaEnd);
+    QCOMPARE(QByteArray::fromStdString(delta), QByteArray::fromStdString(deltaEnd));
+}
+
+// Два изменения подряд до отправки в GUI: одно слитое изменение даёт тот
+// же список, что и оба по очереди
+void TestPciDelta::mergeCollapsesConsecutiveDeltas()
+{
+    PciEnumerator enumerator(*m_config);
+    const PciAgent::Inventory first = PciAgent::scanInventory(enumerator, PciEnumerator::Topology, false);
+    PciAgent::Inventory second = first;
+    second.erase(PciAgent::functionKey(2, 0, 1));
+    second.at(PciAgent::functionKey(3, 0, 0)).record.deviceId = 0xBEEF;
+    PciAgent::Inventory third = second;
+    third[PciAgent::functionKey(2, 0, 1)] = first.at(PciAgent::functionKey(2, 0, 1));
+    third.erase(PciAgent::functionKey(3, 0, 0));
+
+    size_t changedCount = 0, removedCount = 0;
+    Received one;
+    Received two;
+    QVERIFY(decode(PciAgent::createDelta(first, second, false, changedCount, removedCount), one));
+    QVERIFY(decode(PciAgent::createDelta(second, third, false, changedCount, removedCount), two));
+
+    QList<PciDevice> changed = one.devices;
+    QList<int> removed = one.removed;
+    PciDelta::merge(changed, removed, two.devices, two.removed);
+    QCOMPARE(describe(changed), describe(serverList({{PciAgent::functionKey(2, 0, 1),
+                                                      first.at(PciAgent::functionKey(2, 0, 1))}}, false)));
+    QCOMPARE(removed, QList<int>({PciAgent::functionKey(3, 0, 0)}));
+
+    QList<PciDevice> merged = serverList(first, false);
+    PciDelta::apply(merged, changed, removed);
+    QList<PciDevice> stepwise = serverList(first, false);
+    PciDelta::apply(stepwise, one.devices, one.removed);
+    PciDelta::apply(stepwise, two.devices, two.removed);
+    QCOMPARE(describe(merged), describe(stepwise));
+    QCOMPARE(describe(merged), describe(serverList(third, false)));
+}
+
+QTEST_APPLESS_MAIN(TestPciDelta)
+#include "tst_pcidelta.moc"
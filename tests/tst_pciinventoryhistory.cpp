@@ -0,0 +1,278 @@
+#include "labs/lab2/PciInventoryHistory.h"
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+#include <algorithm>
+
+static PciDevice device(int bus, int slot, int function, quint16 vendorId, quint16 deviceId,
+                        const QByteArray &configHeader = QByteArray())
+{
+    PciDevice result;
+    result.bus = quint8(bus);
+    result.device = quint8(slot);
+    result.function = quint8(function);
+    result.vendorId = vendorId;
+    result.deviceId = deviceId;
+    result.configHeader = configHeader;
+    return result;
+}
+
+static QStringList describe(const QList<PciDevice> &devices)
+{
+    QStringList result;
+    for (const PciDevice &d : devices) {
+        result << QString::asprintf("%02x:%02x.%x %04x:%04x ", d.bus, d.device, d.function, d.vendorId, d.deviceId)
+                      + QString::fromLatin1(d.configHeader.toHex());
+    }
+    return result;
+}
+
+class TestPciInventoryHistory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void roundTrip();
+    void reopen();
+    void truncatedDataTail();
+    void truncatedIndexTail();
+
+private:
+    // Больше двух интервалов между ключевыми записями
+    static constexpr int STEPS = 150;
+
+    static QDateTime timeOf(int step);
+    static QList<PciDevice> alphaAt(int step);
+    static QList<PciDevice> beta();
+    void fill(PciInventoryHistory &history, int steps);
+    void verify(const PciInventoryHistory &history, int steps);
+
+    QTemporaryDir m_dir;
+};
+
+// Два хоста с одинаковым FNV-1a: второй получает следующее свободное значение хеша
+static const char *const COLLIDING_HOST_A = "host-139599";
+static const char *const COLLIDING_HOST_B = "host-322382";
+
+QDateTime TestPciInventoryHistory::timeOf(int step)
+{
+    return QDateTime::fromMSecsSinceEpoch(Q_INT64_C(1700000000000)).addSecs(60 * step);
+}
+
+// Инвентаризация хоста alpha на шаге step, по возрастанию адреса: видеокарта
+// то пропадает, то появляется, контроллер SATA приходит и уходит,
+// идентификатор и заголовок меняются время от времени
+QList<PciDevice> TestPciInventoryHistory::alphaAt(int step)
+{
+    QList<PciDevice> devices;
+    devices << device(0, 0, 0, 0x8086, 0x1237);
+    devices << device(0, 1, 0, 0x8086, 0x7000);
+    devices << device(0, 31, 3, 0x8086, 0x7113, QByteArray(64, step % 11 == 0 ? char(step) : char(0x11)));
+    if (step % 7 != 3) devices << device(2, 0, 0, 0x10DE, 0x1C82);
+    if (step % 5 == 1) devices << device(3, 0, 0, 0x1B4B, 0x9172);
+    devices << device(5, 0, 0, 0x1AF4, quint16(0x1041 + step / 20));
+    return devices;
+}
+
+QList<PciDevice> TestPciInventoryHistory::beta()
+{
+    return {device(0, 0, 0, 0x1022, 0x1480), device(1, 0, 0, 0x1002, 0x67DF)};
+}
+
+void TestPciInventoryHistory::init()
+{
+    QVERIFY(m_dir.isValid());
+    QFile::remove(m_dir.filePath("history.dat"));
+    QFile::remove(m_dir.filePath("history.idx"));
+}
+
+void TestPciInventoryHistory::fill(PciInventoryHistory &history, int steps)
+{
+    for (int step = 0; step < steps; ++step) {
+        // Порядок устройств на входе не важен
+        QList<PciDevice> shuffled = alphaAt(step);
+        std::reverse(shuffled.begin(), shuffled.end());
+        QVERIFY(history.append("alpha", shuffled, timeOf(step)));
+        QVERIFY(history.append("beta", beta(), timeOf(step)));
+        if (step == 0) {
+            QVERIFY(history.append(COLLIDING_HOST_A, {device(0, 0, 0, 0xAAAA, 0x0001)}, timeOf(0)));
+            QVERIFY(history.append(COLLIDING_HOST_B, {device(0, 0, 0, 0xBBBB, 0x0002)}, timeOf(0)));
+        }
+    }
+}
+
+void TestPciInventoryHistory::verify(const PciInventoryHistory &history, int steps)
+{
+    QCOMPARE(history.hosts(), QStringList({"alpha", "beta", COLLIDING_HOST_A, COLLIDING_HOST_B}));
+
+    // Ключевая запись первая и не реже KEYFRAME_INTERVAL, остальное — разности
+    const QList<PciInventoryHistory::Snapshot> snapshots = history.snapshots("alpha", QDateTime(), QDateTime());
+    QCOMPARE(int(snapshots.size()), steps);
+    QVERIFY(snapshots.first().keyframe);
+    int keyframes = 0;
+    int sinceKeyframe = 0;
+    for (int step = 0; step < steps; ++step) {
+        QCOMPARE(snapshots[step].time, timeOf(step));
+        QCOMPARE(snapshots[step].deviceCount, int(alphaAt(step).size()));
+        sinceKeyframe = snapshots[step].keyframe ? 0 : sinceKeyframe + 1;
+        keyframes += snapshots[step].keyframe ? 1 : 0;
+        QVERIFY(sinceKeyframe < 64);
+    }
+    QVERIFY(keyframes >= (steps + 63) / 64);
+    QVERIFY(keyframes < steps / 2);
+
+    // Интервал по времени, все хосты
+    QCOMPARE(int(history.snapshots(QString(), timeOf(10), timeOf(19)).size()), 20);
+
+    // Каждый снимок восстанавливается по цепочке разностей, в том числе
+    // по времени между снимками
+    for (int step = 0; step < steps; ++step) {
+        QDateTime when;
+        QCOMPARE(describe(history.devicesAt("alpha", timeOf(step), &when)), describe(alphaAt(step)));
+        QCOMPARE(when, timeOf(step));
+        QCOMPARE(describe(history.devicesAt("alpha", timeOf(step).addSecs(30), &when)), describe(alphaAt(step)));
+        QCOMPARE(when, timeOf(step));
+        QCOMPARE(describe(history.devicesAt("beta", timeOf(step))), describe(beta()));
+    }
+    QDateTime when = timeOf(0);
+    QVERIFY(history.devicesAt("alpha", timeOf(0).addSecs(-1), &when).isEmpty());
+    QVERIFY(!when.isValid());
+    QCOMPARE(describe(history.devicesAt("alpha")), describe(alphaAt(steps - 1)));
+    QVERIFY(history.devicesAt("gamma").isEmpty());
+
+    // Коллизия хешей: хосты не смешиваются
+    QCOMPARE(describe(history.devicesAt(COLLIDING_HOST_A)), describe({device(0, 0, 0, 0xAAAA, 0x0001)}));
+    QCOMPARE(describe(history.devicesAt(COLLIDING_HOST_B)), describe({device(0, 0, 0, 0xBBBB, 0x0002)}));
+    QCOMPARE(int(history.snapshots(COLLIDING_HOST_A, QDateTime(), QDateTime()).size()), 1);
+    QCOMPARE(int(history.snapshots(COLLIDING_HOST_B, QDateTime(), QDateTime()).size()), 1);
+
+    // changesSince против модели
+    for (int since : {0, 3, 63, 64, 100, steps - 1}) {
+        const PciInventoryHistory::Changes changes = history.changesSince("alpha", timeOf(since).addSecs(1));
+        QCOMPARE(changes.since, timeOf(since));
+        QCOMPARE(changes.until, timeOf(steps - 1));
+
+        const QList<PciDevice> before = alphaAt(since);
+        const QList<PciDevice> after = alphaAt(steps - 1);
+        QList<PciDevice> added, removed, changedBefore, changedAfter;
+        for (const PciDevice &d : after) {
+            auto old = std::find_if(before.cbegin(), before.cend(), [&d](const PciDevice &b) {
+                return b.bus == d.bus && b.device == d.device && b.function == d.function;
+            });
+            if (old == before.cend()) {
+                added << d;
+            } else if (old->vendorId != d.vendorId || old->deviceId != d.deviceId || old->configHeader != d.configHeader) {
+                changedBefore << *old;
+                changedAfter << d;
+            }
+        }
+        for (const PciDevice &b : before) {
+            const bool kept = std::any_of(after.cbegin(), after.cend(), [&b](const PciDevice &d) {
+                return b.bus == d.bus && b.device == d.device && b.function == d.function;
+            });
+            if (!kept) removed << b;
+        }
+
+        QCOMPARE(describe(changes.added), describe(added));
+        QCOMPARE(describe(changes.removed), describe(removed));
+        QCOMPARE(changes.changed.size(), changedBefore.size());
+        for (int i = 0; i < changes.changed.size(); ++i) {
+            QCOMPARE(describe({changes.changed[i].first}), describe({changedBefore[i]}));
+            QCOMPARE(describe({changes.changed[i].second}), describe({changedAfter[i]}));
+        }
+    }
+
+    // До первого снимка сравнивать не с чем: всё добавлено
+    const PciInventoryHistory::Changes fromStart = history.changesSince("alpha", timeOf(0).addSecs(-1));
+    QVERIFY(!fromStart.since.isValid());
+    QCOMPARE(describe(fromStart.added), describe(alphaAt(steps - 1)));
+}
+
+void TestPciInventoryHistory::roundTrip()
+{
+    PciInventoryHistory history(m_dir.path());
+    QVERIFY2(history.isOpen(), qPrintable(history.errorString()));
+    fill(history, STEPS);
+    verify(history, STEPS);
+    QCOMPARE(history.indexSize(), qint64(STEPS * 2 + 2) * 40);
+}
+
+void TestPciInventoryHistory::reopen()
+{
+    {
+        PciInventoryHistory history(m_dir.path());
+        fill(history, STEPS);
+    }
+
+    // После перезапуска — те же ответы, и цепочка разностей продолжается
+    {
+        PciInventoryHistory history(m_dir.path());
+        QVERIFY(history.isOpen());
+        verify(history, STEPS);
+        QVERIFY(history.append("alpha", alphaAt(STEPS), timeOf(STEPS)));
+        QVERIFY(history.append("beta", beta(), timeOf(STEPS)));
+    }
+
+    PciInventoryHistory history(m_dir.path());
+    verify(history, STEPS + 1);
+}
+
+void TestPciInventoryHistory::truncatedDataTail()
+{
+    qint64 dataBefore = 0;
+    qint64 indexBefore = 0;
+    qint64 dataAfter = 0;
+    {
+        PciInventoryHistory history(m_dir.path());
+        fill(history, STEPS);
+        dataBefore = history.dataSize();
+        indexBefore = history.indexSize();
+        QVERIFY(history.append("alpha", alphaAt(STEPS), timeOf(STEPS)));
+        dataAfter = history.dataSize();
+    }
+    QVERIFY(dataAfter - dataBefore > 1);
+
+    // Аварийное завершение посреди записи данных: индекс уже есть, данных нет
+    QVERIFY(QFile::resize(m_dir.filePath("history.dat"), dataBefore + (dataAfter - dataBefore) / 2));
+
+    {
+        PciInventoryHistory history(m_dir.path());
+        QVERIFY(history.isOpen());
+        QCOMPARE(history.dataSize(), dataBefore);
+        QCOMPARE(history.indexSize(), indexBefore);
+        QCOMPARE(QFileInfo(m_dir.filePath("history.dat")).size(), dataBefore);
+        verify(history, STEPS);
+
+        // Дописывание после обрезки продолжает историю хоста
+        QVERIFY(history.append("alpha", alphaAt(STEPS), timeOf(STEPS)));
+        QVERIFY(history.append("beta", beta(), timeOf(STEPS)));
+    }
+
+    PciInventoryHistory history(m_dir.path());
+    verify(history, STEPS + 1);
+}
+
+void TestPciInventoryHistory::truncatedIndexTail()
+{
+    qint64 dataBefore = 0;
+    qint64 indexBefore = 0;
+    {
+        PciInventoryHistory history(m_dir.path());
+        fill(history, STEPS);
+        dataBefore = history.dataSize();
+        indexBefore = history.indexSize();
+        QVERIFY(history.append("alpha", alphaAt(STEPS), timeOf(STEPS)));
+    }
+
+    // Данные записаны, запись индекса оборвалась: данные без индекса отбрасываются
+    QVERIFY(QFile::resize(m_dir.filePath("history.idx"), indexBefore + 40 - 7));
+
+    PciInventoryHistory history(m_dir.path());
+    QCOMPARE(history.indexSize(), indexBefore);
+    QCOMPARE(history.dataSize(), dataBefore);
+    verify(history, STEPS);
+}
+
+QTEST_GUILESS_MAIN(TestPciInventoryHistory)
+#include "tst_pciinventoryhistory.moc"
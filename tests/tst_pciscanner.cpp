@@ -0,0 +1,393 @@
+// Обход шин и разбор снимков сканером на дереве tests/fixtures/pci. Без Qt,
+// как и сам сканер: tst_pciscanner <каталог с фикстурой>
+//
+// Дерево фикстуры:
+//   00:00.0 хост-мост, многофункциональный; 00:00.1 обслуживает шину 1
+//   00:01.0 мост на шины 2-3       01:00.0 сетевая карта
+//   00:03.0 ненастроенный мост      02:00.0, .1, .3 — функции с пропуском .2
+//                                   02:01.0 мост на шину 3
+//                                   03:00.0 видеокарта: пары 64-битных
+//                                   BAR, петли в обоих списках capability
+#include "labs/lab2/PciAgent.h"
+#include "labs/lab2/PciConfigAccess.h"
+#include "labs/lab2/PciConfigSpace.h"
+#include "labs/lab2/PciEnumerator.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            ++failures; \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(actual, expected) \
+    do { \
+        if (!((actual) == (expected))) { \
+            ++failures; \
+            printf("FAIL %s:%d: %s == %s\n  actual:   %s\n  expected: %s\n", __FILE__, __LINE__, #actual, \
+                   #expected, describe(actual).c_str(), describe(expected).c_str()); \
+        } \
+    } while (0)
+
+static std::string describe(unsigned value) { return std::to_string(value); }
+
+static std::string describe(const std::vector<std::string> &functions)
+{
+    std::string out;
+    for (const std::string &f : functions) out += (out.empty() ? "" : " ") + f;
+    return out;
+}
+
+// Фикстура с подменённым байтом — вариант дерева без второго набора файлов
+class PatchedAccess : public PciConfigAccess
+{
+public:
+    PatchedAccess(PciConfigAccess &inner, u8 bus, u8 device, u8 function, u16 offset, u8 value)
+        : m_inner(inner), m_bus(bus), m_device(device), m_function(function), m_offset(offset), m_value(value)
+    {
+    }
+
+    const char *name() const override { return "patched"; }
+    bool open(std::string &error) override { return m_inner.open(error); }
+    void close() override { m_inner.close(); }
+    void refresh() override { m_inner.refresh(); }
+
+    u32 read32(u8 bus, u8 device, u8 function, u16 offset) override
+    {
+        u32 value = m_inner.read32(bus, device, function, offset);
+        if (matches(bus, device, function) && (m_offset & ~3) == offset) {
+            const int shift = (m_offset & 3) * 8;
+            value = (value & ~(0xFFu << shift)) | (u32(m_value) << shift);
+        }
+        return value;
+    }
+
+    size_t read(u8 bus, u8 device, u8 function, u8 *buffer, size_t size) override
+    {
+        const size_t read = m_inner.read(bus, device, function, buffer, size);
+        if (matches(bus, device, function) && m_offset < read) buffer[m_offset] = m_value;
+        return read;
+    }
+
+private:
+    bool matches(u8 bus, u8 device, u8 function) const
+    {
+        return bus == m_bus && device == m_device && function == m_function;
+    }
+
+    PciConfigAccess &m_inner;
+    u8 m_bus, m_device, m_function;
+    u16 m_offset;
+    u8 m_value;
+};
+
+struct ScanResult {
+    std::vector<std::string> functions;     // в порядке обнаружения
+    PciEnumerator::Stats stats;
+};
+
+static ScanResult scan(PciConfigAccess &config, PciEnumerator::Mode mode, size_t captureSize)
+{
+    config.refresh();
+    PciEnumerator enumerator(config);
+    enumerator.setCaptureSize(captureSize);
+
+    ScanResult result;
+    result.stats = enumerator.scan(mode, [&result](const PciEnumerator::Function &f) {
+        char text[32];
+        snprintf(text, sizeof(text), "%02x:%02x.%x %04x:%04x", f.bus, f.device, f.function, f.vendorId, f.deviceId);
+        result.functions.push_back(text);
+    });
+    return result;
+}
+
+static std::vector<std::string> sorted(std::vector<std::string> functions)
+{
+    std::sort(functions.begin(), functions.end());
+    return functions;
+}
+
+static const size_t CAPTURE_SIZES[] = {0, PciConfigAccess::CONFIG_SPACE_SIZE,
+                                       PciConfigAccess::EXTENDED_CONFIG_SPACE_SIZE};
+
+// Оба режима находят одни и те же функции; топология — за 4 шины и с
+// меньшим числом чтений
+static void sameFunctionsAsBruteForce(PciConfigAccess &config)
+{
+    for (size_t capture : CAPTURE_SIZES) {
+        const ScanResult topology = scan(config, PciEnumerator::Topology, capture);
+        const ScanResult brute = scan(config, PciEnumerator::BruteForce, capture);
+        CHECK_EQUAL(topology.stats.functions, 10u);
+        CHECK_EQUAL(sorted(topology.functions), sorted(brute.functions));
+        CHECK_EQUAL(topology.stats.buses, 4u);
+        CHECK_EQUAL(brute.stats.buses, 256u);
+        CHECK(topology.stats.probes * 10 < brute.stats.probes);
+    }
+
+    // Снимок заменяет отдельные чтения типа заголовка и номеров шин: по 32
+    // на шину, по 7 на многофункциональные 00:00 и 02:00, затем тип
+    // заголовка 0:0.0 и 7 идентификаторов его функций
+    const ScanResult captured = scan(config, PciEnumerator::Topology, PciConfigAccess::EXTENDED_CONFIG_SPACE_SIZE);
+    CHECK_EQUAL(captured.stats.probes, 4 * 32u + 2 * 7u + 1u + 7u);
+}
+
+// Спуск через мосты в глубину, функции 1-7 только у многофункциональных
+// устройств, пропуск функции не обрывает перебор
+static void bridgeRecursion(PciConfigAccess &config)
+{
+    const std::vector<std::string> expected = {
+        "00:00.0 8086:29c0", "00:00.1 8086:29c1", "00:01.0 8086:29c3",
+        "02:00.0 1b4b:9172", "02:00.1 1b4b:9173", "02:00.3 1b4b:9174",
+        "02:01.0 10b5:8747", "03:00.0 10de:1c82", "00:03.0 8086:29c5",
+        "01:00.0 8086:10d3",
+    };
+    for (size_t capture : CAPTURE_SIZES) {
+        CHECK_EQUAL(scan(config, PciEnumerator::Topology, capture).functions, expected);
+    }
+}
+
+// Шины за функциями хост-моста ищутся только при бите многофункциональности
+// у 0:0.0; перебор находит их в любом случае
+static void multifunctionHostBridge(PciConfigAccess &config)
+{
+    PatchedAccess single(config, 0, 0, 0, 0x0E, 0x00);
+    for (size_t capture : CAPTURE_SIZES) {
+        const ScanResult topology = scan(single, PciEnumerator::Topology, capture);
+        const ScanResult brute = scan(single, PciEnumerator::BruteForce, capture);
+        CHECK_EQUAL(topology.stats.functions, 8u);
+        CHECK_EQUAL(topology.stats.buses, 3u);
+        CHECK(std::find(topology.functions.begin(), topology.functions.end(), "00:00.1 8086:29c1")
+              == topology.functions.end());
+        CHECK(std::find(topology.functions.begin(), topology.functions.end(), "01:00.0 8086:10d3")
+              == topology.functions.end());
+        CHECK_EQUAL(brute.stats.functions, 10u);
+    }
+}
+
+// Мост со вторичной шиной не больше своей (петля, ненастроенный) не
+// обходится повторно
+static void bridgeLoop(PciConfigAccess &config)
+{
+    // 02:01.0 ссылается на свою же шину 2: шина 3 недостижима
+    PatchedAccess loop(config, 2, 1, 0, 0x19, 0x02);
+    for (size_t capture : CAPTURE_SIZES) {
+        const ScanResult topology = scan(loop, PciEnumerator::Topology, capture);
+        CHECK_EQUAL(topology.stats.functions, 9u);
+        CHECK_EQUAL(topology.stats.buses, 3u);
+    }
+
+    // 02:01.0 ссылается назад на шину 1, уже обслуживаемую хост-мостом
+    PatchedAccess back(config, 2, 1, 0, 0x19, 0x01);
+    const ScanResult topology = scan(back, PciEnumerator::Topology, PciConfigAccess::CONFIG_SPACE_SIZE);
+    CHECK_EQUAL(topology.stats.functions, 9u);
+    CHECK_EQUAL(topology.stats.buses, 3u);
+}
+
+// Снимок функции фикстуры, разобранный декодером сканера
+static PciConfig::Info decodeFunction(PciConfigAccess &config, PciConfigAccess::u8 bus, PciConfigAccess::u8 device,
+                                      PciConfigAccess::u8 function, size_t captureSize)
+{
+    std::vector<PciConfigAccess::u8> buffer(captureSize);
+    const size_t size = config.read(bus, device, function, &buffer[0], buffer.size());
+    PciConfig::Info info;
+    CHECK(PciConfig::decode(&buffer[0], size, info));
+    return info;
+}
+
+static std::vector<std::string> describeBars(const std::vector<PciConfig::Bar> &bars)
+{
+    std::vector<std::string> out;
+    for (const PciConfig::Bar &bar : bars) {
+        char text[64];
+        snprintf(text, sizeof(text), "BAR%u %s %llx%s", bar.index, bar.io ? "I/O" : (bar.is64 ? "mem64" : "mem32"),
+                 bar.address, bar.prefetchable ? " prefetchable" : "");
+        out.push_back(text);
+    }
+    return out;
+}
+
+static std::vector<std::string> describeCapabilities(const std::vector<PciConfig::Capability> &capabilities)
+{
+    std::vector<std::string> out;
+    for (const PciConfig::Capability &capability : capabilities) {
+        const char *name = PciConfig::capabilityName(capability);
+        char text[32];
+        snprintf(text, sizeof(text), "%s@%x", name ? name : "?", capability.offset);
+        out.push_back(text);
+    }
+    return out;
+}
+
+// 64-битный BAR занимает два слота: старшая половина не выводится отдельным
+// BAR, в последнем слоте пары нет и старшая половина не берётся из
+// следующего поля заголовка
+static void barPairing(PciConfigAccess &config)
+{
+    const std::vector<std::string> gpu = {
+        "BAR0 mem32 fd000000", "BAR1 mem64 1c0000000 prefetchable",
+        "BAR3 mem64 2e0000000", "BAR5 I/O d000",
+    };
+    CHECK_EQUAL(describeBars(decodeFunction(config, 3, 0, 0, PciConfigAccess::CONFIG_SPACE_SIZE).bars), gpu);
+
+    // У моста два BAR, за BAR1 лежат номера шин 00 02 03
+    const PciConfig::Info bridge = decodeFunction(config, 0, 1, 0, PciConfigAccess::CONFIG_SPACE_SIZE);
+    CHECK_EQUAL(describeBars(bridge.bars), std::vector<std::string>({"BAR1 mem64 f0000000"}));
+    CHECK_EQUAL(unsigned(bridge.secondaryBus), 2u);
+    CHECK_EQUAL(unsigned(bridge.subordinateBus), 3u);
+
+    // Снимок обрывается между половинами: пары нет, адрес только из младшей
+    std::vector<PciConfigAccess::u8> buffer(PciConfigAccess::CONFIG_SPACE_SIZE);
+    config.read(3, 0, 0, &buffer[0], buffer.size());
+    std::vector<PciConfig::Bar> bars;
+    PciConfig::decodeBars(&buffer[0], 0x18, 6, bars);
+    CHECK_EQUAL(describeBars(bars), std::vector<std::string>({"BAR0 mem32 fd000000", "BAR1 mem64 c0000000 prefetchable"}));
+}
+
+// Списки capability заканчиваются на указателе на уже пройденную
+// capability: 03:00.0 — PCIe ссылается на себя, DSN — назад на AER
+static void capabilityLoops(PciConfigAccess &config)
+{
+    CHECK_EQUAL(describeCapabilities(decodeFunction(config, 3, 0, 0, PciConfigAccess::EXTENDED_CONFIG_SPACE_SIZE).capabilities),
+                std::vector<std::string>({"PM@60", "MSI@68", "PCIe@78", "AER@100", "DSN@150"}));
+    // Без расширенного пространства — только стандартный список
+    CHECK_EQUAL(describeCapabilities(decodeFunction(config, 3, 0, 0, PciConfigAccess::CONFIG_SPACE_SIZE).capabilities),
+                std::vector<std::string>({"PM@60", "MSI@68", "PCIe@78"}));
+    CHECK_EQUAL(describeCapabilities(decodeFunction(config, 0, 1, 0, PciConfigAccess::CONFIG_SPACE_SIZE).capabilities),
+                std::vector<std::string>({"PCIe@40"}));
+
+    // Первая же capability ссылается на себя, в обоих списках
+    std::vector<PciConfig::u8> space(PciConfigAccess::EXTENDED_CONFIG_SPACE_SIZE, 0);
+    space[0x06] = PciConfig::STATUS_CAPABILITIES;
+    space[0x34] = 0x40;
+    space[0x40] = 0x05;
+    space[0x41] = 0x40;
+    // AER версии 1, следующая — на 0x100
+    space[0x100] = 0x01;
+    space[0x102] = 0x01;
+    space[0x103] = 0x10;
+    std::vector<PciConfig::Capability> capabilities;
+    PciConfig::decodeCapabilities(&space[0], space.size(), PciConfig::STATUS_CAPABILITIES, 0, capabilities);
+    CHECK_EQUAL(describeCapabilities(capabilities), std::vector<std::string>({"MSI@40", "AER@100"}));
+
+    // Указатель за пределы снимка обрывает список
+    space[0x41] = 0xFC;
+    capabilities.clear();
+    PciConfig::decodeCapabilities(&space[0], 0xFD, PciConfig::STATUS_CAPABILITIES, 0, capabilities);
+    CHECK_EQUAL(describeCapabilities(capabilities), std::vector<std::string>({"MSI@40"}));
+}
+
+// Быстрая проверка агента: изменение идентификатора видно в обоих режимах,
+// изменение остального заголовка — только с заголовками
+static void agentVerifyInventory(PciConfigAccess &config)
+{
+    PciEnumerator enumerator(config);
+    for (int withHeaders = 0; withHeaders < 2; ++withHeaders) {
+        const PciAgent::Inventory inventory =
+            PciAgent::scanInventory(enumerator, PciEnumerator::Topology, withHeaders != 0);
+        CHECK_EQUAL(unsigned(inventory.size()), 10u);
+        CHECK(PciAgent::verifyInventory(config, inventory, withHeaders != 0));
+
+        PatchedAccess deviceId(config, 1, 0, 0, 0x02, 0x00);
+        CHECK(!PciAgent::verifyInventory(deviceId, inventory, withHeaders != 0));
+        // Линия прерывания
+        PatchedAccess interruptLine(config, 1, 0, 0, 0x3C, 0x0B);
+        CHECK(PciAgent::verifyInventory(interruptLine, inventory, withHeaders != 0) == (withHeaders == 0));
+
+        // Без изменений изменения пусты; старому серверу уходит весь список
+        // с теми же подсчётами
+        PciAgent::Inventory after = inventory;
+        after.erase(PciAgent::functionKey(2, 0, 3));
+        size_t changedCount = 1, removedCount = 1;
+        PciAgent::countChanges(inventory, inventory, withHeaders != 0, changedCount, removedCount);
+        CHECK_EQUAL(unsigned(changedCount + removedCount), 0u);
+        PciAgent::countChanges(inventory, after, withHeaders != 0, changedCount, removedCount);
+        CHECK_EQUAL(unsigned(changedCount), 0u);
+        CHECK_EQUAL(unsigned(removedCount), 1u);
+    }
+}
+
+#ifndef _WIN32
+static bool writeConfig(const std::string &path, PciConfigAccess::u16 vendorId, PciConfigAccess::u16 deviceId)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    const unsigned char data[4] = {PciConfigAccess::u8(vendorId), PciConfigAccess::u8(vendorId >> 8),
+                                   PciConfigAccess::u8(deviceId), PciConfigAccess::u8(deviceId >> 8)};
+    const bool ok = fwrite(data, 1, sizeof(data), file) == sizeof(data);
+    return fclose(file) == 0 && ok;
+}
+
+// Функцию удалили и на её место встала другая: старый файл больше не
+// читается (здесь — обрезан), агент должен увидеть новую без перезапуска
+static void sysfsReopensReplacedFunction()
+{
+    char root[] = "/tmp/tst_pciscanner.XXXXXX";
+    CHECK(mkdtemp(root) != nullptr);
+    const std::string dir = std::string(root) + "/0000:00:00.0";
+    const std::string path = dir + "/config";
+    const std::string replacement = std::string(root) + "/replacement";
+    CHECK(mkdir(dir.c_str(), 0700) == 0);
+    CHECK(writeConfig(path, 0x8086, 0x1237));
+
+    std::string error;
+    std::unique_ptr<PciConfigAccess> config(PciConfigAccess::create("sysfs", root, error));
+    CHECK(config && config->open(error));
+    if (config) {
+        CHECK_EQUAL(unsigned(config->read32(0, 0, 0, 0)), 0x12378086u);
+
+        CHECK(truncate(path.c_str(), 0) == 0);
+        CHECK(writeConfig(replacement, 0x8086, 0x10D3));
+        CHECK(rename(replacement.c_str(), path.c_str()) == 0);
+        CHECK_EQUAL(unsigned(config->read32(0, 0, 0, 0)), 0xFFFFFFFFu);
+        config->refresh();
+        CHECK_EQUAL(unsigned(config->read32(0, 0, 0, 0)), 0x10D38086u);
+        config->close();
+    }
+
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+    rmdir(root);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        printf("Usage: tst_pciscanner <fixture directory>\n");
+        return 2;
+    }
+
+    std::string error;
+    std::unique_ptr<PciConfigAccess> config(PciConfigAccess::create("fake", argv[1], error));
+    if (!config || !config->open(error)) {
+        printf("FAIL cannot open fixture %s: %s\n", argv[1], error.c_str());
+        return 1;
+    }
+
+    sameFunctionsAsBruteForce(*config);
+    bridgeRecursion(*config);
+    multifunctionHostBridge(*config);
+    bridgeLoop(*config);
+    barPairing(*config);
+    capabilityLoops(*config);
+    agentVerifyInventory(*config);
+#ifndef _WIN32
+    sysfsReopensReplacedFunction();
+#endif
+
+    printf("%s, %d failures\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+#include "EventLog.h"
+#include "labs/lab2/PciStreamParser.h"
+#include <QTest>
+
+// Журнал событий парсера одной строкой на событие
+class ParserLog : public EventLog<PciStreamParser>
+{
+public:
+    ParserLog()
+    {
+        stream.arrayStarted = [this]() { events << "start"; };
+        stream.deviceParsed = [this](const PciDevice &device) {
+            events << QString::asprintf("%02x:%02x.%x %04x:%04x", device.bus, device.device, device.function,
+                                        device.vendorId, device.deviceId);
+        };
+        stream.arrayFinished = [this](int deviceCount) { events << QString("end %1").arg(deviceCount); };
+    }
+
+    bool feed(const QByteArray &payload, qsizetype chunkSize = 0)
+    {
+        return feedChunks(payload.constData(), payload.size(), chunkSize);
+    }
+};
+
+class TestPciStreamParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void chunkBoundaries_data();
+    void chunkBoundaries();
+    void sameEventsForAnyChunking();
+    void rejectsMalformedInput_data();
+    void rejectsMalformedInput();
+    void resetAfterError();
+    void capsUnterminatedElement();
+    void acceptsLargestAllowedElement();
+
+private:
+    static QByteArray inventory();
+    static QStringList inventoryEvents();
+};
+
+// Строки с экранированными кавычками, обратной косой чертой и скобками,
+// вложенные объекты и массивы, пробелы между элементами и второй массив
+// в том же соединении
+QByteArray TestPciStreamParser::inventory()
+{
+    return QByteArray(
+        " [ {\"bus\":0,\"device\":1,\"function\":0,\"vendorID\":\"8086\",\"deviceID\":\"1237\",\"path\":\"C:\\\\\"},\n"
+        "{\"bus\":2,\"device\":3,\"function\":4,\"vendorID\":\"10DE\",\"deviceID\":\"1C82\","
+        "\"name\":\"GPU \\\"}{\\\" [x]\",\"extra\":{\"a\":[1,{\"b\":\"]\"}]}} ,\r\n"
+        "\t{\"bus\":255,\"device\":31,\"function\":7,\"vendorID\":\"zzzz\",\"deviceID\":\"FFFF\"} ]"
+        "[]\n");
+}
+
+QStringList TestPciStreamParser::inventoryEvents()
+{
+    return QStringList{"start",
+                       "00:01.0 8086:1237",
+                       "02:03.4 10de:1c82",
+                       "ff:1f.7 ffff:ffff",
+                       "end 3",
+                       "start",
+                       "end 0"};
+}
+
+void TestPciStreamParser::chunkBoundaries_data()
+{
+    addChunkSizeRows();
+}
+
+void TestPciStreamParser::chunkBoundaries()
+{
+    QFETCH(int, chunkSize);
+    ParserLog log;
+    QVERIFY2(log.feed(inventory(), chunkSize), qPrintable(log.stream.errorString()));
+    QCOMPARE(log.events, inventoryEvents());
+    QVERIFY(!log.stream.inArray());
+}
+
+void TestPciStreamParser::sameEventsForAnyChunking()
+{
+    ParserLog whole;
+    ParserLog bytes;
+    QVERIFY(whole.feed(inventory()));
+    QVERIFY(bytes.feed(inventory(), 1));
+    QCOMPARE(bytes.events, whole.events);
+
+    // Незаконченный массив: устройство уже отдано, конца ещё нет
+    ParserLog partial;
+    QVERIFY(partial.feed("[{\"bus\":1,\"device\":0,\"function\":0,\"vendorID\":\"1AF4\",\"deviceID\":\"1041\"},{\"bus\"", 1));
+    QCOMPARE(partial.events, QStringList({"start", "01:00.0 1af4:1041"}));
+    QVERIFY(partial.stream.inArray());
+    QCOMPARE(partial.stream.elementCount(), 1);
+}
+
+void TestPciStreamParser::rejectsMalformedInput_data()
+{
+    QTest::addColumn<QByteArray>("payload");
+    QTest::newRow("object instead of array") << QByteArray("{\"bus\":1}");
+    QTest::newRow("number element") << QByteArray("[1]");
+    QTest::newRow("garbage after element") << QByteArray("[{\"bus\":1} x]");
+    QTest::newRow("bad element json") << QByteArray("[{\"bus\":}]");
+    QTest::newRow("unbalanced brackets") << QByteArray("[{\"bus\":[1}]");
+    QTest::newRow("binary hello") << QByteArray("PCIB\x02\x00", 6);
+}
+
+void TestPciStreamParser::rejectsMalformedInput()
+{
+    QFETCH(QByteArray, payload);
+    ParserLog whole;
+    ParserLog bytes;
+    QVERIFY(!whole.feed(payload));
+    QVERIFY(!bytes.feed(payload, 1));
+    QVERIFY(!whole.stream.errorString().isEmpty());
+    QCOMPARE(bytes.events, whole.events);
+    QCOMPARE(bytes.stream.errorString(), whole.stream.errorString());
+}
+
+void TestPciStreamParser::resetAfterError()
+{
+    ParserLog log;
+    QVERIFY(!log.feed("[1]"));
+    // Повреждённый поток не оживает от правильных данных
+    QVERIFY(!log.feed("[]"));
+
+    log.stream.reset();
+    log.events.clear();
+    QVERIFY(log.stream.errorString().isEmpty());
+    QVERIFY(log.feed("[]"));
+    QCOMPARE(log.events, QStringList({"start", "end 0"}));
+}
+
+void TestPciStreamParser::capsUnterminatedElement()
+{
+    ParserLog log;
+    QVERIFY(log.feed("[{\"name\":\""));
+
+    // Незакрытая строка кусками по 4 КиБ: парсер должен сдаться на пределе
+    const QByteArray chunk(4096, 'a');
+    qsizetype fed = 0;
+    bool ok = true;
+    while (ok && fed <= PciStreamParser::MAX_ELEMENT_SIZE * 2) {
+        ok = log.feed(chunk);
+        fed += chunk.size();
+    }
+    QVERIFY(!ok);
+    QVERIFY(fed <= PciStreamParser::MAX_ELEMENT_SIZE + chunk.size());
+    QVERIFY(!log.stream.errorString().isEmpty());
+    QCOMPARE(log.events, QStringList({"start"}));
+
+    // Незакрытые скобки — то же самое
+    ParserLog nested;
+    QVERIFY(!nested.feed("[" + QByteArray(PciStreamParser::MAX_ELEMENT_SIZE + 1, '{')));
+}
+
+void TestPciStreamParser::acceptsLargestAllowedElement()
+{
+    const QByteArray head("{\"bus\":1,\"device\":2,\"function\":3,\"vendorID\":\"8086\",\"deviceID\":\"0001\",\"pad\":\"");
+    const QByteArray tail("\"}");
+    const QByteArray element = head + QByteArray(PciStreamParser::MAX_ELEMENT_SIZE - head.size() - tail.size(), 'x') + tail;
+    QCOMPARE(element.size(), PciStreamParser::MAX_ELEMENT_SIZE);
+
+    ParserLog log;
+    QVERIFY2(log.feed("[" + element + "]", 1000), qPrintable(log.stream.errorString()));
+    QCOMPARE(log.events, QStringList({"start", "01:02.3 8086:0001", "end 1"}));
+}
+
+QTEST_APPLESS_MAIN(TestPciStreamParser)
+#include "tst_pcistreamparser.moc"
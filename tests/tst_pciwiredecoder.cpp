@@ -0,0 +1,243 @@
+#include "EventLog.h"
+#include "labs/lab2/PciWireFormat.h"
+#include <QTest>
+
+// Журнал событий декодера одной строкой на событие
+class DecoderLog : public EventLog<PciWire::Decoder>
+{
+public:
+    DecoderLog()
+    {
+        stream.helloReceived = [this](PciWire::u8 version, PciWire::u8 flags) {
+            events << QString::asprintf("hello %u %u", version, flags);
+        };
+        stream.inventoryStarted = [this]() { events << "start"; };
+        stream.deviceDecoded = [this](const PciWire::DeviceRecord &record) {
+            events << QString::asprintf("device %02x:%02x.%x %04x:%04x", record.bus, record.device,
+                                        record.function, record.vendorId, record.deviceId);
+        };
+        stream.configHeaderDecoded = [this](const PciWire::DeviceRecord &record, const PciWire::u8 *header) {
+            const QByteArray bytes(reinterpret_cast<const char *>(header), int(PciWire::CONFIG_HEADER_SIZE));
+            events << QString::asprintf("header %02x:%02x.%x ", record.bus, record.device, record.function)
+                          + QString::fromLatin1(bytes.toHex());
+        };
+        stream.inventoryFinished = [this](size_t deviceCount) { events << QString("end %1").arg(deviceCount); };
+        stream.functionRemoved = [this](const PciWire::DeviceRecord &record) {
+            events << QString::asprintf("removed %02x:%02x.%x", record.bus, record.device, record.function);
+        };
+        stream.deltaFinished = [this](size_t changedCount, size_t removedCount) {
+            events << QString("delta %1 %2").arg(changedCount).arg(removedCount);
+        };
+        stream.heartbeatReceived = [this]() { events << "heartbeat"; };
+        stream.hostReceived = [this](const std::string &hostId) {
+            events << "host " + QString::fromStdString(hostId);
+        };
+    }
+
+    bool feed(const std::string &payload, size_t chunkSize = 0)
+    {
+        return feedChunks(payload.data(), qsizetype(payload.size()), qsizetype(chunkSize));
+    }
+
+    QString error() const { return QString::fromLatin1(stream.error() ? stream.error() : ""); }
+};
+
+class TestPciWireDecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void chunkBoundaries_data();
+    void chunkBoundaries();
+    void truncatedFrameWaitsForRest();
+    void rejectsBadHello_data();
+    void rejectsBadHello();
+    void rejectsOversizeFrame();
+    void rejectsBadRecordLength_data();
+    void rejectsBadRecordLength();
+
+private:
+    static std::string hello(PciWire::u8 version = PciWire::VERSION, PciWire::u8 flags = PciWire::FLAG_CONFIG_HEADERS);
+    static std::string frameHeader(PciWire::u32 length, PciWire::u8 type);
+    static std::string session();
+    static QStringList sessionEvents();
+};
+
+std::string TestPciWireDecoder::hello(PciWire::u8 version, PciWire::u8 flags)
+{
+    std::string out(PciWire::MAGIC, 4);
+    out.push_back(char(version));
+    out.push_back(char(flags));
+    return out;
+}
+
+std::string TestPciWireDecoder::frameHeader(PciWire::u32 length, PciWire::u8 type)
+{
+    std::string out;
+    PciWire::putU32(out, length);
+    out.push_back(char(type));
+    return out;
+}
+
+// Имя хоста, полная инвентаризация из двух кадров устройств с заголовками,
+// кадр неизвестного типа, изменения и сигнал «жив»
+std::string TestPciWireDecoder::session()
+{
+    PciWire::DeviceRecord records[3] = {
+        {0, 0, 0, 0x8086, 0x1237},
+        {0, 31, 7, 0x8086, 0x7000},
+        {2, 3, 1, 0x10DE, 0x1C82},
+    };
+    PciWire::u8 headers[3 * PciWire::CONFIG_HEADER_SIZE];
+    for (size_t i = 0; i < sizeof(headers); ++i) headers[i] = PciWire::u8(i);
+
+    std::string out = hello();
+    PciWire::appendHostFrame(out, "lab-pc-07");
+    PciWire::appendDevicesFrame(out, records, 2);
+    PciWire::appendConfigHeadersFrame(out, records, headers, 2);
+    out += frameHeader(3, 0x42) + "xyz";
+    PciWire::appendDevicesFrame(out, records + 2, 1);
+    PciWire::appendConfigHeadersFrame(out, records + 2, headers + 2 * PciWire::CONFIG_HEADER_SIZE, 1);
+    PciWire::appendEndFrame(out);
+
+    PciWire::DeviceRecord changed = {2, 3, 1, 0x10DE, 0x1C83};
+    PciWire::appendDevicesFrame(out, &changed, 1);
+    PciWire::appendRemovedFrame(out, records + 1, 1);
+    PciWire::appendDeltaEndFrame(out);
+    PciWire::appendHeartbeatFrame(out);
+    return out;
+}
+
+QStringList TestPciWireDecoder::sessionEvents()
+{
+    QByteArray headers(3 * int(PciWire::CONFIG_HEADER_SIZE), Qt::Uninitialized);
+    for (int i = 0; i < headers.size(); ++i) headers[i] = char(i);
+    const int size = int(PciWire::CONFIG_HEADER_SIZE);
+
+    return QStringList{
+        "hello 2 1",
+        "host lab-pc-07",
+        "start",
+        "device 00:00.0 8086:1237",
+        "device 00:1f.7 8086:7000",
+        "header 00:00.0 " + QString::fromLatin1(headers.mid(0, size).toHex()),
+        "header 00:1f.7 " + QString::fromLatin1(headers.mid(size, size).toHex()),
+        "device 02:03.1 10de:1c82",
+        "header 02:03.1 " + QString::fromLatin1(headers.mid(2 * size, size).toHex()),
+        "end 3",
+        "start",
+        "device 02:03.1 10de:1c83",
+        "removed 00:1f.7",
+        "delta 1 1",
+        "heartbeat",
+    };
+}
+
+void TestPciWireDecoder::chunkBoundaries_data()
+{
+    addChunkSizeRows();
+}
+
+void TestPciWireDecoder::chunkBoundaries()
+{
+    QFETCH(int, chunkSize);
+    DecoderLog log;
+    QVERIFY2(log.feed(session(), size_t(chunkSize)), qPrintable(log.error()));
+    QCOMPARE(log.events, sessionEvents());
+    QVERIFY(!log.stream.inInventory());
+}
+
+void TestPciWireDecoder::truncatedFrameWaitsForRest()
+{
+    const std::string payload = session();
+    // Обрыв внутри заголовка кадра и внутри данных кадра
+    for (size_t cut : {PciWire::HELLO_SIZE + 2, PciWire::HELLO_SIZE + PciWire::FRAME_HEADER_SIZE + 3}) {
+        DecoderLog log;
+        QVERIFY(log.feed(payload.substr(0, cut)));
+        QCOMPARE(log.events, QStringList({"hello 2 1"}));
+        QVERIFY(!log.stream.inInventory());
+        QVERIFY(log.feed(payload.substr(cut)));
+        QCOMPARE(log.events, sessionEvents());
+    }
+
+    // Соединение оборвалось до FRAME_END: инвентаризация не завершена
+    DecoderLog log;
+    QVERIFY(log.feed(payload.substr(0, payload.find(char(PciWire::FRAME_END), PciWire::HELLO_SIZE) - 4)));
+    QVERIFY(log.stream.inInventory());
+    QVERIFY(!log.events.contains("end 3"));
+}
+
+void TestPciWireDecoder::rejectsBadHello_data()
+{
+    QTest::addColumn<QByteArray>("payload");
+    QTest::newRow("bad magic") << QByteArray("PCIX\x02\x00", 6);
+    QTest::newRow("json") << QByteArray("[{\"bus\":0}]");
+    QTest::newRow("version 0") << QByteArray("PCIB\x00\x00", 6);
+    QTest::newRow("future version") << QByteArray("PCIB\x00\x00", 6).replace(4, 1, QByteArray(1, char(PciWire::VERSION + 1)));
+}
+
+void TestPciWireDecoder::rejectsBadHello()
+{
+    QFETCH(QByteArray, payload);
+    const std::string data(payload.constData(), size_t(payload.size()));
+    DecoderLog whole;
+    DecoderLog bytes;
+    QVERIFY(!whole.feed(data));
+    QVERIFY(!bytes.feed(data, 1));
+    QVERIFY(!whole.error().isEmpty());
+    QCOMPARE(bytes.error(), whole.error());
+    QVERIFY(whole.events.isEmpty());
+
+    // После ошибки декодер больше ничего не принимает
+    QVERIFY(!whole.feed(hello()));
+}
+
+void TestPciWireDecoder::rejectsOversizeFrame()
+{
+    // Ошибка сразу по заголовку кадра, данные не ждём и не копим
+    DecoderLog log;
+    QVERIFY(!log.feed(hello() + frameHeader(PciWire::MAX_FRAME_SIZE + 1, PciWire::FRAME_DEVICES), 1));
+    QCOMPARE(log.error(), QString("frame too large"));
+
+    // Кадр ровно предельного размера принимается
+    std::string payload = hello() + frameHeader(PciWire::MAX_FRAME_SIZE, 0x42);
+    payload.append(PciWire::MAX_FRAME_SIZE, '\0');
+    PciWire::appendHeartbeatFrame(payload);
+    DecoderLog largest;
+    QVERIFY2(largest.feed(payload, 64 * 1024), qPrintable(largest.error()));
+    QCOMPARE(largest.events, QStringList({"hello 2 1", "heartbeat"}));
+}
+
+void TestPciWireDecoder::rejectsBadRecordLength_data()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<int>("length");
+    QTest::addColumn<QString>("error");
+    QTest::newRow("devices") << int(PciWire::FRAME_DEVICES) << int(PciWire::DEVICE_RECORD_SIZE + 1)
+                             << "bad device frame";
+    QTest::newRow("config headers") << int(PciWire::FRAME_CONFIG_HEADERS) << int(PciWire::CONFIG_RECORD_SIZE - 1)
+                                    << "bad config header frame";
+    QTest::newRow("removed") << int(PciWire::FRAME_REMOVED) << int(PciWire::REMOVED_RECORD_SIZE * 2 + 2)
+                             << "bad removed frame";
+    QTest::newRow("empty host") << int(PciWire::FRAME_HOST) << 0 << "bad host frame";
+    QTest::newRow("long host") << int(PciWire::FRAME_HOST) << int(PciWire::MAX_HOST_ID_SIZE + 1)
+                               << "bad host frame";
+}
+
+void TestPciWireDecoder::rejectsBadRecordLength()
+{
+    QFETCH(int, type);
+    QFETCH(int, length);
+    QFETCH(QString, error);
+    const std::string payload = hello() + frameHeader(PciWire::u32(length), PciWire::u8(type))
+                                + std::string(size_t(length), '\x01');
+    DecoderLog whole;
+    DecoderLog bytes;
+    QVERIFY(!whole.feed(payload));
+    QVERIFY(!bytes.feed(payload, 1));
+    QCOMPARE(whole.error(), error);
+    QCOMPARE(bytes.events, whole.events);
+}
+
+QTEST_APPLESS_MAIN(TestPciWireDecoder)
+#include "tst_pciwiredecoder.moc"
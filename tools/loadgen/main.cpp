@@ -0,0 +1,604 @@
+// Нагрузка на серверы лабораторных 2 (PCI, порт 12345) и 3 (HDD, 12346).
+//   loadgen record --listen 22345 --target 127.0.0.1:12345 --out pci.cap [--sessions N] [--duration s]
+//   loadgen replay pci.cap [--target host[:port]] [--speed k] [--concurrency n] [--sessions N]
+//   loadgen synth pci|pci-binary|hdd [--devices n] [--seed s] [--ingest] [--out file.cap] [параметры replay]
+//   loadgen trace lcd_labs_trace.json [--filter regexp]
+// record — прокси между настоящим клиентом и сервером, записывает то, что
+// клиент отправил, с метками времени. replay воспроизводит записи с
+// ускорением speed (0 — без пауз) в concurrency соединений и печатает
+// пропускную способность, задержки подключения и сессий, а также время
+// разбора тех же данных кодом сервера. Время разбора на самом сервере —
+// из его трассы (LCD_LABS_TRACE) командой trace.
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include "common/IngestProtocol.h"
+#include "labs/lab2/PciStreamParser.h"
+#include "labs/lab2/PciWireFormat.h"
+
+static const quint32 CAPTURE_MAGIC = 0x5041434C; // "LCAP"
+static const quint32 CAPTURE_VERSION = 1;
+static const quint16 PCI_PORT = 12345;
+static const quint16 HDD_PORT = 12346;
+static const quint16 INGEST_PORT = 12340;
+// Сегмент TCP, которым синтетические данные отдаются серверу
+static const int CHUNK_SIZE = 1460;
+
+struct CaptureChunk {
+    qint64 offsetUs;
+    QByteArray data;
+};
+
+struct CaptureSession {
+    quint16 port = 0;
+    QList<CaptureChunk> chunks;
+
+    qint64 bytes() const
+    {
+        qint64 total = 0;
+        for (const CaptureChunk &chunk : chunks) total += chunk.data.size();
+        return total;
+    }
+};
+
+static int fail(const QString &message)
+{
+    std::fprintf(stderr, "loadgen: %s\n", qPrintable(message));
+    return 1;
+}
+
+static bool saveCapture(const QString &path, const QList<CaptureSession> &sessions)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << CAPTURE_MAGIC << CAPTURE_VERSION << quint32(sessions.size());
+    for (const CaptureSession &session : sessions) {
+        out << session.port << quint32(session.chunks.size());
+        for (const CaptureChunk &chunk : session.chunks) {
+            out << chunk.offsetUs << chunk.data;
+        }
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+static bool loadCapture(const QString &path, QList<CaptureSession> &sessions)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version >> count;
+    if (magic != CAPTURE_MAGIC || version != CAPTURE_VERSION) return false;
+
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        CaptureSession session;
+        quint32 chunks = 0;
+        in >> session.port >> chunks;
+        for (quint32 j = 0; j < chunks && in.status() == QDataStream::Ok; ++j) {
+            CaptureChunk chunk;
+            in >> chunk.offsetUs >> chunk.data;
+            session.chunks.append(chunk);
+        }
+        sessions.append(session);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+static void printPercentiles(const char *label, QList<double> values, const char *unit)
+{
+    if (values.isEmpty()) {
+        std::printf("%-24s no samples\n", label);
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&values](double q) { return values[qMin(values.size() - 1, qsizetype(q * values.size()))]; };
+    std::printf("%-24s p50 %9.2f  p95 %9.2f  p99 %9.2f  max %9.2f %s  (n=%lld)\n",
+                label, at(0.50), at(0.95), at(0.99), values.last(), unit, static_cast<long long>(values.size()));
+}
+
+// Синтетические данные в форматах настоящих клиентов
+
+static QList<CaptureChunk> splitIntoSegments(const QByteArray &payload)
+{
+    QList<CaptureChunk> chunks;
+    for (qsizetype offset = 0; offset < payload.size(); offset += CHUNK_SIZE) {
+        chunks.append({0, payload.mid(offset, CHUNK_SIZE)});
+    }
+    return chunks;
+}
+
+static std::vector<PciWire::DeviceRecord> randomPciDevices(QRandomGenerator &random, int count)
+{
+    static const PciWire::u16 vendors[] = {0x8086, 0x10DE, 0x1022, 0x10EC, 0x14E4, 0x15AD, 0x1AF4, 0x80EE};
+    std::vector<PciWire::DeviceRecord> devices;
+    devices.reserve(size_t(count));
+    for (int i = 0; i < count; ++i) {
+        PciWire::DeviceRecord record;
+        record.bus = PciWire::u8(i / 256);
+        record.device = PciWire::u8((i / 8) % 32);
+        record.function = PciWire::u8(i % 8);
+        record.vendorId = vendors[random.bounded(8)];
+        record.deviceId = PciWire::u16(random.bounded(0x10000));
+        devices.push_back(record);
+    }
+    return devices;
+}
+
+static CaptureSession synthPciJson(QRandomGenerator &random, int count)
+{
+    const auto devices = randomPciDevices(random, count);
+    QByteArray out("[");
+    char buf[128];
+    for (size_t i = 0; i < devices.size(); ++i) {
+        if (i) out.append(',');
+        const int n = std::snprintf(buf, sizeof(buf),
+                                    "{\"bus\":%u,\"device\":%u,\"function\":%u,"
+                                    "\"vendorID\":\"%04X\",\"deviceID\":\"%04X\"}",
+                                    unsigned(devices[i].bus), unsigned(devices[i].device),
+                                    unsigned(devices[i].function), unsigned(devices[i].vendorId),
+                                    unsigned(devices[i].deviceId));
+        out.append(buf, n);
+    }
+    out.append(']');
+    return {PCI_PORT, splitIntoSegments(out)};
+}
+
+static CaptureSession synthPciBinary(QRandomGenerator &random, int count)
+{
+    const auto devices = randomPciDevices(random, count);
+    std::vector<PciWire::u8> headers(devices.size() * PciWire::CONFIG_HEADER_SIZE);
+    for (PciWire::u8 &byte : headers) byte = PciWire::u8(random.bounded(256));
+
+    std::string out;
+    PciWire::appendHello(out, PciWire::FLAG_CONFIG_HEADERS);
+    PciWire::appendDevicesFrame(out, devices.data(), devices.size());
+    PciWire::appendConfigHeadersFrame(out, devices.data(), headers.data(), devices.size());
+    PciWire::appendEndFrame(out);
+
+    // Приветствие отдельным сегментом, как у сканера, который ждёт ответа
+    CaptureSession session{PCI_PORT, {}};
+    session.chunks.append({0, QByteArray(out.data(), qsizetype(PciWire::HELLO_SIZE))});
+    session.chunks.append(splitIntoSegments(QByteArray(out.data() + PciWire::HELLO_SIZE,
+                                                       qsizetype(out.size() - PciWire::HELLO_SIZE))));
+    return session;
+}
+
+static CaptureSession synthHdd(QRandomGenerator &random, int count)
+{
+    static const char *models[] = {"WDC WD10EZEX-08WN4A0", "ST1000DM010-2EP102", "Samsung SSD 860 EVO 500GB",
+                                   "TOSHIBA DT01ACA100", "KINGSTON SA400S37240G", "VBOX HARDDISK"};
+    QJsonArray drives;
+    for (int i = 0; i < count; ++i) {
+        const qint64 total = qint64(random.bounded(64, 4096)) * 1000 * 1000 * 1000;
+        const qint64 used = qint64(random.generateDouble() * total);
+        QJsonObject drive;
+        drive["index"] = i;
+        drive["model"] = models[random.bounded(6)];
+        drive["serial"] = QString::number(random.generate64(), 16).toUpper();
+        drive["firmware"] = QString("%1.%2").arg(random.bounded(10)).arg(random.bounded(100));
+        drive["interface"] = random.bounded(2) ? "SATA" : "NVMe";
+        drive["totalBytes"] = double(total);
+        drive["freeBytes"] = double(total - used);
+        drive["usedBytes"] = double(used);
+        drive["modes"] = QJsonArray{"PIO4", "UDMA6"};
+        drives.append(drive);
+    }
+    return {HDD_PORT, splitIntoSegments(QJsonDocument(drives).toJson(QJsonDocument::Compact))};
+}
+
+// Та же инвентаризация сообщением общего порта IngestService
+static CaptureSession wrapForIngest(const CaptureSession &session)
+{
+    QByteArray payload;
+    for (const CaptureChunk &chunk : session.chunks) payload.append(chunk.data);
+
+    Ingest::u16 kind = Ingest::KIND_HDD_JSON;
+    if (session.port == PCI_PORT) {
+        kind = payload.startsWith(PciWire::MAGIC[0]) ? Ingest::KIND_PCI_BINARY : Ingest::KIND_PCI_JSON;
+        if (kind == Ingest::KIND_PCI_BINARY) payload.remove(0, qsizetype(PciWire::HELLO_SIZE));
+    }
+
+    std::string out;
+    Ingest::appendHello(out);
+    Ingest::appendMessage(out, kind, payload.constData(), size_t(payload.size()));
+    return {INGEST_PORT, splitIntoSegments(QByteArray(out.data(), qsizetype(out.size())))};
+}
+
+// Время разбора сессии тем же кодом и теми же кусками, что на сервере, мкс
+static double serverParseTime(const CaptureSession &session)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (session.port == INGEST_PORT) {
+        // IngestService: сообщения целиком, затем разбор получателем
+        Ingest::Decoder decoder;
+        decoder.messageDecoded = [](Ingest::u16 kind, Ingest::u16, const Ingest::u8 *data, Ingest::u32 length) {
+            if (kind == Ingest::KIND_HDD_JSON) {
+                const QJsonDocument doc = QJsonDocument::fromJson(
+                    QByteArray::fromRawData(reinterpret_cast<const char *>(data), qsizetype(length)));
+                Q_UNUSED(doc)
+            } else if (kind == Ingest::KIND_PCI_BINARY) {
+                std::string hello;
+                PciWire::appendHello(hello, 0);
+                PciWire::Decoder pci;
+                pci.feed(hello.data(), hello.size());
+                pci.feed(reinterpret_cast<const char *>(data), length);
+            } else {
+                PciStreamParser parser;
+                parser.feed(reinterpret_cast<const char *>(data), qsizetype(length));
+            }
+        };
+        for (const CaptureChunk &chunk : session.chunks) {
+            decoder.feed(chunk.data.constData(), size_t(chunk.data.size()));
+        }
+    } else if (session.port == HDD_PORT) {
+        // HddIngestWorker: копит буфер до ']' и разбирает его QJsonDocument
+        QByteArray buffer;
+        for (const CaptureChunk &chunk : session.chunks) {
+            buffer.append(chunk.data);
+            if (buffer.contains(']')) {
+                const qsizetype end = buffer.lastIndexOf(']');
+                const QJsonDocument doc = QJsonDocument::fromJson(buffer.left(end + 1));
+                Q_UNUSED(doc)
+                buffer = buffer.mid(end + 1);
+            }
+        }
+    } else {
+        const bool binary = !session.chunks.isEmpty() && session.chunks.first().data.startsWith(PciWire::MAGIC[0]);
+        PciStreamParser parser;
+        PciWire::Decoder decoder;
+        for (const CaptureChunk &chunk : session.chunks) {
+            if (binary) {
+                decoder.feed(chunk.data.constData(), size_t(chunk.data.size()));
+            } else {
+                parser.feed(chunk.data);
+            }
+        }
+    }
+    return timer.nsecsElapsed() / 1e3;
+}
+
+// Прокси для записи: клиент -> listen -> target
+class Recorder : public QObject
+{
+public:
+    Recorder(const QString &host, quint16 port, int maxSessions, const QString &output)
+        : m_host(host), m_port(port), m_maxSessions(maxSessions), m_output(output)
+    {
+        connect(&m_server, &QTcpServer::newConnection, this, &Recorder::onNewConnection);
+    }
+
+    bool listen(quint16 port) { return m_server.listen(QHostAddress::Any, port); }
+
+    void finish()
+    {
+        if (m_finished) return;
+        m_finished = true;
+
+        if (!saveCapture(m_output, m_sessions)) {
+            fail(QString("cannot write %1").arg(m_output));
+            QCoreApplication::exit(1);
+            return;
+        }
+        std::printf("recorded %lld sessions to %s\n", static_cast<long long>(m_sessions.size()),
+                    qPrintable(m_output));
+        QCoreApplication::quit();
+    }
+
+private:
+    void onNewConnection()
+    {
+        while (m_server.hasPendingConnections()) {
+            QTcpSocket *client = m_server.nextPendingConnection();
+            auto upstream = new QTcpSocket(client);
+            auto clock = std::make_shared<QElapsedTimer>();
+            auto session = std::make_shared<CaptureSession>();
+            auto pending = std::make_shared<QByteArray>();
+            clock->start();
+            session->port = m_port;
+
+            connect(client, &QTcpSocket::readyRead, this, [=]() {
+                const QByteArray data = client->readAll();
+                session->chunks.append({clock->nsecsElapsed() / 1000, data});
+                if (upstream->state() == QAbstractSocket::ConnectedState) {
+                    upstream->write(data);
+                } else {
+                    pending->append(data);
+                }
+            });
+            connect(upstream, &QTcpSocket::connected, this, [=]() {
+                upstream->write(*pending);
+                pending->clear();
+            });
+            // Ответы сервера (подтверждение двоичного протокола) идут клиенту, но не пишутся
+            connect(upstream, &QTcpSocket::readyRead, this, [=]() { client->write(upstream->readAll()); });
+            connect(upstream, &QTcpSocket::disconnected, client, &QTcpSocket::disconnectFromHost);
+            connect(client, &QTcpSocket::disconnected, this, [=]() {
+                upstream->disconnectFromHost();
+                client->deleteLater();
+                if (!session->chunks.isEmpty()) {
+                    m_sessions.append(*session);
+                    std::printf("session %lld: %lld bytes in %lld chunks\n",
+                                static_cast<long long>(m_sessions.size()),
+                                static_cast<long long>(session->bytes()),
+                                static_cast<long long>(session->chunks.size()));
+                }
+                if (m_maxSessions > 0 && m_sessions.size() >= m_maxSessions) finish();
+            });
+
+            upstream->connectToHost(m_host, m_port);
+        }
+    }
+
+    QTcpServer m_server;
+    QString m_host;
+    quint16 m_port;
+    int m_maxSessions;
+    QString m_output;
+    QList<CaptureSession> m_sessions;
+    bool m_finished = false;
+};
+
+// Воспроизведение записей в concurrency параллельных соединений
+class Replayer : public QObject
+{
+public:
+    Replayer(const QList<CaptureSession> &sessions, const QString &host, quint16 port,
+             double speed, int concurrency, int total)
+        : m_sessions(sessions), m_host(host), m_port(port), m_speed(speed)
+        , m_concurrency(concurrency), m_total(total)
+    {
+    }
+
+    void start()
+    {
+        m_wallClock.start();
+        for (int i = 0; i < m_concurrency && m_started < m_total; ++i) {
+            launch();
+        }
+    }
+
+private:
+    void launch()
+    {
+        const CaptureSession &session = m_sessions[m_started % m_sessions.size()];
+        ++m_started;
+
+        auto socket = new QTcpSocket(this);
+        auto clock = std::make_shared<QElapsedTimer>();
+        auto remaining = std::make_shared<qint64>(session.bytes());
+        auto finished = std::make_shared<bool>(false);
+        clock->start();
+
+        auto complete = [=](bool ok) {
+            if (*finished) return;
+            *finished = true;
+            if (ok) {
+                m_sessionLatency.append(clock->nsecsElapsed() / 1e6);
+                ++m_succeeded;
+            } else {
+                ++m_failed;
+            }
+            socket->disconnect(this);
+            socket->abort();
+            socket->deleteLater();
+
+            if (m_started < m_total) {
+                launch();
+            } else if (m_succeeded + m_failed == m_total) {
+                report();
+            }
+        };
+
+        connect(socket, &QTcpSocket::connected, this, [=, &session]() {
+            m_connectLatency.append(clock->nsecsElapsed() / 1e6);
+            for (const CaptureChunk &chunk : session.chunks) {
+                const qint64 delayMs = m_speed > 0 ? qint64(chunk.offsetUs / m_speed / 1000) : 0;
+                if (delayMs == 0) {
+                    socket->write(chunk.data);
+                } else {
+                    const QByteArray data = chunk.data;
+                    QTimer::singleShot(delayMs, socket, [socket, data]() { socket->write(data); });
+                }
+            }
+        });
+        connect(socket, &QTcpSocket::bytesWritten, this, [=](qint64 bytes) {
+            m_bytesSent += bytes;
+            *remaining -= bytes;
+            // Всё ушло в ядро: сессия клиента закончена
+            if (*remaining <= 0 && socket->bytesToWrite() == 0) complete(true);
+        });
+        // Подтверждение двоичного протокола не нужно: данные уже записаны
+        connect(socket, &QTcpSocket::readyRead, this, [socket]() { socket->readAll(); });
+        connect(socket, &QTcpSocket::errorOccurred, this, [=](QAbstractSocket::SocketError error) {
+            if (m_failed == 0) {
+                std::fprintf(stderr, "loadgen: %s\n", qPrintable(socket->errorString()));
+            }
+            Q_UNUSED(error)
+            complete(false);
+        });
+
+        socket->connectToHost(m_host, m_port ? m_port : session.port);
+    }
+
+    void report()
+    {
+        const double seconds = m_wallClock.nsecsElapsed() / 1e9;
+        std::printf("sessions   %d ok, %d failed in %.2f s\n", m_succeeded, m_failed, seconds);
+        std::printf("throughput %.2f MB/s, %.1f sessions/s, %lld bytes\n",
+                    m_bytesSent / 1e6 / seconds, m_succeeded / seconds, static_cast<long long>(m_bytesSent));
+        printPercentiles("connect latency", m_connectLatency, "ms");
+        printPercentiles("session latency", m_sessionLatency, "ms");
+
+        QList<double> parse;
+        for (const CaptureSession &session : std::as_const(m_sessions)) {
+            parse.append(serverParseTime(session));
+        }
+        printPercentiles("parse (server code)", parse, "us");
+
+        QCoreApplication::exit(m_failed == 0 ? 0 : 2);
+    }
+
+    QList<CaptureSession> m_sessions;
+    QString m_host;
+    quint16 m_port;
+    double m_speed;
+    int m_concurrency;
+    int m_total;
+    int m_started = 0;
+    int m_succeeded = 0;
+    int m_failed = 0;
+    qint64 m_bytesSent = 0;
+    QElapsedTimer m_wallClock;
+    QList<double> m_connectLatency;
+    QList<double> m_sessionLatency;
+};
+
+// Длительности complete-событий из трассы сервера, сгруппированные по имени
+static int summarizeTrace(const QString &path, const QString &filter)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return fail(QString("cannot read %1").arg(path));
+
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    const QRegularExpression pattern(filter);
+    QMap<QString, QList<double>> durations;
+    for (const QJsonValue &value : doc.object()["traceEvents"].toArray()) {
+        const QJsonObject event = value.toObject();
+        if (event["ph"].toString() != "X") continue;
+        const QString name = event["name"].toString();
+        if (pattern.match(name).hasMatch()) durations[name].append(event["dur"].toDouble());
+    }
+    if (durations.isEmpty()) return fail(QString("no events match %1").arg(filter));
+
+    for (auto it = durations.cbegin(); it != durations.cend(); ++it) {
+        printPercentiles(qPrintable(it.key()), it.value(), "us");
+    }
+    return 0;
+}
+
+static bool parseTarget(const QString &text, QString &host, quint16 &port)
+{
+    const qsizetype colon = text.lastIndexOf(':');
+    if (colon < 0) {
+        host = text;
+        return true;
+    }
+    bool ok = false;
+    host = text.left(colon);
+    port = text.mid(colon + 1).toUShort(&ok);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "record, replay, synth or trace");
+    parser.addOptions({
+        {"listen", "record: port to accept clients on", "port", "22345"},
+        {"target", "server address, host[:port]", "address", "127.0.0.1"},
+        {"out", "capture file to write", "file"},
+        {"speed", "replay speed factor, 0 = no pauses", "factor", "0"},
+        {"concurrency", "parallel connections", "n", "16"},
+        {"sessions", "sessions to replay or record", "n", "0"},
+        {"duration", "record: stop after seconds", "s", "0"},
+        {"devices", "synth: devices per inventory", "n", "256"},
+        {"seed", "synth: random seed", "s", "1"},
+        {"ingest", "synth: send through the shared ingest port"},
+        {"filter", "trace: event name regexp", "regexp", "readSession|parseHddData|onHostsUpdated|publish"},
+    });
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.isEmpty()) parser.showHelp(1);
+    const QString command = args.first();
+
+    QString host;
+    quint16 port = 0;
+    if (!parseTarget(parser.value("target"), host, port)) {
+        return fail(QString("bad target %1").arg(parser.value("target")));
+    }
+
+    if (command == "trace") {
+        if (args.size() < 2) return fail("trace: trace file expected");
+        return summarizeTrace(args[1], parser.value("filter"));
+    }
+
+    if (command == "record") {
+        if (!parser.isSet("out")) return fail("record: --out expected");
+        Recorder recorder(host, port ? port : PCI_PORT, parser.value("sessions").toInt(), parser.value("out"));
+        if (!recorder.listen(parser.value("listen").toUShort())) {
+            return fail(QString("cannot listen on %1").arg(parser.value("listen")));
+        }
+        const int duration = parser.value("duration").toInt();
+        if (duration > 0) {
+            QTimer::singleShot(duration * 1000, &recorder, [&recorder]() { recorder.finish(); });
+        }
+        std::printf("recording: clients -> :%s -> %s:%u\n", qPrintable(parser.value("listen")),
+                    qPrintable(host), unsigned(port ? port : PCI_PORT));
+        return app.exec();
+    }
+
+    QList<CaptureSession> sessions;
+    if (command == "replay") {
+        if (args.size() < 2) return fail("replay: capture file expected");
+        if (!loadCapture(args[1], sessions) || sessions.isEmpty()) {
+            return fail(QString("cannot load capture %1").arg(args[1]));
+        }
+    } else if (command == "synth") {
+        const QString kind = args.value(1, "pci");
+        const int devices = qMax(1, parser.value("devices").toInt());
+        QRandomGenerator random(parser.value("seed").toUInt());
+        // Несколько разных инвентаризаций, чтобы сервер не видел одно и то же
+        for (int i = 0; i < 16; ++i) {
+            if (kind == "pci") {
+                sessions.append(synthPciJson(random, devices));
+            } else if (kind == "pci-binary") {
+                sessions.append(synthPciBinary(random, devices));
+            } else if (kind == "hdd") {
+                sessions.append(synthHdd(random, devices));
+            } else {
+                return fail(QString("unknown payload kind %1").arg(kind));
+            }
+            if (parser.isSet("ingest")) sessions.last() = wrapForIngest(sessions.last());
+        }
+        if (parser.isSet("out")) {
+            if (!saveCapture(parser.value("out"), sessions)) {
+                return fail(QString("cannot write %1").arg(parser.value("out")));
+            }
+            return 0;
+        }
+    } else {
+        return fail(QString("unknown command %1").arg(command));
+    }
+
+    const int total = parser.value("sessions").toInt() > 0 ? parser.value("sessions").toInt() : sessions.size();
+    Replayer replayer(sessions, host, port, parser.value("speed").toDouble(),
+                      qMax(1, parser.value("concurrency").toInt()), total);
+    QTimer::singleShot(0, &replayer, &Replayer::start);
+    return app.exec();
+}
@@ -0,0 +1,244 @@
+// Компиляция pci.ids в двоичную базу для PciIdDatabase.
+// pciids <pci.ids> <pciids.bin>
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QSaveFile>
+#include <cstdio>
+#include <vector>
+#include "labs/lab2/PciIdsFormat.h"
+
+using namespace PciIds;
+
+static void fail(const QString &message)
+{
+    std::fprintf(stderr, "pciids: %s\n", qPrintable(message));
+}
+
+// Пул строк с повторным использованием одинаковых имён
+class StringPool
+{
+public:
+    StringPool() { m_data.append('\0'); }
+
+    u32 add(const QByteArray &text)
+    {
+        if (text.isEmpty()) return 0;
+        auto it = m_offsets.constFind(text);
+        if (it != m_offsets.constEnd()) return it.value();
+
+        const u32 offset = u32(m_data.size());
+        m_data.append(text);
+        m_data.append('\0');
+        m_offsets.insert(text, offset);
+        return offset;
+    }
+
+    const QByteArray &data() const { return m_data; }
+
+private:
+    QByteArray m_data;
+    QHash<QByteArray, u32> m_offsets;
+};
+
+struct Entry {
+    u64 key;
+    u32 name;
+};
+
+static std::vector<Slot> buildTable(const QList<Entry> &entries, u32 &mask)
+{
+    u32 size = 16;
+    while (size < u32(entries.size()) * 2) size <<= 1;
+    mask = size - 1;
+
+    std::vector<Slot> table(size);
+    memset(table.data(), 0, table.size() * sizeof(Slot));
+    for (const Entry &entry : entries) {
+        u32 i = slotFor(entry.key, mask);
+        while (table[i].name != 0 && table[i].key != entry.key) i = (i + 1) & mask;
+        table[i].key = entry.key;
+        table[i].name = entry.name;
+    }
+    return table;
+}
+
+static bool parseHex(const QByteArray &text, int digits, u32 &value)
+{
+    if (text.size() < digits) return false;
+    bool ok = false;
+    value = text.left(digits).toUInt(&ok, 16);
+    return ok;
+}
+
+template <typename T>
+static void append(QByteArray &out, const T &value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() != 3) {
+        std::fprintf(stderr, "usage: pciids <pci.ids> <pciids.bin>\n");
+        return 2;
+    }
+
+    QFile input(args[1]);
+    if (!input.open(QIODevice::ReadOnly)) {
+        fail(QString("cannot open %1").arg(args[1]));
+        return 1;
+    }
+
+    StringPool strings;
+    std::vector<u32> vendors(DIRECT_TABLE_SIZE, 0);
+    std::vector<u32> classes(256, 0);
+    std::vector<u32> subclasses(DIRECT_TABLE_SIZE, 0);
+    QList<Entry> devices;
+    QList<Entry> subsystems;
+    QList<Entry> progIfs;
+    QByteArray sourceVersion;
+    u32 vendorCount = 0;
+    u32 classCount = 0;
+
+    // Текущий контекст: производитель и устройство либо класс и подкласс
+    bool inClasses = false;
+    u32 vendor = 0;
+    u32 device = 0;
+    bool haveVendor = false;
+    bool haveDevice = false;
+    u32 classCode = 0;
+    u32 subclass = 0;
+    bool haveSubclass = false;
+    int lineNumber = 0;
+
+    while (!input.atEnd()) {
+        QByteArray line = input.readLine();
+        ++lineNumber;
+        while (line.endsWith('\n') || line.endsWith('\r')) line.chop(1);
+
+        if (line.startsWith("#")) {
+            const int at = line.indexOf("Version:");
+            if (at >= 0 && sourceVersion.isEmpty()) sourceVersion = line.mid(at + 8).trimmed();
+            continue;
+        }
+        if (line.trimmed().isEmpty()) continue;
+
+        int tabs = 0;
+        while (tabs < line.size() && line[tabs] == '\t') ++tabs;
+        const QByteArray body = line.mid(tabs);
+        u32 id = 0;
+
+        if (tabs == 0) {
+            haveDevice = false;
+            haveSubclass = false;
+            if (body.startsWith("C ")) {
+                inClasses = true;
+                haveVendor = false;
+                if (!parseHex(body.mid(2), 2, classCode)) continue;
+                classes[classCode] = strings.add(body.mid(4).trimmed());
+                ++classCount;
+            } else if (parseHex(body, 4, id) && body.size() > 4 && body[4] == ' ') {
+                inClasses = false;
+                vendor = id;
+                haveVendor = true;
+                vendors[vendor] = strings.add(body.mid(4).trimmed());
+                ++vendorCount;
+            } else {
+                // Прочие разделы (например, языки USB) не нужны
+                inClasses = false;
+                haveVendor = false;
+            }
+        } else if (tabs == 1) {
+            if (inClasses) {
+                if (!parseHex(body, 2, subclass)) continue;
+                subclasses[(classCode << 8) | subclass] = strings.add(body.mid(2).trimmed());
+                haveSubclass = true;
+            } else if (haveVendor && parseHex(body, 4, device)) {
+                devices.append({deviceKey(u16(vendor), u16(device)), strings.add(body.mid(4).trimmed())});
+                haveDevice = true;
+            }
+        } else if (tabs == 2) {
+            if (inClasses && haveSubclass) {
+                u32 progIf = 0;
+                if (!parseHex(body, 2, progIf)) continue;
+                progIfs.append({progIfKey(u8(classCode), u8(subclass), u8(progIf)), strings.add(body.mid(2).trimmed())});
+            } else if (haveDevice) {
+                u32 subvendor = 0;
+                u32 subdevice = 0;
+                if (!parseHex(body, 4, subvendor) || !parseHex(body.mid(5), 4, subdevice)) {
+                    fail(QString("%1:%2: bad subsystem line").arg(args[1]).arg(lineNumber));
+                    continue;
+                }
+                subsystems.append({subsystemKey(u16(vendor), u16(device), u16(subvendor), u16(subdevice)),
+                                   strings.add(body.mid(9).trimmed())});
+            }
+        }
+    }
+
+    if (vendorCount == 0) {
+        fail(QString("%1: no vendors found").arg(args[1]));
+        return 1;
+    }
+
+    u32 deviceMask = 0;
+    u32 subsystemMask = 0;
+    u32 progIfMask = 0;
+    const std::vector<Slot> deviceTable = buildTable(devices, deviceMask);
+    const std::vector<Slot> subsystemTable = buildTable(subsystems, subsystemMask);
+    const std::vector<Slot> progIfTable = buildTable(progIfs, progIfMask);
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    u32 offset = sizeof(Header);
+    header.vendorTable = offset;
+    offset += DIRECT_TABLE_SIZE * 4;
+    header.classTable = offset;
+    offset += 256 * 4;
+    header.subclassTable = offset;
+    offset += DIRECT_TABLE_SIZE * 4;
+    header.deviceTable = offset;
+    header.deviceMask = deviceMask;
+    offset += u32(deviceTable.size() * sizeof(Slot));
+    header.subsystemTable = offset;
+    header.subsystemMask = subsystemMask;
+    offset += u32(subsystemTable.size() * sizeof(Slot));
+    header.progIfTable = offset;
+    header.progIfMask = progIfMask;
+    offset += u32(progIfTable.size() * sizeof(Slot));
+    header.strings = offset;
+    header.stringsSize = u32(strings.data().size());
+    header.vendorCount = vendorCount;
+    header.deviceCount = u32(devices.size());
+    header.subsystemCount = u32(subsystems.size());
+    header.classCount = classCount;
+    qstrncpy(header.sourceVersion, sourceVersion.constData(), sizeof(header.sourceVersion));
+
+    QByteArray out;
+    out.reserve(offset + header.stringsSize);
+    append(out, header);
+    out.append(reinterpret_cast<const char *>(vendors.data()), int(vendors.size() * 4));
+    out.append(reinterpret_cast<const char *>(classes.data()), int(classes.size() * 4));
+    out.append(reinterpret_cast<const char *>(subclasses.data()), int(subclasses.size() * 4));
+    out.append(reinterpret_cast<const char *>(deviceTable.data()), int(deviceTable.size() * sizeof(Slot)));
+    out.append(reinterpret_cast<const char *>(subsystemTable.data()), int(subsystemTable.size() * sizeof(Slot)));
+    out.append(reinterpret_cast<const char *>(progIfTable.data()), int(progIfTable.size() * sizeof(Slot)));
+    out.append(strings.data());
+
+    QSaveFile output(args[2]);
+    if (!output.open(QIODevice::WriteOnly) || output.write(out) != out.size() || !output.commit()) {
+        fail(QString("cannot write %1").arg(args[2]));
+        return 1;
+    }
+
+    std::printf("pciids: %u vendors, %u devices, %u subsystems, %u classes, %lld bytes (%s)\n",
+                vendorCount, header.deviceCount, header.subsystemCount, classCount,
+                static_cast<long long>(out.size()),
+                sourceVersion.isEmpty() ? "unknown version" : sourceVersion.constData());
+    return 0;
+}
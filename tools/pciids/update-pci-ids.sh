@@ -0,0 +1,11 @@
+#!/bin/sh
+# Обновляет закреплённый снимок resources/pci.ids с pci-ids.ucw.cz.
+# Снимок коммитится вместе с изменением, версия — в его строке "# Version:"
+set -eu
+
+root=$(cd "$(dirname "$0")/../.." && pwd)
+target="$root/resources/pci.ids"
+
+curl -fsSL -o "$target.part" https://pci-ids.ucw.cz/v2.2/pci.ids
+mv "$target.part" "$target"
+grep -m1 '^#[[:space:]]*Version:' "$target"
@@ -0,0 +1,158 @@
+// Сравнение JSON и двоичного протокола сканера PCI: байты в сети и время
+// разбора на сервере. pciwirebench [число устройств ...]
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <cstdio>
+#include "labs/lab2/PciStreamParser.h"
+#include "labs/lab2/PciWireFormat.h"
+
+// Сегмент TCP, которым данные приходят в readyRead
+static const int CHUNK_SIZE = 1460;
+
+static std::vector<PciWire::DeviceRecord> makeDevices(int count)
+{
+    static const PciWire::u16 vendors[] = {0x8086, 0x10DE, 0x1022, 0x10EC, 0x14E4, 0x15AD};
+    std::vector<PciWire::DeviceRecord> devices(size_t(count));
+    for (int i = 0; i < count; ++i) {
+        devices[i].bus = PciWire::u8(i / 256);
+        devices[i].device = PciWire::u8((i / 8) % 32);
+        devices[i].function = PciWire::u8(i % 8);
+        devices[i].vendorId = vendors[i % 6];
+        devices[i].deviceId = PciWire::u16(0x1000 + i * 7);
+    }
+    return devices;
+}
+
+// Тот же формат, что у createJsonFromVector в сканере
+static QByteArray encodeJson(const std::vector<PciWire::DeviceRecord> &devices)
+{
+    QByteArray out;
+    out.reserve(qsizetype(devices.size()) * 80 + 2);
+    out.append('[');
+    char buf[128];
+    for (size_t i = 0; i < devices.size(); ++i) {
+        if (i) out.append(',');
+        const int n = std::snprintf(buf, sizeof(buf),
+                                    "{\"bus\":%u,\"device\":%u,\"function\":%u,"
+                                    "\"vendorID\":\"%04X\",\"deviceID\":\"%04X\"}",
+                                    unsigned(devices[i].bus), unsigned(devices[i].device),
+                                    unsigned(devices[i].function), unsigned(devices[i].vendorId),
+                                    unsigned(devices[i].deviceId));
+        out.append(buf, n);
+    }
+    out.append(']');
+    return out;
+}
+
+static QByteArray encodeBinary(const std::vector<PciWire::DeviceRecord> &devices)
+{
+    std::string out;
+    PciWire::appendHello(out, 0);
+    PciWire::appendDevicesFrame(out, devices.data(), devices.size());
+    PciWire::appendEndFrame(out);
+    return QByteArray(out.data(), qsizetype(out.size()));
+}
+
+// Старый путь: буфер целиком заново через QJsonDocument на каждый сегмент
+static int decodeJsonDom(const QByteArray &payload)
+{
+    QByteArray buffer;
+    int count = 0;
+    for (qsizetype offset = 0; offset < payload.size(); offset += CHUNK_SIZE) {
+        buffer.append(payload.mid(offset, CHUNK_SIZE));
+        const QJsonDocument doc = QJsonDocument::fromJson(buffer);
+        if (!doc.isArray()) continue;
+        for (const QJsonValue &value : doc.array()) {
+            const QJsonObject obj = value.toObject();
+            PciDevice device;
+            device.bus = obj["bus"].toInt();
+            device.device = obj["device"].toInt();
+            device.function = obj["function"].toInt();
+            device.vendorId = quint16(obj["vendorID"].toString().toUInt(nullptr, 16));
+            device.deviceId = quint16(obj["deviceID"].toString().toUInt(nullptr, 16));
+            ++count;
+        }
+    }
+    return count;
+}
+
+static int decodeJsonStream(const QByteArray &payload)
+{
+    int count = 0;
+    PciStreamParser parser;
+    parser.deviceParsed = [&count](const PciDevice &) { ++count; };
+    for (qsizetype offset = 0; offset < payload.size(); offset += CHUNK_SIZE) {
+        parser.feed(payload.constData() + offset, qMin<qsizetype>(CHUNK_SIZE, payload.size() - offset));
+    }
+    return count;
+}
+
+static int decodeBinary(const QByteArray &payload)
+{
+    int count = 0;
+    PciWire::Decoder decoder;
+    decoder.deviceDecoded = [&count](const PciWire::DeviceRecord &record) {
+        // Как на сервере: в PciDevice
+        PciDevice device;
+        device.bus = record.bus;
+        device.device = record.device;
+        device.function = record.function;
+        device.vendorId = record.vendorId;
+        device.deviceId = record.deviceId;
+        ++count;
+    };
+    for (qsizetype offset = 0; offset < payload.size(); offset += CHUNK_SIZE) {
+        decoder.feed(payload.constData() + offset, size_t(qMin<qsizetype>(CHUNK_SIZE, payload.size() - offset)));
+    }
+    return count;
+}
+
+// Среднее время одного разбора в микросекундах; крутим не меньше 200 мс
+template <typename Decode>
+static double measure(Decode decode, const QByteArray &payload, int expected)
+{
+    QElapsedTimer timer;
+    timer.start();
+    int runs = 0;
+    do {
+        if (decode(payload) != expected) {
+            std::fprintf(stderr, "pciwirebench: decoded device count mismatch\n");
+            return -1;
+        }
+        ++runs;
+    } while (timer.nsecsElapsed() < 200 * 1000 * 1000);
+    return timer.nsecsElapsed() / 1e3 / runs;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QList<int> counts;
+    for (const QString &arg : app.arguments().mid(1)) {
+        if (arg.toInt() > 0) counts.append(arg.toInt());
+    }
+    if (counts.isEmpty()) counts = {32, 256, 2048, 16384};
+
+    std::printf("%8s %10s %10s %6s %12s %12s %12s\n",
+                "devices", "json B", "binary B", "ratio", "json dom us", "json strm us", "binary us");
+    for (int count : std::as_const(counts)) {
+        const auto devices = makeDevices(count);
+        const QByteArray json = encodeJson(devices);
+        const QByteArray binary = encodeBinary(devices);
+
+        // Квадратичный старый путь на больших списках занимает минуты
+        const double dom = count <= 4096 ? measure(decodeJsonDom, json, count) : -1;
+        const double stream = measure(decodeJsonStream, json, count);
+        const double bin = measure(decodeBinary, binary, count);
+
+        std::printf("%8d %10lld %10lld %5.1fx %12.1f %12.1f %12.1f\n",
+                    count, static_cast<long long>(json.size()), static_cast<long long>(binary.size()),
+                    double(json.size()) / binary.size(), dom, stream, bin);
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Упаковка листов спрайтов в один атлас во время сборки.
+// spritepack <sprites.json> <каталог ресурсов> <atlas.png> <SpriteAtlasData.h>
+#include <QCoreApplication>
+#include <QFile>
+#include <QDir>
+#include <QImage>
+#include <QPainter>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdio>
+
+struct PackedFrame {
+    int sheet;
+    QRect source;
+    QRect target;
+};
+
+struct PackedSheet {
+    QString name;
+    QImage image;
+    int firstFrame;
+    int frameCount;
+};
+
+static bool fail(const QString &message)
+{
+    std::fprintf(stderr, "spritepack: %s\n", qPrintable(message));
+    return false;
+}
+
+static bool loadSheets(const QJsonArray &array, const QDir &root,
+                       QList<PackedSheet> &sheets, QList<PackedFrame> &frames)
+{
+    for (const QJsonValue &value : array) {
+        const QJsonObject obj = value.toObject();
+        PackedSheet sheet;
+        sheet.name = obj["name"].toString();
+        sheet.image = QImage(root.filePath(obj["file"].toString())).convertToFormat(QImage::Format_ARGB32);
+        if (sheet.image.isNull()) {
+            return fail(QString("cannot load %1").arg(obj["file"].toString()));
+        }
+
+        const int frameHeight = obj["frameHeight"].toInt(sheet.image.height());
+        const QJsonArray widths = obj["frames"].toArray();
+        sheet.firstFrame = frames.size();
+        sheet.frameCount = widths.size();
+
+        int x = 0;
+        for (const QJsonValue &w : widths) {
+            PackedFrame frame;
+            frame.sheet = sheets.size();
+            frame.source = QRect(x, 0, w.toInt(), frameHeight);
+            x += w.toInt();
+            frames.append(frame);
+        }
+        if (x > sheet.image.width() || frameHeight > sheet.image.height()) {
+            return fail(QString("frames of %1 exceed the sheet size").arg(sheet.name));
+        }
+        sheets.append(sheet);
+    }
+    return true;
+}
+
+// Полочная упаковка: кадры по убыванию высоты раскладываются рядами
+static int packFrames(QList<PackedFrame> &frames, int atlasWidth, int padding)
+{
+    QList<int> order(frames.size());
+    for (int i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&frames](int a, int b) {
+        return frames[a].source.height() > frames[b].source.height();
+    });
+
+    int x = padding;
+    int y = padding;
+    int shelfHeight = 0;
+    for (int index : order) {
+        PackedFrame &frame = frames[index];
+        if (x + frame.source.width() + padding > atlasWidth) {
+            x = padding;
+            y += shelfHeight + padding;
+            shelfHeight = 0;
+        }
+        frame.target = QRect(QPoint(x, y), frame.source.size());
+        x += frame.source.width() + padding;
+        shelfHeight = qMax(shelfHeight, frame.source.height());
+    }
+    return y + shelfHeight + padding;
+}
+
+static bool writeHeader(const QString &path, const QList<PackedSheet> &sheets,
+                        const QList<PackedFrame> &frames, const QSize &atlasSize)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        return fail(QString("cannot write %1").arg(path));
+    }
+
+    QTextStream out(&file);
+    out << "// Сгенерировано spritepack из resources/sprites.json, не редактировать\n"
+        << "#ifndef SPRITEATLASDATA_H\n"
+        << "#define SPRITEATLASDATA_H\n\n"
+        << "namespace SpriteAtlas {\n\n"
+        << "struct Frame { int x; int y; int width; int height; };\n"
+        << "struct Sheet { const char *name; int firstFrame; int frameCount; };\n\n"
+        << "inline constexpr char atlasPath[] = \":/atlas/atlas.png\";\n"
+        << "inline constexpr int atlasWidth = " << atlasSize.width() << ";\n"
+        << "inline constexpr int atlasHeight = " << atlasSize.height() << ";\n\n"
+        << "inline constexpr Frame frames[] = {\n";
+    for (const PackedFrame &frame : frames) {
+        out << "    { " << frame.target.x() << ", " << frame.target.y() << ", "
+            << frame.target.width() << ", " << frame.target.height() << " },\n";
+    }
+    out << "};\n\n"
+        << "inline constexpr Sheet sheets[] = {\n";
+    for (const PackedSheet &sheet : sheets) {
+        out << "    { \"" << sheet.name << "\", " << sheet.firstFrame << ", " << sheet.frameCount << " },\n";
+    }
+    out << "};\n\n"
+        << "inline constexpr int sheetCount = " << sheets.size() << ";\n\n"
+        << "} // namespace SpriteAtlas\n\n"
+        << "#endif // SPRITEATLASDATA_H\n";
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() != 5) {
+        fail("usage: spritepack <sprites.json> <resources dir> <atlas.png> <header.h>");
+        return 1;
+    }
+
+    QFile manifestFile(args[1]);
+    if (!manifestFile.open(QIODevice::ReadOnly)) {
+        fail(QString("cannot open %1").arg(args[1]));
+        return 1;
+    }
+    const QJsonObject manifest = QJsonDocument::fromJson(manifestFile.readAll()).object();
+    const int atlasWidth = manifest["atlasWidth"].toInt(1024);
+    const int padding = manifest["padding"].toInt(2);
+
+    QList<PackedSheet> sheets;
+    QList<PackedFrame> frames;
+    if (!loadSheets(manifest["sheets"].toArray(), QDir(args[2]), sheets, frames)) {
+        return 1;
+    }
+
+    const int atlasHeight = packFrames(frames, atlasWidth, padding);
+    QImage atlas(atlasWidth, atlasHeight, QImage::Format_ARGB32);
+    atlas.fill(Qt::transparent);
+    {
+        QPainter painter(&atlas);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (const PackedFrame &frame : frames) {
+            painter.drawImage(frame.target.topLeft(), sheets[frame.sheet].image, frame.source);
+        }
+    }
+
+    QDir().mkpath(QFileInfo(args[3]).absolutePath());
+    if (!atlas.save(args[3], "PNG")) {
+        fail(QString("cannot write %1").arg(args[3]));
+        return 1;
+    }
+    if (!writeHeader(args[4], sheets, frames, atlas.size())) {
+        return 1;
+    }
+
+    std::printf("spritepack: %d sheets, %d frames -> %dx%d\n",
+                int(sheets.size()), int(frames.size()), atlas.width(), atlas.height());
+    return 0;
+}
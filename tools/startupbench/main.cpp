@@ -0,0 +1,154 @@
+// Сравнение времени до первого кадра двух сборок LCD_LABS.
+//   startupbench [--runs n] [--warmup n] [--platform name] [--qml-dir dir] <binary A> [binary B]
+// Каждая сборка запускается n раз поочерёдно с LCD_LABS_EXIT_AFTER_FIRST_FRAME=1
+// и QT_QPA_PLATFORM=offscreen; из вывода берётся строка "Time to first
+// frame", печатаются медианы. Без binary B сравнивается одна сборка с
+// --qml-dir (LCD_LABS_QML_DIR, загрузка QML с диска) и без него.
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <algorithm>
+#include <cstdio>
+
+struct Variant {
+    QString name;
+    QString binary;
+    QProcessEnvironment environment;
+    QList<qint64> firstFrameMs;
+    QList<qint64> exitMs;
+    int failures = 0;
+};
+
+static int fail(const QString &message)
+{
+    std::fprintf(stderr, "startupbench: %s\n", qPrintable(message));
+    return 1;
+}
+
+static double median(QList<qint64> values)
+{
+    if (values.isEmpty()) return 0;
+    std::sort(values.begin(), values.end());
+    const qsizetype middle = values.size() / 2;
+    return values.size() % 2 ? values.at(middle) : (values.at(middle - 1) + values.at(middle)) / 2.0;
+}
+
+// Один запуск: время до первого кадра по логу приложения (от начала main)
+// и время до выхода процесса снаружи (с загрузкой библиотек)
+static bool runOnce(const Variant &variant, int timeoutMs, qint64 &firstFrameMs, qint64 &exitMs, QString &error)
+{
+    static const QRegularExpression firstFrame("Time to first frame: (\\d+) ms");
+
+    QProcess process;
+    process.setProcessEnvironment(variant.environment);
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    QElapsedTimer timer;
+    timer.start();
+    process.start(variant.binary, QStringList());
+    if (!process.waitForStarted(timeoutMs)) {
+        error = process.errorString();
+        return false;
+    }
+    if (!process.waitForFinished(timeoutMs)) {
+        process.kill();
+        process.waitForFinished();
+        error = QString("no exit within %1 ms").arg(timeoutMs);
+        return false;
+    }
+    exitMs = timer.elapsed();
+
+    const QString output = QString::fromLocal8Bit(process.readAll());
+    const QRegularExpressionMatch match = firstFrame.match(output);
+    if (!match.hasMatch()) {
+        error = QString("no first frame line, exit code %1").arg(process.exitCode());
+        return false;
+    }
+    firstFrameMs = match.captured(1).toLongLong();
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("binary", "LCD_LABS build A, optionally build B");
+    parser.addOptions({
+        {"runs", "measured runs per build", "n", "10"},
+        {"warmup", "unmeasured runs per build first", "n", "1"},
+        {"platform", "QT_QPA_PLATFORM for the runs", "name", "offscreen"},
+        {"qml-dir", "single build: compare against LCD_LABS_QML_DIR=dir", "dir"},
+        {"timeout", "seconds per run", "s", "60"},
+    });
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.isEmpty() || args.size() > 2) parser.showHelp(1);
+    if (args.size() == 1 && !parser.isSet("qml-dir")) return fail("second binary or --qml-dir expected");
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("LCD_LABS_EXIT_AFTER_FIRST_FRAME", "1");
+    environment.insert("QT_QPA_PLATFORM", parser.value("platform"));
+    // Свой формат сообщений сломал бы разбор строки о первом кадре
+    environment.remove("QT_MESSAGE_PATTERN");
+    environment.remove("LCD_LABS_QML_DIR");
+
+    QList<Variant> variants(2);
+    for (int i = 0; i < 2; ++i) {
+        variants[i].binary = args.value(i, args.first());
+        variants[i].name = QFileInfo(variants[i].binary).fileName();
+        variants[i].environment = environment;
+    }
+    if (args.size() == 1) {
+        variants[0].name += " (compiled module)";
+        variants[1].name += " (filesystem QML)";
+        variants[1].environment.insert("LCD_LABS_QML_DIR", parser.value("qml-dir"));
+    } else if (variants[0].name == variants[1].name) {
+        variants[0].name = "A: " + variants[0].binary;
+        variants[1].name = "B: " + variants[1].binary;
+    }
+
+    const int runs = qMax(1, parser.value("runs").toInt());
+    const int warmup = qMax(0, parser.value("warmup").toInt());
+    const int timeoutMs = qMax(1, parser.value("timeout").toInt()) * 1000;
+
+    // Запуски чередуются, чтобы дрейф машины делился между сборками поровну
+    for (int run = 0; run < warmup + runs; ++run) {
+        for (Variant &variant : variants) {
+            qint64 firstFrameMs = 0, exitMs = 0;
+            QString error;
+            if (!runOnce(variant, timeoutMs, firstFrameMs, exitMs, error)) {
+                ++variant.failures;
+                std::fprintf(stderr, "%s: run %d failed: %s\n", qPrintable(variant.name), run + 1, qPrintable(error));
+                continue;
+            }
+            if (run < warmup) continue;
+            variant.firstFrameMs.append(firstFrameMs);
+            variant.exitMs.append(exitMs);
+            std::printf("%s: run %d: first frame %lld ms, exit %lld ms\n", qPrintable(variant.name),
+                        run - warmup + 1, firstFrameMs, exitMs);
+        }
+    }
+
+    std::printf("\n%-40s %8s %8s %8s %10s %6s\n", "build", "median", "min", "max", "exit med", "runs");
+    for (const Variant &variant : std::as_const(variants)) {
+        if (variant.firstFrameMs.isEmpty()) {
+            std::printf("%-40s no successful runs\n", qPrintable(variant.name));
+            continue;
+        }
+        std::printf("%-40s %8.1f %8lld %8lld %10.1f %6lld\n", qPrintable(variant.name), median(variant.firstFrameMs),
+                    *std::min_element(variant.firstFrameMs.cbegin(), variant.firstFrameMs.cend()),
+                    *std::max_element(variant.firstFrameMs.cbegin(), variant.firstFrameMs.cend()),
+                    median(variant.exitMs), qlonglong(variant.firstFrameMs.size()));
+    }
+    if (variants[0].firstFrameMs.isEmpty() || variants[1].firstFrameMs.isEmpty()) return 1;
+
+    const double a = median(variants[0].firstFrameMs);
+    const double b = median(variants[1].firstFrameMs);
+    std::printf("\nfirst frame median, B - A: %+.1f ms (%+.1f%%)\n", b - a, a > 0 ? (b - a) * 100 / a : 0.0);
+    return variants[0].failures + variants[1].failures ? 1 : 0;
+}